@@ -17,19 +17,23 @@
 #include <sstream>
 #include <string>
 #include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+#include "../../../common/partition.h"
 using namespace std;
 
 #define n 1024
 #define PRECISION 999 // ensure precision of 0.0001
 
-float M[n][n] = {0.0};
-float M_B[n][n] = {0.0}; // backup of matrix
+float (*M)[n];
+// float M_B[n][n] = {0.0}; // backup of matrix
 
 //===functions to do with matrix
 void initMatrix(float a[][n]);               // init matrix
 void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
 void printMatrix(float a[][n]);              // print matrix
-void readMatrix(float a[][n]);               // read matrix from file saved
+void readMatrix(float a[][n]);               // read matrix from binary file
 //===serial gauss elimination
 void gaussEliminationSerial(float a[][n]);
 //===gauss elimination implemented by MPI
@@ -48,29 +52,8 @@ int main(int argc, char *argv[])
 // init matirx
 void initMatrix(float a[][n])
 {
-    srand((unsigned)time(0));
-
-    // init matrix by random element in (-1,1)
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = i; j < n; j++)
-        {
-            float t = pow(-1, rand() % 2 + 1);
-            float temp = rand() % (PRECISION) / (double)(PRECISION);
-            a[i][j] = t * temp;
-        }
-    }
-
-    // random linear combination
-    for (int i = 0; i < n * 10; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
 }
 
 // deep copy a to b
@@ -123,43 +106,15 @@ void gaussEliminationSerial(float a[][n])
     }
 }
 
-// read matrix initialized from file taged by n
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
 void readMatrix(float a[][n])
 {
-    string matrixPath = "./" + to_string(n) + ".txt";
-    ifstream ifStream;
-    ifStream.open(matrixPath);
-    if (!ifStream)
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
     {
-        ifStream.close();
         initMatrix(a);
-        ofstream ofStream(matrixPath);
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                ofStream << a[i][j] << ' ';
-                // cout<<a[i][j]<<" ";
-            }
-            ofStream << endl;
-        }
-        ofStream.close();
-        ifStream.open(matrixPath);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
     }
-    int r = 0;
-    stringstream stringStream;
-    while (!ifStream.eof())
-    {
-        string line;
-        getline(ifStream, line);
-        stringStream << line;
-        for (int i = 0; i < n; i++)
-        {
-            stringStream >> a[r][i];
-        }
-        r++;
-    }
-    ifStream.close();
 }
 
 void gaussEliminationMPI(float a[][n], int argc, char *argv[])
@@ -169,10 +124,14 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     int r_start;           // start row of distributed task
     int r_end;             // end row of distributed task
     double s_time, e_time; // count time
+    float(*sub)[n];        // own rows r_start..r_end, row i is sub[i - r_start]
+    float *tmp;            // row k received from its owner
+    int *counts, *displs;  // elements of every processor's rows and where they start in a
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
 
     MPI_Status status;
 
@@ -181,73 +140,76 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
         s_time = MPI_Wtime();
     }
     // confirm task range of each processor
-    r_start = myid * (n / num) + ((myid < n % num) ? myid : n % num);
-    r_end = r_start + (n / num) + ((myid < n % num) ? 1 : 0) - 1;
-
-    // if rank = 0, init matrix and distribute task, else receive data from processor 0
+    r_start = partitionFirst(n, num, myid);
+    r_end = r_start + partitionRows(n, num, myid) - 1;
+    counts = new int[num];
+    displs = new int[num];
+    partitionCounts(n, num, n, counts, displs);
+    sub = new float[r_end - r_start + 1][n];
+    tmp = new float[n];
+
+    // every processor reads its own rows from the matrix file if there is one, or generates them
+    // only processor 0 holds the whole matrix
+    string matrixPath = "./" + to_string(n) + ".bin";
     if (myid == 0)
+        a = new float[n][n];
+    MPI_Barrier(MPI_COMM_WORLD);
     {
-        readMatrix(a);
-        for (int i = 1; i < num; i++)
-        {
-            int i_start = i * (n / num) + ((i < n % num) ? i : n % num);
-            int i_stride = (n / num) + ((i < n % num) ? 1 : 0);
-            MPI_Send(&a[i_start][0], i_stride * n, MPI_FLOAT, i, 0, MPI_COMM_WORLD);
-        }
-    }
-    else
-    {
-        MPI_Recv(&a[r_start][0], n * (r_end - r_start + 1), MPI_FLOAT, 0, 0, MPI_COMM_WORLD, &status);
+        TraceSpan span(PHASE_PARSE, (long long)(r_end - r_start + 1) * n * sizeof(float));
+        if (!matrixReadOrGenerateRows(MPI_COMM_WORLD, matrixPath.c_str(), matrixSeed(), n, r_start,
+                                      r_end - r_start + 1, r_end - r_start + 1, 1, &sub[0][0], r_end - r_start + 1))
+            MPI_Abort(MPI_COMM_WORLD, 1);
     }
     // MPI_Barrier(MPI_COMM_WORLD);
+    TraceSpan reduceSpan(PHASE_REDUCE);
     for (int k = 0; k < n; k++)
     {
+        float *pivot = tmp; // row k
         // corresponding processor does the division work and asks higher-ranked processors to do the elimination work together
         if (k >= r_start && k <= r_end)
         {
+            pivot = sub[k - r_start];
             for (int j = k + 1; j < n; j++)
             {
-                a[k][j] /= a[k][k];
+                pivot[j] /= pivot[k];
             }
-            a[k][k] = 1.0;
+            pivot[k] = 1.0;
+            TraceSpan span(PHASE_SEND, (long long)(num - myid - 1) * n * sizeof(float));
             for (int dest = myid + 1; dest < num; dest++)
             {
-                MPI_Send(&a[k][0], n, MPI_FLOAT, dest, 0, MPI_COMM_WORLD);
+                MPI_Send(pivot, n, MPI_FLOAT, dest, 0, MPI_COMM_WORLD);
             }
         }
         else
         {
             if (r_start > k)
             {
-                MPI_Recv(&a[k][0], n, MPI_FLOAT, MPI::ANY_SOURCE, 0, MPI_COMM_WORLD, &status);
+                TraceSpan span(PHASE_RECV, n * sizeof(float));
+                // from the owner of row k, rows of different owners may overtake each other
+                MPI_Recv(tmp, n, MPI_FLOAT, partitionOwner(n, num, k), 0, MPI_COMM_WORLD, &status);
             }
         }
         if (r_end > k)
         {
             for (int i = max(k + 1, r_start); i <= r_end; i++)
             {
+                float *row = sub[i - r_start];
                 for (int j = k + 1; j < n; j++)
                 {
-                    a[i][j] -= a[i][k] * a[k][j];
+                    row[j] -= row[k] * pivot[j];
                 }
-                a[i][k] = 0;
+                row[k] = 0;
             }
         }
     }
 
+    reduceSpan.end();
+
     // send back to processor 0
-    if (myid != 0)
     {
-        MPI_Send(&a[r_start][0], n * (r_end - r_start + 1), MPI_FLOAT, 0, myid, MPI_COMM_WORLD);
-    }
-    else
-    {
-        for (int i = 1; i < num; i++)
-        {
-            int i_start = i * (n / num) + ((i < n % num) ? i : n % num);
-            int i_stride = (n / num) + ((i < n % num) ? 1 : 0);
-            MPI_Recv(&a[i_start][0], n * i_stride, MPI_FLOAT, i, i, MPI_COMM_WORLD, &status);
-        }
+        TraceSpan span(PHASE_GATHER, (long long)(r_end - r_start + 1) * n * sizeof(float));
+        MPI_Gatherv(&sub[0][0], n * (r_end - r_start + 1), MPI_FLOAT, (float *)a, counts, displs, MPI_FLOAT, 0,
+                    MPI_COMM_WORLD);
     }
     MPI_Barrier(MPI_COMM_WORLD);
 
@@ -261,6 +223,12 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     {
         e_time = MPI_Wtime();
         cout << "time consuming: " << e_time - s_time << endl;
+        delete[] a;
     }
+    delete[] sub;
+    delete[] tmp;
+    delete[] counts;
+    delete[] displs;
+    traceFinish();
     MPI_Finalize();
 }
@@ -0,0 +1,293 @@
+/**
+ * @file v10.cpp
+ * @author NKCS_GKC (2012522@mail.nankai.edu.cn)
+ * @brief 1d row-looped distribution + partial pivoting
+ * @version 0.1
+ * @date 2022-07-10
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+using namespace std;
+
+#define n 1024 // for the convenience of programming, n is able to be divided by 16
+#define block_size 64
+#define PRECISION 999 // ensure precision of 0.0001
+
+float M[n][n] = {0.0};
+// float M_B[n][n] = {0.0}; // backup of matrix
+
+//===functions to do with matrix
+void initMatrix(float a[][n]);               // init matrix
+void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
+void printMatrix(float a[][n]);              // print matrix
+void readMatrix(float a[][n]);               // read matrix from binary file
+//===serial gauss elimination
+void gaussEliminationSerial(float a[][n]);
+//===gauss elimination implemented by MPI
+void gaussEliminationMPIPivot(float a[][n], int argc, char *argv[]);
+void permuteRows(float a[][n], int *perm); // move row perm[i] to row i
+
+int main(int argc, char *argv[])
+{
+    // initMatrix(M);
+    // readMatrix(M);
+    // printMatrix(M);
+    // gaussEliminationSerial(M);
+    gaussEliminationMPIPivot(M, argc, argv);
+    // printMatrix(M);
+}
+
+// init matirx
+void initMatrix(float a[][n])
+{
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
+}
+
+// deep copy a to b
+void copyMatrix(float a[][n], float b[][n])
+{
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            b[i][j] = a[i][j];
+        }
+    }
+}
+
+// print matrix
+void printMatrix(float a[][n])
+{
+    cout << "Printing Matrix, Lines " << n << endl;
+    for (int i = 0; i < n; i++)
+    {
+        cout << "Line " << i << " : ";
+        for (int j = 0; j < n; j++)
+        {
+            cout << a[i][j] << " ";
+        }
+        cout << endl;
+    }
+    cout << endl;
+}
+
+// serial gauss elimination
+void gaussEliminationSerial(float a[][n])
+{
+    for (int k = 0; k < n; k++)
+    {
+        for (int j = k + 1; j < n; j++)
+        {
+            a[k][j] /= a[k][k];
+        }
+        a[k][k] = 1.0;
+
+        for (int i = k + 1; i < n; i++)
+        {
+            for (int j = k + 1; j < n; j++)
+            {
+                a[i][j] -= a[i][k] * a[k][j];
+            }
+            a[i][k] = 0;
+        }
+    }
+}
+
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
+void readMatrix(float a[][n])
+{
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
+    {
+        initMatrix(a);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
+    }
+}
+
+// move row perm[i] to row i, every row is moved once along the cycles of perm
+void permuteRows(float a[][n], int *perm)
+{
+    bool *placed = new bool[n]{false};
+    float *tmp = new float[n];
+    for (int i = 0; i < n; i++)
+    {
+        if (placed[i] || perm[i] == i)
+            continue;
+        copy(a[i], a[i] + n, tmp);
+        int j = i;
+        while (perm[j] != i)
+        {
+            copy(a[perm[j]], a[perm[j]] + n, a[j]);
+            placed[j] = true;
+            j = perm[j];
+        }
+        copy(tmp, tmp + n, a[j]);
+        placed[j] = true;
+    }
+    delete[] placed;
+    delete[] tmp;
+}
+
+void gaussEliminationMPIPivot(float a[][n], int argc, char *argv[])
+{
+    int myid;              // rank of current processor
+    int num;               // numbers of processors
+    double s_time = 0;     // start time, taken on processor 0
+    double e_time;         // end time
+    int *perm;             // k-th pivot is row perm[k]
+    bool *used;            // whether a row has been a pivot
+    float *colAbs;         // |a[i][k]| of own rows at step k, -1 for rows of others and used rows
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Comm_size(MPI_COMM_WORLD, &num);
+    if (n % (block_size * num) != 0) // V and the row-cyclic loops need the same number of whole blocks everywhere
+    {
+        if (myid == 0)
+        {
+            cerr << "n = " << n << " is not a multiple of block_size * processors = " << block_size * num << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        MPI_Barrier(MPI_COMM_WORLD); // ended by the abort of processor 0
+    }
+    traceInit();
+    MPI_Status status;
+    MPI_Datatype V;
+
+    MPI_Type_vector(n / block_size / num, block_size * n, num * block_size * n, MPI_FLOAT, &V);
+    MPI_Type_commit(&V);
+
+    // every processor reads its own row blocks from the matrix file if there is one, or generates them
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (myid == 0)
+        s_time = MPI_Wtime();
+    {
+        TraceSpan span(PHASE_PARSE, (long long)(n / num) * n * sizeof(float));
+        if (!matrixReadOrGenerateRows(MPI_COMM_WORLD, matrixPath.c_str(), matrixSeed(), n, myid * block_size,
+                                      block_size, num * block_size, n / block_size / num, &a[myid * block_size][0],
+                                      num * block_size))
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    // rows are not swapped, the pivot row stays at its owner and only its index is recorded,
+    // so no row moves between processors except the broadcast every step does anyway
+    perm = new int[n];
+    used = new bool[n]{false};
+    colAbs = new float[n];
+    for (int i = 0; i < n; i++)
+    {
+        colAbs[i] = (i / block_size % num == myid) ? fabs(a[i][0]) : -1;
+    }
+
+    TraceSpan reduceSpan(PHASE_REDUCE);
+    for (int k = 0; k < n; k++)
+    {
+        // each processor finds the largest of its own rows, MPI_MAXLOC picks the global one
+        struct
+        {
+            float value;
+            int row;
+        } local = {-1, -1}, global;
+        for (int i = myid * block_size; i < n; i += num * block_size)
+        {
+            for (int r = i; r < i + block_size; r++)
+            {
+                if (colAbs[r] > local.value)
+                {
+                    local.value = colAbs[r];
+                    local.row = r;
+                }
+            }
+        }
+        {
+            TraceSpan span(PHASE_ALLREDUCE, sizeof(local));
+            MPI_Allreduce(&local, &global, 1, MPI_FLOAT_INT, MPI_MAXLOC, MPI_COMM_WORLD);
+        }
+        int p = global.row;
+        int root = p / block_size % num; // find the processor having pivot row
+        perm[k] = p;
+        used[p] = true;
+        colAbs[p] = -1;
+
+        if (myid == root)
+        {
+            for (int j = k + 1; j < n; j++)
+            {
+                a[p][j] /= a[p][k];
+            }
+            a[p][k] = 1;
+        }
+        {
+            TraceSpan span(PHASE_BCAST, (n - k) * sizeof(float));
+            MPI_Bcast(&a[p][k], n - k, MPI_FLOAT, root, MPI_COMM_WORLD);
+        }
+
+        // eliminate own rows which have not been pivots
+        for (int i = myid * block_size; i < n; i += num * block_size)
+        {
+            for (int r = i; r < i + block_size; r++)
+            {
+                if (used[r])
+                    continue;
+                for (int j = k + 1; j < n; j++)
+                {
+                    a[r][j] -= a[r][k] * a[p][j];
+                }
+                a[r][k] = 0;
+                if (k + 1 < n)
+                    colAbs[r] = fabs(a[r][k + 1]);
+            }
+        }
+    }
+    reduceSpan.end();
+
+    // send back to processor 0
+    if (myid != 0)
+    {
+        TraceSpan span(PHASE_GATHER, (long long)(n / num) * n * sizeof(float));
+        MPI_Send(&a[myid * block_size][0], 1, V, 0, myid, MPI_COMM_WORLD);
+    }
+    else
+    {
+        TraceSpan span(PHASE_GATHER, (long long)(num - 1) * (n / num) * n * sizeof(float));
+        for (int i = 1; i < num; i++)
+        {
+            int i_start = i * block_size;
+            MPI_Recv(&a[i_start][0], 1, V, i, i, MPI_COMM_WORLD, &status);
+        }
+        // k-th row of result is the k-th pivot
+        permuteRows(a, perm);
+    }
+    // if (myid == 0)
+    // {
+    //     printMatrix(a);
+    // }
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (myid == 0)
+    {
+        e_time = MPI_Wtime();
+        cout << "time consuming: " << e_time - s_time << endl;
+    }
+    delete[] perm;
+    delete[] used;
+    delete[] colAbs;
+    MPI_Type_free(&V);
+    traceFinish();
+    MPI_Finalize();
+}
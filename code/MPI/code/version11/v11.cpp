@@ -0,0 +1,316 @@
+/**
+ * @file v11.cpp
+ * @author NKCS_GKC (2012522@mail.nankai.edu.cn)
+ * @brief 2d block-cyclic distribution over a cartesian process grid
+ * @version 0.1
+ * @date 2022-07-16
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+using namespace std;
+
+#define n 1024 // for the convenience of programming, n is able to be divided by 16
+#define block_size 64
+#define PRECISION 999 // ensure precision of 0.0001
+
+float M[n][n] = {0.0};
+// float M_B[n][n] = {0.0}; // backup of matrix
+
+//===functions to do with matrix
+void initMatrix(float a[][n]);               // init matrix
+void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
+void printMatrix(float a[][n]);              // print matrix
+void readMatrix(float a[][n]);               // read matrix from binary file
+//===serial gauss elimination
+void gaussEliminationSerial(float a[][n]);
+//===gauss elimination implemented by MPI
+void gaussEliminationMPI2D(float a[][n], int argc, char *argv[]);
+
+int main(int argc, char *argv[])
+{
+    // initMatrix(M);
+    // readMatrix(M);
+    // printMatrix(M);
+    // gaussEliminationSerial(M);
+    gaussEliminationMPI2D(M, argc, argv);
+    // printMatrix(M);
+}
+
+// init matirx
+void initMatrix(float a[][n])
+{
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
+}
+
+// deep copy a to b
+void copyMatrix(float a[][n], float b[][n])
+{
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            b[i][j] = a[i][j];
+        }
+    }
+}
+
+// print matrix
+void printMatrix(float a[][n])
+{
+    cout << "Printing Matrix, Lines " << n << endl;
+    for (int i = 0; i < n; i++)
+    {
+        cout << "Line " << i << " : ";
+        for (int j = 0; j < n; j++)
+        {
+            cout << a[i][j] << " ";
+        }
+        cout << endl;
+    }
+    cout << endl;
+}
+
+// serial gauss elimination
+void gaussEliminationSerial(float a[][n])
+{
+    for (int k = 0; k < n; k++)
+    {
+        for (int j = k + 1; j < n; j++)
+        {
+            a[k][j] /= a[k][k];
+        }
+        a[k][k] = 1.0;
+
+        for (int i = k + 1; i < n; i++)
+        {
+            for (int j = k + 1; j < n; j++)
+            {
+                a[i][j] -= a[i][k] * a[k][j];
+            }
+            a[i][k] = 0;
+        }
+    }
+}
+
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
+void readMatrix(float a[][n])
+{
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
+    {
+        initMatrix(a);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
+    }
+}
+
+// block (I, J) of block_size x block_size elements belongs to the processor at (I % P, J % Q) of a P x Q grid,
+// so a processor keeps n/P rows and n/Q columns of every block row and column it meets. at step k only the processor
+// row holding row k and the processor column holding column k send: segments of the pivot row go down processor
+// columns and multipliers go along processor rows, n/P + n/Q floats per processor instead of a full row of n
+void gaussEliminationMPI2D(float a[][n], int argc, char *argv[])
+{
+    int myid;              // rank of current processor
+    int num;               // numbers of processors
+    double s_time = 0;     // start time, taken on processor 0
+    double e_time;         // end time
+    int dims[2] = {0, 0};  // P x Q
+    int periods[2] = {0, 0};
+    int coords[2];         // (processor row, processor column) of current processor
+    MPI_Comm gridComm;     // P x Q cartesian grid
+    MPI_Comm rowComm;      // processors of the same processor row, ranked by processor column
+    MPI_Comm colComm;      // processors of the same processor column, ranked by processor row
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &num);
+    MPI_Dims_create(num, 2, dims);
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &gridComm);
+    MPI_Comm_rank(gridComm, &myid);
+    MPI_Cart_coords(gridComm, myid, 2, coords);
+    int keepCols[2] = {0, 1}, keepRows[2] = {1, 0};
+    MPI_Cart_sub(gridComm, keepCols, &rowComm);
+    MPI_Cart_sub(gridComm, keepRows, &colComm);
+    traceInit();
+    const int P = dims[0], Q = dims[1];
+    const int myRow = coords[0], myCol = coords[1];
+    const int blocks = n / block_size; // blocks per row and per column
+    MPI_Status status;
+    MPI_Datatype B;
+
+    MPI_Type_vector(block_size, block_size, n, MPI_FLOAT, &B); // one block
+    MPI_Type_commit(&B);
+
+    // if rank = 0, init matrix and send every block to its owner, else receive own blocks from processor 0
+    if (myid == 0)
+    {
+        {
+            TraceSpan span(PHASE_PARSE);
+            readMatrix(a);
+        }
+        s_time = MPI_Wtime();
+        TraceSpan span(PHASE_SCATTER, (long long)n * n * (num - 1) / num * sizeof(float));
+        for (int I = 0; I < blocks; I++)
+        {
+            for (int J = 0; J < blocks; J++)
+            {
+                int owner, ownerCoords[2] = {I % P, J % Q};
+                MPI_Cart_rank(gridComm, ownerCoords, &owner);
+                if (owner != 0)
+                    MPI_Send(&a[I * block_size][J * block_size], 1, B, owner, 0, gridComm);
+            }
+        }
+    }
+    else
+    {
+        TraceSpan span(PHASE_SCATTER, (long long)n * n / num * sizeof(float));
+        for (int I = myRow; I < blocks; I += P)
+        {
+            for (int J = myCol; J < blocks; J += Q)
+            {
+                MPI_Recv(&a[I * block_size][J * block_size], 1, B, 0, 0, gridComm, &status);
+            }
+        }
+    }
+
+    vector<int> myRows, myCols; // own rows and columns in increasing order
+    for (int I = myRow; I < blocks; I += P)
+    {
+        for (int i = I * block_size; i < (I + 1) * block_size; i++)
+            myRows.push_back(i);
+    }
+    for (int J = myCol; J < blocks; J += Q)
+    {
+        for (int j = J * block_size; j < (J + 1) * block_size; j++)
+            myCols.push_back(j);
+    }
+    vector<float> buffer(max(myRows.size(), myCols.size()) + 1); // packed segment of a row or a column
+
+    TraceSpan reduceSpan(PHASE_REDUCE);
+    int firstRow = 0, firstCol = 0; // first own row and column > k in myRows and myCols
+    for (int k = 0; k < n; k++)
+    {
+        int rootRow = k / block_size % P; // processor row having k-th row
+        int rootCol = k / block_size % Q; // processor column having k-th column
+        while (firstRow < (int)myRows.size() && myRows[firstRow] <= k)
+            firstRow++;
+        while (firstCol < (int)myCols.size() && myCols[firstCol] <= k)
+            firstCol++;
+        int rowCount = myRows.size() - firstRow; // own rows below k
+        int colCount = myCols.size() - firstCol; // own columns right of k
+
+        // processor row of k-th row divides it, a[k][k] comes along the processor row from its owner
+        if (myRow == rootRow)
+        {
+            float pivot = a[k][k];
+            {
+                TraceSpan span(PHASE_BCAST, sizeof(float));
+                MPI_Bcast(&pivot, 1, MPI_FLOAT, rootCol, rowComm);
+            }
+            for (int c = firstCol; c < (int)myCols.size(); c++)
+            {
+                a[k][myCols[c]] /= pivot;
+            }
+            if (myCol == rootCol)
+                a[k][k] = 1;
+        }
+
+        // segment of the pivot row of own columns goes down the processor column
+        if (myRow == rootRow)
+        {
+            for (int c = 0; c < colCount; c++)
+                buffer[c] = a[k][myCols[firstCol + c]];
+        }
+        {
+            TraceSpan span(PHASE_BCAST, colCount * sizeof(float));
+            MPI_Bcast(buffer.data(), colCount, MPI_FLOAT, rootRow, colComm);
+        }
+        if (myRow != rootRow)
+        {
+            for (int c = 0; c < colCount; c++)
+                a[k][myCols[firstCol + c]] = buffer[c];
+        }
+
+        // multipliers of own rows go along the processor row
+        if (myCol == rootCol)
+        {
+            for (int r = 0; r < rowCount; r++)
+                buffer[r] = a[myRows[firstRow + r]][k];
+        }
+        {
+            TraceSpan span(PHASE_BCAST, rowCount * sizeof(float));
+            MPI_Bcast(buffer.data(), rowCount, MPI_FLOAT, rootCol, rowComm);
+        }
+
+        // eliminate own blocks, a[k][j] of own columns is the pivot row and buffer[r] the multiplier of row r
+        for (int r = 0; r < rowCount; r++)
+        {
+            int i = myRows[firstRow + r];
+            float aik = buffer[r];
+            for (int c = firstCol; c < (int)myCols.size(); c++)
+            {
+                int j = myCols[c];
+                a[i][j] -= aik * a[k][j];
+            }
+            if (myCol == rootCol)
+                a[i][k] = 0;
+        }
+    }
+    reduceSpan.end();
+
+    // send own blocks back to processor 0
+    if (myid != 0)
+    {
+        TraceSpan span(PHASE_GATHER, (long long)n * n / num * sizeof(float));
+        for (int I = myRow; I < blocks; I += P)
+        {
+            for (int J = myCol; J < blocks; J += Q)
+            {
+                MPI_Send(&a[I * block_size][J * block_size], 1, B, 0, 0, gridComm);
+            }
+        }
+    }
+    else
+    {
+        TraceSpan span(PHASE_GATHER, (long long)n * n * (num - 1) / num * sizeof(float));
+        for (int I = 0; I < blocks; I++)
+        {
+            for (int J = 0; J < blocks; J++)
+            {
+                int owner, ownerCoords[2] = {I % P, J % Q};
+                MPI_Cart_rank(gridComm, ownerCoords, &owner);
+                if (owner != 0)
+                    MPI_Recv(&a[I * block_size][J * block_size], 1, B, owner, 0, gridComm, &status);
+            }
+        }
+    }
+    // if (myid == 0)
+    // {
+    //     printMatrix(a);
+    // }
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (myid == 0)
+    {
+        e_time = MPI_Wtime();
+        cout << "time consuming: " << e_time - s_time << endl;
+    }
+    MPI_Type_free(&B);
+    MPI_Comm_free(&rowComm);
+    MPI_Comm_free(&colComm);
+    MPI_Comm_free(&gridComm);
+    traceFinish();
+    MPI_Finalize();
+}
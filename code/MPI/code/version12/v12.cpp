@@ -0,0 +1,252 @@
+/**
+ * @file v12.cpp
+ * @author NKCS_GKC (2012522@mail.nankai.edu.cn)
+ * @brief 1d row-looped distribution + look-ahead broadcast
+ * @version 0.1
+ * @date 2022-07-17
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+using namespace std;
+
+#define n 1024 // for the convenience of programming, n is able to be divided by 16
+#define block_size 64
+#define PRECISION 999 // ensure precision of 0.0001
+
+float M[n][n] = {0.0};
+// float M_B[n][n] = {0.0}; // backup of matrix
+
+//===functions to do with matrix
+void initMatrix(float a[][n]);               // init matrix
+void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
+void printMatrix(float a[][n]);              // print matrix
+void readMatrix(float a[][n]);               // read matrix from binary file
+//===serial gauss elimination
+void gaussEliminationSerial(float a[][n]);
+//===gauss elimination implemented by MPI
+void gaussEliminationMPILookahead(float a[][n], int argc, char *argv[]);
+
+int main(int argc, char *argv[])
+{
+    // initMatrix(M);
+    // readMatrix(M);
+    // printMatrix(M);
+    // gaussEliminationSerial(M);
+    gaussEliminationMPILookahead(M, argc, argv);
+    // printMatrix(M);
+}
+
+// init matirx
+void initMatrix(float a[][n])
+{
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
+}
+
+// deep copy a to b
+void copyMatrix(float a[][n], float b[][n])
+{
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            b[i][j] = a[i][j];
+        }
+    }
+}
+
+// print matrix
+void printMatrix(float a[][n])
+{
+    cout << "Printing Matrix, Lines " << n << endl;
+    for (int i = 0; i < n; i++)
+    {
+        cout << "Line " << i << " : ";
+        for (int j = 0; j < n; j++)
+        {
+            cout << a[i][j] << " ";
+        }
+        cout << endl;
+    }
+    cout << endl;
+}
+
+// serial gauss elimination
+void gaussEliminationSerial(float a[][n])
+{
+    for (int k = 0; k < n; k++)
+    {
+        for (int j = k + 1; j < n; j++)
+        {
+            a[k][j] /= a[k][k];
+        }
+        a[k][k] = 1.0;
+
+        for (int i = k + 1; i < n; i++)
+        {
+            for (int j = k + 1; j < n; j++)
+            {
+                a[i][j] -= a[i][k] * a[k][j];
+            }
+            a[i][k] = 0;
+        }
+    }
+}
+
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
+void readMatrix(float a[][n])
+{
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
+    {
+        initMatrix(a);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
+    }
+}
+
+// rows are distributed as in v2. the owner of row k + 1 updates and divides it before its other rows of step k and
+// starts a nonblocking broadcast of it, the rest of step k hides the broadcast, so nobody waits for the pivot row
+// unless the broadcast took longer than a whole step of updates
+void gaussEliminationMPILookahead(float a[][n], int argc, char *argv[])
+{
+    int myid;              // rank of current processor
+    int num;               // numbers of processors
+    double s_time = 0;     // start time, taken on processor 0
+    double e_time;         // end time
+    MPI_Request bcast;     // broadcast of the next pivot row
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Comm_size(MPI_COMM_WORLD, &num);
+    if (n % (block_size * num) != 0) // V and the row-cyclic loops need the same number of whole blocks everywhere
+    {
+        if (myid == 0)
+        {
+            cerr << "n = " << n << " is not a multiple of block_size * processors = " << block_size * num << endl;
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        MPI_Barrier(MPI_COMM_WORLD); // ended by the abort of processor 0
+    }
+    traceInit();
+    MPI_Status status;
+    MPI_Datatype V;
+
+    MPI_Type_vector(n / block_size / num, block_size * n, num * block_size * n, MPI_FLOAT, &V);
+    MPI_Type_commit(&V);
+
+    // every processor reads its own row blocks from the matrix file if there is one, or generates them
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (myid == 0)
+        s_time = MPI_Wtime();
+    {
+        TraceSpan span(PHASE_PARSE, (long long)(n / num) * n * sizeof(float));
+        if (!matrixReadOrGenerateRows(MPI_COMM_WORLD, matrixPath.c_str(), matrixSeed(), n, myid * block_size,
+                                      block_size, num * block_size, n / block_size / num, &a[myid * block_size][0],
+                                      num * block_size))
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    TraceSpan reduceSpan(PHASE_REDUCE);
+    // row 0 needs no update, its owner divides it at once
+    if (myid == 0)
+    {
+        for (int j = 1; j < n; j++)
+        {
+            a[0][j] /= a[0][0];
+        }
+        a[0][0] = 1;
+    }
+    MPI_Ibcast(&a[0][0], n, MPI_FLOAT, 0, MPI_COMM_WORLD, &bcast);
+
+    for (int k = 0; k < n; k++)
+    {
+        {
+            TraceSpan span(PHASE_BCAST, n * sizeof(float));
+            MPI_Wait(&bcast, MPI_STATUS_IGNORE); // k-th row arrived
+        }
+
+        // look ahead: owner of row k + 1 finishes it first and starts its broadcast
+        int first = k + 1; // first row of step k not updated yet
+        if (k + 1 < n)
+        {
+            int next = (k + 1) / block_size % num; // find the processor having (k+1)th row
+            if (myid == next)
+            {
+                for (int j = k + 1; j < n; j++)
+                {
+                    a[k + 1][j] -= a[k + 1][k] * a[k][j];
+                }
+                a[k + 1][k] = 0;
+                for (int j = k + 2; j < n; j++)
+                {
+                    a[k + 1][j] /= a[k + 1][k + 1];
+                }
+                a[k + 1][k + 1] = 1;
+                first = k + 2;
+            }
+            MPI_Ibcast(&a[k + 1][k + 1], n - k - 1, MPI_FLOAT, next, MPI_COMM_WORLD, &bcast);
+        }
+
+        // remaining own rows of step k, the broadcast moves on between blocks
+        int flag;
+        for (int r = first / block_size * block_size; r < n; r += block_size)
+        {
+            if (r / block_size % num != myid)
+                continue;
+            for (int i = max(r, first); i < r + block_size; i++)
+            {
+                for (int j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
+            }
+            if (k + 1 < n)
+                MPI_Test(&bcast, &flag, MPI_STATUS_IGNORE);
+        }
+    }
+    reduceSpan.end();
+
+    // send back to processor 0
+    if (myid != 0)
+    {
+        TraceSpan span(PHASE_GATHER, (long long)(n / num) * n * sizeof(float));
+        MPI_Send(&a[myid * block_size][0], 1, V, 0, myid, MPI_COMM_WORLD);
+    }
+    else
+    {
+        TraceSpan span(PHASE_GATHER, (long long)(num - 1) * (n / num) * n * sizeof(float));
+        for (int i = 1; i < num; i++)
+        {
+            int i_start = i * block_size;
+            MPI_Recv(&a[i_start][0], 1, V, i, i, MPI_COMM_WORLD, &status);
+        }
+    }
+    // if (myid == 0)
+    // {
+    //     printMatrix(a);
+    // }
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (myid == 0)
+    {
+        e_time = MPI_Wtime();
+        cout << "time consuming: " << e_time - s_time << endl;
+    }
+    MPI_Type_free(&V);
+    traceFinish();
+    MPI_Finalize();
+}
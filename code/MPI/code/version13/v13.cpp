@@ -0,0 +1,344 @@
+/**
+ * @file v13.cpp
+ * @author NKCS_GKC (2012522@mail.nankai.edu.cn)
+ * @brief pipeline gauss elimination with persistent requests, double buffered rows and chain or tree forwarding
+ * @version 0.1
+ * @date 2022-07-18
+ *
+ * @copyright Copyright (c) 2022
+ *
+ */
+
+#include <iostream>
+#include <math.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+#include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+#include "../../../common/partition.h"
+using namespace std;
+
+#define n 1024
+#define PRECISION 999     // ensure precision of 0.0001
+#define PIPE_BUFFERS 2    // row buffers in flight, receiving row k + 1 while eliminating with row k
+#define TREE_MIN_RANKS 5  // rows are forwarded along a binary tree from this many processors, along a chain below
+                          // environment variable PIPELINE_TREE=0 or 1 forces chain or tree
+
+float (*M)[n];
+// float M_B[n][n] = {0.0}; // backup of matrix
+
+//===functions to do with matrix
+void initMatrix(float a[][n]);               // init matrix
+void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
+void printMatrix(float a[][n]);              // print matrix
+void readMatrix(float a[][n]);               // read matrix from binary file
+//===serial gauss elimination
+void gaussEliminationSerial(float a[][n]);
+//===gauss elimination implemented by MPI
+void gaussEliminationMPIPipeline(float a[][n], int argc, char *argv[]);
+
+int main(int argc, char *argv[])
+{
+    // initMatrix(M);
+    // readMatrix(M);
+    // printMatrix(M);
+    // gaussEliminationSerial(M);
+    gaussEliminationMPIPipeline(M, argc, argv);
+    // printMatrix(M);
+}
+
+// init matirx
+void initMatrix(float (*a)[n])
+{
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
+}
+
+// deep copy a to b
+void copyMatrix(float a[][n], float b[][n])
+{
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            b[i][j] = a[i][j];
+        }
+    }
+}
+
+// print matrix
+void printMatrix(float (*a)[n])
+{
+    cout << "Printing Matrix, Lines " << n << endl;
+    for (int i = 0; i < n; i++)
+    {
+        cout << "Line " << i << " : ";
+        for (int j = 0; j < n; j++)
+        {
+            cout << a[i][j] << " ";
+        }
+        cout << endl;
+    }
+    cout << endl;
+}
+
+// serial gauss elimination
+void gaussEliminationSerial(float (*a)[n])
+{
+    for (int k = 0; k < n; k++)
+    {
+        for (int j = k + 1; j < n; j++)
+        {
+            a[k][j] /= a[k][k];
+        }
+        a[k][k] = 1.0;
+
+        for (int i = k + 1; i < n; i++)
+        {
+            for (int j = k + 1; j < n; j++)
+            {
+                a[i][j] -= a[i][k] * a[k][j];
+            }
+            a[i][k] = 0;
+        }
+    }
+}
+
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
+void readMatrix(float (*a)[n])
+{
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
+    {
+        initMatrix(a);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
+    }
+}
+
+// processors a row of owner o passes on its way to o + 1, ..., num - 1
+// chain: every processor receives from the previous one and forwards to the next one, num - o - 1 hops
+// tree:  processor o + x receives from o + (x - 1) / 2 and forwards to o + 2x + 1 and o + 2x + 2, log2(num - o) hops
+void pipelineLinks(int o, int myid, int num, bool tree, int &parent, int *children, int &childCount)
+{
+    int x = myid - o; // position below the owner
+    childCount = 0;
+    if (tree)
+    {
+        parent = x > 0 ? o + (x - 1) / 2 : MPI_PROC_NULL;
+        for (int c = 2 * x + 1; c <= 2 * x + 2; c++)
+        {
+            if (o + c < num)
+                children[childCount++] = o + c;
+        }
+    }
+    else
+    {
+        parent = x > 0 ? myid - 1 : MPI_PROC_NULL;
+        if (myid + 1 < num)
+            children[childCount++] = myid + 1;
+    }
+}
+
+void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
+{
+    int myid;              // rank of current processor
+    int num;               // numbers of processors
+    double s_time = 0;     // start time, taken on processor 0
+    double e_time;         // end time
+    float(*sub)[n];        // submatrix of each processor in 1d
+    float(*buf)[n];        // PIPE_BUFFERS rows received or sent
+    int np;                // submatrix size of each processor
+    int first;             // global index of the first row of submatrix
+    int *counts, *displs;  // elements of every processor's rows and where they start in a
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
+    MPI_Request recvReq[PIPE_BUFFERS];    // receive of every buffer from parent
+    MPI_Request sendReq[PIPE_BUFFERS][2]; // send of every buffer to each child
+
+    // PIPELINE_TREE=0 or 1 overrides the choice by number of processors
+    const char *treeEnv = getenv("PIPELINE_TREE");
+    bool tree = treeEnv != nullptr && *treeEnv != '\0' ? atoi(treeEnv) != 0 : num >= TREE_MIN_RANKS;
+
+    np = partitionRows(n, num, myid); // lines of submatrix, the first n % num processors take one more
+    first = partitionFirst(n, num, myid);
+    counts = new int[num];
+    displs = new int[num];
+    partitionCounts(n, num, n, counts, displs);
+    if (myid == 0)
+        a = new float[n][n];          // whole matrix only where it is read and collected
+    sub = new float[np][n];           // store tmp result during computation
+    buf = new float[PIPE_BUFFERS][n]; // store rows k, k + 1, ... during computation
+
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (myid == 0)
+    {
+        s_time = MPI_Wtime();
+        cout << "forwarding: " << (tree ? "tree" : "chain") << endl;
+    }
+
+    // every processor reads its own rows from the matrix file if there is one, or generates them,
+    // nothing is scattered
+    {
+        TraceSpan span(PHASE_PARSE, (long long)n * np * sizeof(float));
+        if (!matrixReadOrGenerateRows(MPI_COMM_WORLD, matrixPath.c_str(), matrixSeed(), n, first, np, np, 1,
+                                      &sub[0][0], np))
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    TraceSpan reduceSpan(PHASE_REDUCE);
+
+    // rows of processor o are eliminated in phase o, later processors need none of this processor
+    for (int o = 0; o <= myid; o++)
+    {
+        int parent, children[2], childCount;
+        pipelineLinks(o, myid, num, tree, parent, children, childCount);
+
+        // requests are built once per phase and restarted for every row
+        for (int b = 0; b < PIPE_BUFFERS; b++)
+        {
+            MPI_Recv_init(buf[b], n, MPI_FLOAT, parent, o, MPI_COMM_WORLD, &recvReq[b]);
+            for (int c = 0; c < childCount; c++)
+            {
+                MPI_Send_init(buf[b], n, MPI_FLOAT, children[c], o, MPI_COMM_WORLD, &sendReq[b][c]);
+            }
+        }
+
+        if (o < myid)
+        {
+            int rows = counts[o] / n; // rows of processor o
+            int base = displs[o] / n; // global index of the first of them
+
+            // prepost receives of the first rows
+            for (int b = 0; b < PIPE_BUFFERS && b < rows; b++)
+            {
+                MPI_Start(&recvReq[b]);
+            }
+            for (int t = 0; t < rows; t++)
+            {
+                int b = t % PIPE_BUFFERS;
+                int k = base + t;
+                {
+                    TraceSpan span(PHASE_RECV, n * sizeof(float));
+                    MPI_Wait(&recvReq[b], MPI_STATUS_IGNORE);
+                }
+                // forward row k while eliminating with it, row k + 1 arrives in the other buffer meanwhile
+                if (childCount > 0)
+                {
+                    TraceSpan span(PHASE_SEND, (long long)childCount * n * sizeof(float));
+                    MPI_Startall(childCount, sendReq[b]);
+                }
+
+                // eliminate individually
+                for (int row = 0; row < np; row++)
+                {
+                    for (int j = k + 1; j < n; j++)
+                    {
+                        sub[row][j] -= sub[row][k] * buf[b][j];
+                    }
+                    sub[row][k] = 0;
+                }
+
+                // buffer b is free again once row k left it
+                if (childCount > 0)
+                {
+                    TraceSpan span(PHASE_SEND);
+                    MPI_Waitall(childCount, sendReq[b], MPI_STATUSES_IGNORE);
+                }
+                if (t + PIPE_BUFFERS < rows)
+                    MPI_Start(&recvReq[b]);
+            }
+        }
+        else
+        {
+            for (int t = 0; t < np; t++)
+            {
+                int b = t % PIPE_BUFFERS;
+                int k = first + t;
+
+                // calculation first
+                for (int j = k + 1; j < n; j++)
+                {
+                    sub[t][j] = sub[t][j] / sub[t][k];
+                }
+                sub[t][k] = 1;
+
+                // buffer b still holds row k - PIPE_BUFFERS until its sends are done
+                if (childCount > 0 && t >= PIPE_BUFFERS)
+                {
+                    TraceSpan span(PHASE_SEND);
+                    MPI_Waitall(childCount, sendReq[b], MPI_STATUSES_IGNORE);
+                }
+                if (childCount > 0)
+                {
+                    TraceSpan span(PHASE_SEND, (long long)childCount * n * sizeof(float));
+                    copy(sub[t], sub[t] + n, buf[b]);
+                    MPI_Startall(childCount, sendReq[b]);
+                }
+
+                // eliminate individually
+                for (int i = t + 1; i < np; i++)
+                {
+                    for (int j = k + 1; j < n; j++)
+                    {
+                        sub[i][j] -= sub[i][k] * sub[t][j];
+                    }
+                    sub[i][k] = 0;
+                }
+            }
+            for (int b = 0; b < PIPE_BUFFERS && b < np && childCount > 0; b++)
+            {
+                TraceSpan span(PHASE_SEND);
+                MPI_Waitall(childCount, sendReq[b], MPI_STATUSES_IGNORE);
+            }
+        }
+
+        for (int b = 0; b < PIPE_BUFFERS; b++)
+        {
+            MPI_Request_free(&recvReq[b]);
+            for (int c = 0; c < childCount; c++)
+            {
+                MPI_Request_free(&sendReq[b][c]);
+            }
+        }
+    }
+
+    reduceSpan.end();
+
+    // Synchronize and gather rows
+    {
+        TraceSpan span(PHASE_GATHER, (long long)n * np * sizeof(float));
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Gatherv(&sub[0][0], n * np, MPI_FLOAT, (float *)a, counts, displs, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    }
+
+    // // to correct result
+    // if (myid == 0)
+    // {
+    //     printMatrix(a);
+    // }
+
+    if (myid == 0)
+    {
+        e_time = MPI_Wtime();
+        cout << "time consuming: " << e_time - s_time << endl;
+    }
+
+    if (myid == 0)
+        delete[] a;
+    delete[] sub;
+    delete[] buf;
+    delete[] counts;
+    delete[] displs;
+    traceFinish();
+    MPI_Finalize();
+}
@@ -17,6 +17,9 @@
 #include <sstream>
 #include <string>
 #include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
 using namespace std;
 
 #define n 1024 // for the convenience of programming, n is able to be divided by 16
@@ -24,13 +27,13 @@ using namespace std;
 #define PRECISION 999 // ensure precision of 0.0001
 
 float M[n][n] = {0.0};
-float M_B[n][n] = {0.0}; // backup of matrix
+// float M_B[n][n] = {0.0}; // backup of matrix
 
 //===functions to do with matrix
 void initMatrix(float a[][n]);               // init matrix
 void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
 void printMatrix(float a[][n]);              // print matrix
-void readMatrix(float a[][n]);               // read matrix from file saved
+void readMatrix(float a[][n]);               // read matrix from binary file
 //===serial gauss elimination
 void gaussEliminationSerial(float a[][n]);
 //===gauss elimination implemented by MPI
@@ -49,29 +52,8 @@ int main(int argc, char *argv[])
 // init matirx
 void initMatrix(float a[][n])
 {
-    srand((unsigned)time(0));
-
-    // init matrix by random element in (-1,1)
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = i; j < n; j++)
-        {
-            float t = pow(-1, rand() % 2 + 1);
-            float temp = rand() % (PRECISION) / (double)(PRECISION);
-            a[i][j] = t * temp;
-        }
-    }
-
-    // random linear combination
-    for (int i = 0; i < n * 10; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
 }
 
 // deep copy a to b
@@ -124,43 +106,15 @@ void gaussEliminationSerial(float a[][n])
     }
 }
 
-// read matrix initialized from file taged by n
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
 void readMatrix(float a[][n])
 {
-    string matrixPath = "./" + to_string(n) + ".txt";
-    ifstream ifStream;
-    ifStream.open(matrixPath);
-    if (!ifStream)
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
     {
-        ifStream.close();
         initMatrix(a);
-        ofstream ofStream(matrixPath);
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                ofStream << a[i][j] << ' ';
-                // cout<<a[i][j]<<" ";
-            }
-            ofStream << endl;
-        }
-        ofStream.close();
-        ifStream.open(matrixPath);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
     }
-    int r = 0;
-    stringstream stringStream;
-    while (!ifStream.eof())
-    {
-        string line;
-        getline(ifStream, line);
-        stringStream << line;
-        for (int i = 0; i < n; i++)
-        {
-            stringStream >> a[r][i];
-        }
-        r++;
-    }
-    ifStream.close();
 }
 
 void gaussEliminationMPI(float a[][n], int argc, char *argv[])
@@ -172,27 +126,24 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
     MPI_Status status;
     MPI_Datatype V;
 
     MPI_Type_vector(n / block_size / num, block_size * n, num * block_size * n, MPI_FLOAT, &V);
     MPI_Type_commit(&V);
 
-    // if rank = 0, init matrix and distribute task, else receive data from processor 0
+    // every processor reads its own row blocks from the matrix file if there is one, or generates them
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(MPI_COMM_WORLD);
     if (myid == 0)
-    {
-        readMatrix(a);
         s_time = MPI_Wtime();
-        for (int i = 1; i < num; i++)
-        {
-            int i_start = i * block_size;
-            MPI_Send(&a[i_start][0], 1, V, i, 0, MPI_COMM_WORLD);
-        }
-    }
-    else
     {
-        MPI_Recv(&a[myid * block_size][0], 1, V, 0, 0, MPI_COMM_WORLD, &status);
-        // printMatrix(a);
+        TraceSpan span(PHASE_PARSE, (long long)(n / num) * n * sizeof(float));
+        if (!matrixReadOrGenerateRows(MPI_COMM_WORLD, matrixPath.c_str(), matrixSeed(), n, myid * block_size,
+                                      block_size, num * block_size, n / block_size / num, &a[myid * block_size][0],
+                                      num * block_size))
+            MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
     // wait until each processor receive its data
@@ -208,6 +159,7 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     //     }
     //     MPI_Barrier(MPI_COMM_WORLD);
     // }
+    TraceSpan reduceSpan(PHASE_REDUCE);
     for (int k = 0; k < n; k++)
     {
         // corresponding processor does the division work and asks higher-ranked processors to do the elimination work together
@@ -220,7 +172,10 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
             }
             a[k][k] = 1;
         }
-        MPI_Bcast(&a[k][0], n, MPI_FLOAT, root, MPI_COMM_WORLD);
+        {
+            TraceSpan span(PHASE_BCAST, n * sizeof(float));
+            MPI_Bcast(&a[k][0], n, MPI_FLOAT, root, MPI_COMM_WORLD);
+        }
         // if(myid == 0)
         // {
         //     cout<<"k = "<<k<<" root= "<<root<<endl;
@@ -303,13 +258,17 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     //     MPI_Barrier(MPI_COMM_WORLD);
     // }
 
+    reduceSpan.end();
+
     // send back to processor 0
     if (myid != 0)
     {
+        TraceSpan span(PHASE_GATHER, (long long)(n / num) * n * sizeof(float));
         MPI_Send(&a[myid * block_size][0], 1, V, 0, myid, MPI_COMM_WORLD);
     }
     else
     {
+        TraceSpan span(PHASE_GATHER, (long long)(num - 1) * (n / num) * n * sizeof(float));
         for (int i = 1; i < num; i++)
         {
             int i_start = i * block_size;
@@ -326,5 +285,6 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
         e_time = MPI_Wtime();
         cout << "time consuming: " << e_time - s_time << endl;
     }
+    traceFinish();
     MPI_Finalize();
 }
@@ -6,6 +6,9 @@
  * @date 2022-06-23
  *
  * @copyright Copyright (c) 2022
+ * @details every processor owns a contiguous block of columns. at step k the owner of column k broadcasts it from
+ *          row k down, the pivot and the multipliers a[i][k], and every processor divides and eliminates its own
+ *          columns right of k with them.
  *
  */
 
@@ -17,19 +20,22 @@
 #include <sstream>
 #include <string>
 #include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
 using namespace std;
 
 #define n 1024
 #define PRECISION 999 // ensure precision of 0.0001
 
 float M[n][n] = {0.0};
-float M_B[n][n] = {0.0}; // backup of matrix
+// float M_B[n][n] = {0.0}; // backup of matrix
 
 //===functions to do with matrix
 void initMatrix(float a[][n]);               // init matrix
 void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
 void printMatrix(float a[][n]);              // print matrix
-void readMatrix(float a[][n]);               // read matrix from file saved
+void readMatrix(float a[][n]);               // read matrix from binary file
 //===serial gauss elimination
 void gaussEliminationSerial(float a[][n]);
 //===gauss elimination implemented by MPI
@@ -48,29 +54,8 @@ int main(int argc, char *argv[])
 // init matirx
 void initMatrix(float a[][n])
 {
-    srand((unsigned)time(0));
-
-    // init matrix by random element in (-1,1)
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = i; j < n; j++)
-        {
-            float t = pow(-1, rand() % 2 + 1);
-            float temp = rand() % (PRECISION) / (double)(PRECISION);
-            a[i][j] = t * temp;
-        }
-    }
-
-    // random linear combination
-    for (int i = 0; i < n * 10; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
 }
 
 // deep copy a to b
@@ -123,43 +108,15 @@ void gaussEliminationSerial(float a[][n])
     }
 }
 
-// read matrix initialized from file taged by n
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
 void readMatrix(float a[][n])
 {
-    string matrixPath = "./" + to_string(n) + ".txt";
-    ifstream ifStream;
-    ifStream.open(matrixPath);
-    if (!ifStream)
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
     {
-        ifStream.close();
         initMatrix(a);
-        ofstream ofStream(matrixPath);
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                ofStream << a[i][j] << ' ';
-                // cout<<a[i][j]<<" ";
-            }
-            ofStream << endl;
-        }
-        ofStream.close();
-        ifStream.open(matrixPath);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
     }
-    int r = 0;
-    stringstream stringStream;
-    while (!ifStream.eof())
-    {
-        string line;
-        getline(ifStream, line);
-        stringStream << line;
-        for (int i = 0; i < n; i++)
-        {
-            stringStream >> a[r][i];
-        }
-        r++;
-    }
-    ifStream.close();
 }
 
 void gaussEliminationMPI(float a[][n], int argc, char *argv[])
@@ -171,10 +128,12 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     int c_stride;
     double s_time, e_time; // count time
     int *strides;
+    float *col; // column k from row k down, broadcast by its owner at step k
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
     MPI_Status status;
     MPI_Datatype C1, C2;
     int stride1, stride2;
@@ -191,6 +150,7 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     MPI_Type_vector(n, stride2, n, MPI_FLOAT, &C2);
     MPI_Type_commit(&C2);
     strides = new int[num + 1];
+    col = new float[n];
     strides[0] = 0;
     for (int i = 1; i <= num; i++)
     {
@@ -217,7 +177,11 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     // if rank = 0, init matrix and distribute task, else receive data from processor 0
     if (myid == 0)
     {
-        readMatrix(a);
+        {
+            TraceSpan span(PHASE_PARSE);
+            readMatrix(a);
+        }
+        TraceSpan span(PHASE_SCATTER, (long long)(n - c_stride) * n * sizeof(float));
         for (int i = 1; i < num; i++)
         {
             int i_start = i * (n / num) + ((i < n % num) ? i : n % num);
@@ -233,6 +197,7 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     }
     else
     {
+        TraceSpan span(PHASE_SCATTER, (long long)c_stride * n * sizeof(float));
         if (myid < n % num)
         {
             MPI_Recv(&a[0][c_start], 1, C1, 0, 0, MPI_COMM_WORLD, &status);
@@ -248,6 +213,7 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     // wait until each processor receive its data
     MPI_Barrier(MPI_COMM_WORLD);
 
+    TraceSpan reduceSpan(PHASE_REDUCE);
     for (int k = 0; k < n; k++)
     {
         // find the process having a[k][k] and broadcast to others
@@ -260,31 +226,52 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
             root_end = root_start + (n / num) + ((root < n % num) ? 1 : 0) - 1;
         } while (k < root_start || k > root_end);
         // cout<<"k = "<<k<<" root = "<<root<<endl;
-        MPI_Bcast(&a[k][k], 1, MPI_FLOAT, root, MPI_COMM_WORLD);
 
-        // each corresponding one does division and elimination work individually
+        // the multipliers a[i][k] are needed by every processor with columns right of k, not only the pivot
+        if (myid == root)
+        {
+            for (int i = k; i < n; i++)
+            {
+                col[i - k] = a[i][k];
+            }
+        }
+        {
+            TraceSpan span(PHASE_BCAST, (long long)(n - k) * sizeof(float));
+            MPI_Bcast(col, n - k, MPI_FLOAT, root, MPI_COMM_WORLD);
+        }
+
+        // processors left of root own no column right of k, the others divide and eliminate their own columns
         if (myid >= root)
         {
             for (int j = max(c_start, k + 1); j <= c_end; j++)
             {
-                a[k][j] /= a[k][k];
+                a[k][j] /= col[0];
             }
-            a[k][k] = 1;
 
             for (int i = k + 1; i < n; i++)
             {
                 for (int j = max(c_start, k + 1); j <= c_end; j++)
                 {
-                    a[i][j] -= a[i][k] * a[k][j];
+                    a[i][j] -= col[i - k] * a[k][j];
                 }
+            }
+        }
+        if (myid == root)
+        {
+            a[k][k] = 1;
+            for (int i = k + 1; i < n; i++)
+            {
                 a[i][k] = 0;
             }
         }
     }
 
+    reduceSpan.end();
+
     // send back to processor 0
     if (myid != 0)
     {
+        TraceSpan span(PHASE_GATHER, (long long)c_stride * n * sizeof(float));
         if (myid < n % num)
         {
             MPI_Send(&a[0][c_start], 1, C1, 0, myid, MPI_COMM_WORLD);
@@ -296,6 +283,7 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
     }
     else
     {
+        TraceSpan span(PHASE_GATHER, (long long)(n - c_stride) * n * sizeof(float));
         for (int i = 1; i < num; i++)
         {
             if (i < n % num)
@@ -317,5 +305,8 @@ void gaussEliminationMPI(float a[][n], int argc, char *argv[])
         e_time = MPI_Wtime();
         cout << "time consuming: " << e_time - s_time << endl;
     }
+    delete[] strides;
+    delete[] col;
+    traceFinish();
     MPI_Finalize();
 }
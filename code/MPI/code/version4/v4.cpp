@@ -17,19 +17,23 @@
 #include <sstream>
 #include <string>
 #include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+#include "../../../common/partition.h"
 using namespace std;
 
 #define n 12
 #define PRECISION 999 // ensure precision of 0.0001
 
-float M[n][n] = {0.0};
-float M_B[n][n] = {0.0}; // backup of matrix
+float (*M)[n];
+// float M_B[n][n] = {0.0}; // backup of matrix
 
 //===functions to do with matrix
 void initMatrix(float a[][n]);               // init matrix
 void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
 void printMatrix(float a[][n]);              // print matrix
-void readMatrix(float a[][n]);               // read matrix from file saved
+void readMatrix(float a[][n]);               // read matrix from binary file
 //===serial gauss elimination
 void gaussEliminationSerial(float a[][n]);
 //===gauss elimination implemented by MPI
@@ -38,7 +42,7 @@ void gaussEliminationMPIPipeline(float a[][n], int argc, char *argv[]);
 int main(int argc, char *argv[])
 {
     // initMatrix(M);
-    readMatrix(M);
+    // readMatrix(M);
     // printMatrix(M);
     // gaussEliminationSerial(M);
     gaussEliminationMPIPipeline(M, argc, argv);
@@ -48,29 +52,8 @@ int main(int argc, char *argv[])
 // init matirx
 void initMatrix(float a[][n])
 {
-    srand((unsigned)time(0));
-
-    // init matrix by random element in (-1,1)
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = i; j < n; j++)
-        {
-            float t = pow(-1, rand() % 2 + 1);
-            float temp = rand() % (PRECISION) / (double)(PRECISION);
-            a[i][j] = t * temp;
-        }
-    }
-
-    // random linear combination
-    for (int i = 0; i < n * 10; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
 }
 
 // deep copy a to b
@@ -123,43 +106,15 @@ void gaussEliminationSerial(float a[][n])
     }
 }
 
-// read matrix initialized from file taged by n
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
 void readMatrix(float a[][n])
 {
-    string matrixPath = "./" + to_string(n) + ".txt";
-    ifstream ifStream;
-    ifStream.open(matrixPath);
-    if (!ifStream)
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
     {
-        ifStream.close();
         initMatrix(a);
-        ofstream ofStream(matrixPath);
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                ofStream << a[i][j] << ' ';
-                // cout<<a[i][j]<<" ";
-            }
-            ofStream << endl;
-        }
-        ofStream.close();
-        ifStream.open(matrixPath);
-    }
-    int r = 0;
-    stringstream stringStream;
-    while (!ifStream.eof())
-    {
-        string line;
-        getline(ifStream, line);
-        stringStream << line;
-        for (int i = 0; i < n; i++)
-        {
-            stringStream >> a[r][i];
-        }
-        r++;
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
     }
-    ifStream.close();
 }
 
 void gaussEliminationMPIPipeline(float a[][n], int argc, char *argv[])
@@ -170,31 +125,52 @@ void gaussEliminationMPIPipeline(float a[][n], int argc, char *argv[])
     float *sub;            // submatrix of each processor in 1d
     float *tmp;             //get data of row k
     int np;                 //submatrix size of each processor
+    int first;              //global index of the first row of submatrix
+    int *counts, *displs;   //elements of every processor's rows and where they start in a
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
     MPI_Status status;
 
+    np = partitionRows(n, num, myid); // the first n % num processors take one row more
+    first = partitionFirst(n, num, myid);
+    counts = new int[num];
+    displs = new int[num];
+    partitionCounts(n, num, n, counts, displs);
     if (myid == 0)
-    {
-        s_time = MPI_Wtime();
-        readMatrix(a);
-    }
-    np = n/num;
+        a = new float[n][n]; // whole matrix only where it is read and collected
     sub = new float[n*np];
     tmp = new float[n];
 
-    MPI_Scatter(&a[0][0], n * np, MPI_FLOAT, sub, n * np, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (myid == 0)
+        s_time = MPI_Wtime();
+    // every processor reads its own rows from the matrix file if there is one, or generates them,
+    // nothing is scattered
+    {
+        TraceSpan span(PHASE_PARSE, (long long)n * np * sizeof(float));
+        if (!matrixReadOrGenerateRows(MPI_COMM_WORLD, matrixPath.c_str(), matrixSeed(), n, first, np, np, 1,
+                                      sub, np))
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    TraceSpan reduceSpan(PHASE_REDUCE);
 
-    for (int i = 0; i < myid * np; i++)
+    for (int i = 0; i < first; i++)
     {
         // Get data from last level of pipeline
-        MPI_Recv(tmp, n, MPI_FLOAT, myid-1, 0, MPI_COMM_WORLD, &status);
+        {
+            TraceSpan span(PHASE_RECV, n * sizeof(float));
+            MPI_Recv(tmp, n, MPI_FLOAT, myid-1, 0, MPI_COMM_WORLD, &status);
+        }
 
         // send data to next level of pipeline
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND, n * sizeof(float));
             MPI_Send(tmp, n, MPI_FLOAT, myid + 1, 0, MPI_COMM_WORLD);
         }
         
@@ -212,11 +188,11 @@ void gaussEliminationMPIPipeline(float a[][n], int argc, char *argv[])
     // calculation
     for (int row = 0; row < np; row++)
     {
-        for (int j = myid * np + row + 1; j < n; j++)
+        for (int j = first + row + 1; j < n; j++)
         {
-            sub[row * n + j] = sub[row * n + j] / sub[row * n + np * myid + row];
+            sub[row * n + j] = sub[row * n + j] / sub[row * n + first + row];
         }
-        sub[row * n + np * myid + row] = 1;
+        sub[row * n + first + row] = 1;
 
         for (int i = 0; i < n; i++)
         {
@@ -226,22 +202,28 @@ void gaussEliminationMPIPipeline(float a[][n], int argc, char *argv[])
         // send result to next pipeline
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND, n * sizeof(float));
             MPI_Send(tmp, n, MPI_FLOAT, myid + 1, 0, MPI_COMM_WORLD);
         }
 
         // Update lower rows
         for (int i = row + 1; i < np; i++)
         {
-            for (int j = myid * np + row + 1; j < n; j++)
+            for (int j = first + row + 1; j < n; j++)
             {
-                sub[i * n + j] = sub[i * n + j] - sub[i * n + myid * np + row] * tmp[j];
+                sub[i * n + j] = sub[i * n + j] - sub[i * n + first + row] * tmp[j];
             }
-            sub[i * n + myid * np + row] = 0;
+            sub[i * n + first + row] = 0;
         }
     }
+    reduceSpan.end();
+
     // Synchronize and gather rows
-    MPI_Barrier(MPI_COMM_WORLD);
-    MPI_Gather(sub, n * np, MPI_FLOAT, &a[0][0], n * np, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    {
+        TraceSpan span(PHASE_GATHER, (long long)n * np * sizeof(float));
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Gatherv(sub, n * np, MPI_FLOAT, (float *)a, counts, displs, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    }
 
     // if(myid==0)
     // {
@@ -253,5 +235,12 @@ void gaussEliminationMPIPipeline(float a[][n], int argc, char *argv[])
         e_time = MPI_Wtime();
         cout << "time consuming: " << e_time - s_time << endl;
     }
+    if (myid == 0)
+        delete[] a;
+    delete[] sub;
+    delete[] tmp;
+    delete[] counts;
+    delete[] displs;
+    traceFinish();
     MPI_Finalize();
 }
@@ -17,6 +17,10 @@
 #include <sstream>
 #include <string>
 #include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+#include "../../../common/partition.h"
 #include <omp.h>
 using namespace std;
 
@@ -31,7 +35,7 @@ float (*M)[n];
 void initMatrix(float a[][n]);               // init matrix
 void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
 void printMatrix(float a[][n]);              // print matrix
-void readMatrix(float a[][n]);               // read matrix from file saved
+void readMatrix(float a[][n]);               // read matrix from binary file
 //===serial gauss elimination
 void gaussEliminationSerial(float a[][n]);
 //===gauss elimination implemented by MPI
@@ -50,29 +54,8 @@ int main(int argc, char *argv[])
 // init matirx
 void initMatrix(float (*a)[n])
 {
-    srand((unsigned)time(0));
-
-    // init matrix by random element in (-1,1)
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = i; j < n; j++)
-        {
-            float t = pow(-1, rand() % 2 + 1);
-            float temp = rand() % (precision) / (double)(precision);
-            a[i][j] = t * temp;
-        }
-    }
-
-    // random linear combination
-    for (int i = 0; i < n * 10; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
 }
 
 // deep copy a to b
@@ -125,43 +108,15 @@ void gaussEliminationSerial(float (*a)[n])
     }
 }
 
-// read matrix initialized from file taged by n
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
 void readMatrix(float (*a)[n])
 {
-    string matrixPath = "./" + to_string(n) + ".txt";
-    ifstream ifStream;
-    ifStream.open(matrixPath);
-    if (!ifStream)
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
     {
-        ifStream.close();
         initMatrix(a);
-        ofstream ofStream(matrixPath);
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                ofStream << a[i][j] << ' ';
-                // cout<<a[i][j]<<" ";
-            }
-            ofStream << endl;
-        }
-        ofStream.close();
-        ifStream.open(matrixPath);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
     }
-    int r = 0;
-    stringstream stringStream;
-    while (!ifStream.eof())
-    {
-        string line;
-        getline(ifStream, line);
-        stringStream << line;
-        for (int i = 0; i < n; i++)
-        {
-            stringStream >> a[r][i];
-        }
-        r++;
-    }
-    ifStream.close();
 }
 
 void gaussEliminationMPIPipelineOpenMP(float (*a)[n], int argc, char *argv[])
@@ -172,6 +127,8 @@ void gaussEliminationMPIPipelineOpenMP(float (*a)[n], int argc, char *argv[])
     float(*sub)[n];        // submatrix of each processor in 1d
     float *tmp;            // get data of row k
     int np;                // submatrix size of each processor
+    int first;             // global index of the first row of submatrix
+    int *counts, *displs;  // elements of every processor's rows and where they start in a
     int provided;          // thread safety level provided
 
     MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
@@ -181,34 +138,52 @@ void gaussEliminationMPIPipelineOpenMP(float (*a)[n], int argc, char *argv[])
     }
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
     MPI_Comm com = MPI_COMM_WORLD;
     MPI_Status status;
 
-    a = new float[n][n];
-    np = n / num;          // lines of submatrix
-    sub = new float[n][n]; // store tmp result during computation
+    np = partitionRows(n, num, myid); // lines of submatrix, the first n % num processors take one more
+    first = partitionFirst(n, num, myid);
+    counts = new int[num];
+    displs = new int[num];
+    partitionCounts(n, num, n, counts, displs);
+    if (myid == 0)
+        a = new float[n][n]; // whole matrix only where it is read and collected
+    sub = new float[np][n];  // store tmp result during computation
     tmp = new float[n];    // store row k during computation
 
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(com);
     if (myid == 0)
     {
-        readMatrix(a);
         s_time = MPI_Wtime();
     }
 
-    // distribute task to each processor
-    MPI_Scatter(&a[0][0], n * np, MPI_FLOAT, &sub[0][0], n * np, MPI_FLOAT, 0, com);
+    // every processor reads its own rows from the matrix file if there is one, or generates them,
+    // nothing is scattered
+    {
+        TraceSpan span(PHASE_PARSE, (long long)n * np * sizeof(float));
+        if (!matrixReadOrGenerateRows(com, matrixPath.c_str(), matrixSeed(), n, first, np, np, 1, &sub[0][0], np))
+            MPI_Abort(com, 1);
+    }
+
+    TraceSpan reduceSpan(PHASE_REDUCE);
 
     int i, j, row;
 #pragma omp parallel private(i, j, row)
-    for (i = 0; i < myid * np; i++)
+    for (i = 0; i < first; i++)
     {
 #pragma omp single
         {
             // Get data from last level of pipeline
-            MPI_Recv(tmp, n, MPI_FLOAT, myid - 1, 0, com, &status);
+            {
+                TraceSpan span(PHASE_RECV, n * sizeof(float));
+                MPI_Recv(tmp, n, MPI_FLOAT, myid - 1, 0, com, &status);
+            }
             // send data to next level of pipeline
             if (myid != (num - 1))
             {
+                TraceSpan span(PHASE_SEND, n * sizeof(float));
                 MPI_Send(tmp, n, MPI_FLOAT, myid + 1, 0, com);
             }
         }
@@ -231,11 +206,11 @@ void gaussEliminationMPIPipelineOpenMP(float (*a)[n], int argc, char *argv[])
     {
 #pragma omp for
         // calculation first
-        for (j = myid * np + row + 1; j < n; j++)
+        for (j = first + row + 1; j < n; j++)
         {
-            sub[row][j] = sub[row][j] / sub[row][np * myid + row];
+            sub[row][j] = sub[row][j] / sub[row][first + row];
         }
-        sub[row][np * myid + row] = 1;
+        sub[row][first + row] = 1;
 
 #pragma omp for
         for (i = 0; i < n; i++)
@@ -246,6 +221,7 @@ void gaussEliminationMPIPipelineOpenMP(float (*a)[n], int argc, char *argv[])
         // send result to next pipeline
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND, n * sizeof(float));
             MPI_Send(tmp, n, MPI_FLOAT, myid + 1, 0, com);
         }
 
@@ -253,17 +229,22 @@ void gaussEliminationMPIPipelineOpenMP(float (*a)[n], int argc, char *argv[])
 #pragma omp for
         for (i = row + 1; i < np; i++)
         {
-            for (j = myid * np + row + 1; j < n; j++)
+            for (j = first + row + 1; j < n; j++)
             {
-                sub[i][j] -= sub[i][myid * np + row] * tmp[j];
+                sub[i][j] -= sub[i][first + row] * tmp[j];
             }
-            sub[i][myid * np + row] = 0;
+            sub[i][first + row] = 0;
         }
     }
 
+    reduceSpan.end();
+
     // Synchronize and gather rows
-    MPI_Barrier(com);
-    MPI_Gather(&sub[0][0], n * np, MPI_FLOAT, &a[0][0], n * np, MPI_FLOAT, 0, com);
+    {
+        TraceSpan span(PHASE_GATHER, (long long)n * np * sizeof(float));
+        MPI_Barrier(com);
+        MPI_Gatherv(&sub[0][0], n * np, MPI_FLOAT, (float *)a, counts, displs, MPI_FLOAT, 0, com);
+    }
 
     // // to correct result
     // if (myid == 0)
@@ -277,5 +258,12 @@ void gaussEliminationMPIPipelineOpenMP(float (*a)[n], int argc, char *argv[])
         cout << "time consuming: " << e_time - s_time << endl;
     }
 
+    if (myid == 0)
+        delete[] a;
+    delete[] sub;
+    delete[] tmp;
+    delete[] counts;
+    delete[] displs;
+    traceFinish();
     MPI_Finalize();
 }
@@ -1,7 +1,7 @@
 /**
  * @file v7.cpp
  * @author NKCS_GKC (2012522@mail.nankai.edu.cn)
- * @brief pipeline gauss elimination + openmp + neon
+ * @brief pipeline gauss elimination + openmp + simd (kernels picked at runtime by ../../../common/simd.h, neon on aarch64)
  * @version 0.1
  * @date 2022-06-23
  *
@@ -17,8 +17,12 @@
 #include <sstream>
 #include <string>
 #include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+#include "../../../common/partition.h"
 #include <omp.h>
-#include <arm_neon.h>
+#include "../../../common/simd.h"
 using namespace std;
 
 #define n 128
@@ -32,7 +36,7 @@ float (*M)[n];
 void initMatrix(float a[][n]);               // init matrix
 void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
 void printMatrix(float a[][n]);              // print matrix
-void readMatrix(float a[][n]);               // read matrix from file saved
+void readMatrix(float a[][n]);               // read matrix from binary file
 //===serial gauss elimination
 void gaussEliminationSerial(float a[][n]);
 //===gauss elimination implemented by MPI
@@ -51,29 +55,8 @@ int main(int argc, char *argv[])
 // init matirx
 void initMatrix(float (*a)[n])
 {
-    srand((unsigned)time(0));
-
-    // init matrix by random element in (-1,1)
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = i; j < n; j++)
-        {
-            float t = pow(-1, rand() % 2 + 1);
-            float temp = rand() % (precision) / (double)(precision);
-            a[i][j] = t * temp;
-        }
-    }
-
-    // random linear combination
-    for (int i = 0; i < n * 10; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
 }
 
 // deep copy a to b
@@ -126,43 +109,15 @@ void gaussEliminationSerial(float (*a)[n])
     }
 }
 
-// read matrix initialized from file taged by n
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
 void readMatrix(float (*a)[n])
 {
-    string matrixPath = "./" + to_string(n) + ".txt";
-    ifstream ifStream;
-    ifStream.open(matrixPath);
-    if (!ifStream)
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
     {
-        ifStream.close();
         initMatrix(a);
-        ofstream ofStream(matrixPath);
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                ofStream << a[i][j] << ' ';
-                // cout<<a[i][j]<<" ";
-            }
-            ofStream << endl;
-        }
-        ofStream.close();
-        ifStream.open(matrixPath);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
     }
-    int r = 0;
-    stringstream stringStream;
-    while (!ifStream.eof())
-    {
-        string line;
-        getline(ifStream, line);
-        stringStream << line;
-        for (int i = 0; i < n; i++)
-        {
-            stringStream >> a[r][i];
-        }
-        r++;
-    }
-    ifStream.close();
 }
 
 void gaussEliminationMPIPipelineOpenMPNeon(float (*a)[n], int argc, char *argv[])
@@ -173,6 +128,8 @@ void gaussEliminationMPIPipelineOpenMPNeon(float (*a)[n], int argc, char *argv[]
     float(*sub)[n];        // submatrix of each processor in 1d
     float *tmp;            // get data of row k
     int np;                // submatrix size of each processor
+    int first;             // global index of the first row of submatrix
+    int *counts, *displs;  // elements of every processor's rows and where they start in a
     int provided;          // thread safety level provided
 
     MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
@@ -182,35 +139,53 @@ void gaussEliminationMPIPipelineOpenMPNeon(float (*a)[n], int argc, char *argv[]
     }
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
     MPI_Comm com = MPI_COMM_WORLD;
     MPI_Status status;
 
-    a = new float[n][n];
-    np = n / num;          // lines of submatrix
-    sub = new float[n][n]; // store tmp result during computation
+    np = partitionRows(n, num, myid); // lines of submatrix, the first n % num processors take one more
+    first = partitionFirst(n, num, myid);
+    counts = new int[num];
+    displs = new int[num];
+    partitionCounts(n, num, n, counts, displs);
+    if (myid == 0)
+        a = new float[n][n]; // whole matrix only where it is read and collected
+    sub = new float[np][n];  // store tmp result during computation
     tmp = new float[n];    // store row k during computation
 
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(com);
     if (myid == 0)
     {
-        readMatrix(a);
         s_time = MPI_Wtime();
     }
 
-    // distribute task to each processor
-    MPI_Scatter(&a[0][0], n * np, MPI_FLOAT, &sub[0][0], n * np, MPI_FLOAT, 0, com);
+    // every processor reads its own rows from the matrix file if there is one, or generates them,
+    // nothing is scattered
+    {
+        TraceSpan span(PHASE_PARSE, (long long)n * np * sizeof(float));
+        if (!matrixReadOrGenerateRows(com, matrixPath.c_str(), matrixSeed(), n, first, np, np, 1, &sub[0][0], np))
+            MPI_Abort(com, 1);
+    }
+
+    TraceSpan reduceSpan(PHASE_REDUCE);
 
-    int i, j, row;
-#pragma omp parallel private(i, j, row)
-    for (i = 0; i < myid * np; i++)
+    int i, row;
+#pragma omp parallel private(i, row)
+    for (i = 0; i < first; i++)
     {
 #pragma omp single
         // Get data from last level of pipeline
-        MPI_Recv(tmp, n, MPI_FLOAT, myid - 1, 0, com, &status);
+        {
+            TraceSpan span(PHASE_RECV, n * sizeof(float));
+            MPI_Recv(tmp, n, MPI_FLOAT, myid - 1, 0, com, &status);
+        }
 
 #pragma omp single
         // send data to next level of pipeline
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND, n * sizeof(float));
             MPI_Send(tmp, n, MPI_FLOAT, myid + 1, 0, com);
         }
 
@@ -218,82 +193,51 @@ void gaussEliminationMPIPipelineOpenMPNeon(float (*a)[n], int argc, char *argv[]
         // eliminate individually
         for (row = 0; row < np; row++)
         {
-            float32x4_t v_sub_row_i = vld1q_f32(sub[row] + i);
             // currently, i equals k, standing for the rank of elimination
-            for (j = i + 1; j < n; j += 4)
-            {
-                float32x4_t v_tmp_j = vld1q_f32(tmp + j);
-                float32x4_t v_sub_row_j = vld1q_f32(sub[row] + j);
-                float32x4_t v_mul = vmulq_f32(v_tmp_j, v_sub_row_i);
-                v_sub_row_j = vsubq_f32(v_sub_row_j, v_mul);
-                vst1q_f32(sub[row] + j, v_sub_row_j);
-            }
-            for (j = j - 4; j < n; j++)
-            {
-                sub[row][j] -= sub[row][i] * tmp[j];
-            }
+            simdEliminate(sub[row], tmp, i + 1, n, sub[row][i]); // sub[row][j] -= sub[row][i] * tmp[j]
             sub[row][i] = 0;
         }
     }
 
-#pragma omp parallel private(row, i, j)
+#pragma omp parallel private(i, row)
     for (row = 0; row < np; row++)
     {
-        float32x4_t v_sub_row = vld1q_dup_f32(sub[row] + np * myid + row);
-#pragma omp for
-        // calculation first
-        for (j = myid * np + row + 1; j < n; j += 4)
-        {
-            float32x4_t v_sub_row_j = vld1q_f32(sub[row] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-            v_sub_row_j = vdivq_f32(v_sub_row_j, v_sub_row);   // a[k][j] /= a[k][k]
-            vst1q_f32(sub[row] + j, v_sub_row_j);              // 把运算结果写回到内存中
-        }
+        int k = first + row; // rank of elimination
 #pragma omp single
         {
-            for (int j = j - 4; j < n; j++)
+            // calculation first, a single row is too short to share among threads
+            simdDivide(sub[row], k + 1, n, sub[row][k]); // sub[row][j] /= sub[row][k]
+            sub[row][k] = 1;
+            for (i = 0; i < n; i++)
             {
-                sub[row][j] = sub[row][j] / sub[row][np * myid + row];
+                tmp[i] = sub[row][i];
             }
-            sub[row][np * myid + row] = 1;
-        }
 
-#pragma omp for
-        for (i = 0; i < n; i++)
-        {
-            float32x4_t v_tmp_i = vld1q_dup_f32(tmp + i);
-            vst1q_f32(sub[row] + i, v_tmp_i);
-        }
-#pragma omp single
-        // send result to next pipeline
-        if (myid != (num - 1))
-        {
-            MPI_Send(tmp, n, MPI_FLOAT, myid + 1, 0, com);
+            // send result to next pipeline
+            if (myid != (num - 1))
+            {
+                TraceSpan span(PHASE_SEND, n * sizeof(float));
+                MPI_Send(tmp, n, MPI_FLOAT, myid + 1, 0, com);
+            }
         }
 
-// eliminate individually
 #pragma omp for
+        // eliminate individually
         for (i = row + 1; i < np; i++)
         {
-            float32x4_t v_sub_i_row = vld1q_f32(sub[i] + myid * np + row);
-            for (j = myid * np + row + 1; j < n; j += 4)
-            {
-                float32x4_t v_tmp_j = vld1q_f32(tmp + j);
-                float32x4_t v_sub_i_j = vld1q_f32(sub[i] + j);
-                float32x4_t v_mul = vmulq_f32(v_tmp_j, v_sub_i_j);
-                v_sub_i_j = vsubq_f32(v_sub_i_j, v_mul);
-                vst1q_f32(sub[i] + j, v_sub_i_j);
-            }
-            for (j = j - 4; j < n; j++)
-            {
-                sub[i][j] = sub[i][j] - sub[i][myid * np + row] * tmp[j];
-            }
-            sub[i][myid * np + row] = 0;
+            simdEliminate(sub[i], tmp, k + 1, n, sub[i][k]); // sub[i][j] -= sub[i][k] * tmp[j]
+            sub[i][k] = 0;
         }
     }
 
+    reduceSpan.end();
+
     // Synchronize and gather rows
-    MPI_Barrier(com);
-    MPI_Gather(&sub[0][0], n * np, MPI_FLOAT, &a[0][0], n * np, MPI_FLOAT, 0, com);
+    {
+        TraceSpan span(PHASE_GATHER, (long long)n * np * sizeof(float));
+        MPI_Barrier(com);
+        MPI_Gatherv(&sub[0][0], n * np, MPI_FLOAT, (float *)a, counts, displs, MPI_FLOAT, 0, com);
+    }
 
     // // to correct result
     // if (myid == 0)
@@ -307,5 +251,12 @@ void gaussEliminationMPIPipelineOpenMPNeon(float (*a)[n], int argc, char *argv[]
         cout << "time consuming: " << e_time - s_time << endl;
     }
 
+    if (myid == 0)
+        delete[] a;
+    delete[] sub;
+    delete[] tmp;
+    delete[] counts;
+    delete[] displs;
+    traceFinish();
     MPI_Finalize();
 }
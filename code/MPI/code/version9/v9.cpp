@@ -17,6 +17,10 @@
 #include <sstream>
 #include <string>
 #include "mpi.h"
+#include "../../../common/trace.h"
+#include "../../../common/matrixFile.h"
+#include "../../../common/matrixGen.h"
+#include "../../../common/partition.h"
 using namespace std;
 
 #define n 1024
@@ -29,7 +33,7 @@ float (*M)[n];
 void initMatrix(float a[][n]);               // init matrix
 void copyMatrix(float a[][n], float b[][n]); // deep copy mtrix a to b
 void printMatrix(float a[][n]);              // print matrix
-void readMatrix(float a[][n]);               // read matrix from file saved
+void readMatrix(float a[][n]);               // read matrix from binary file
 //===serial gauss elimination
 void gaussEliminationSerial(float a[][n]);
 //===gauss elimination implemented by MPI
@@ -48,29 +52,8 @@ int main(int argc, char *argv[])
 // init matirx
 void initMatrix(float (*a)[n])
 {
-    srand((unsigned)time(0));
-
-    // init matrix by random element in (-1,1)
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = i; j < n; j++)
-        {
-            float t = pow(-1, rand() % 2 + 1);
-            float temp = rand() % (PRECISION) / (double)(PRECISION);
-            a[i][j] = t * temp;
-        }
-    }
-
-    // random linear combination
-    for (int i = 0; i < n * 10; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    // rows of the counter-based generator of matrixGen.h, the same matrix for the same seed in every run
+    matrixGenRows(matrixSeed(), n, 0, n, &a[0][0], n);
 }
 
 // deep copy a to b
@@ -123,43 +106,15 @@ void gaussEliminationSerial(float (*a)[n])
     }
 }
 
-// read matrix initialized from file taged by n
+// read matrix from the binary file taged by n, a new one is generated and saved when missing
 void readMatrix(float (*a)[n])
 {
-    string matrixPath = "./" + to_string(n) + ".txt";
-    ifstream ifStream;
-    ifStream.open(matrixPath);
-    if (!ifStream)
+    string matrixPath = "./" + to_string(n) + ".bin";
+    if (!matrixFileLoad(matrixPath.c_str(), &a[0][0], n, n))
     {
-        ifStream.close();
         initMatrix(a);
-        ofstream ofStream(matrixPath);
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                ofStream << a[i][j] << ' ';
-                // cout<<a[i][j]<<" ";
-            }
-            ofStream << endl;
-        }
-        ofStream.close();
-        ifStream.open(matrixPath);
+        matrixFileSave(matrixPath.c_str(), &a[0][0], n, n);
     }
-    int r = 0;
-    stringstream stringStream;
-    while (!ifStream.eof())
-    {
-        string line;
-        getline(ifStream, line);
-        stringStream << line;
-        for (int i = 0; i < n; i++)
-        {
-            stringStream >> a[r][i];
-        }
-        r++;
-    }
-    ifStream.close();
 }
 
 void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
@@ -170,31 +125,51 @@ void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
     float(*sub)[n];        // submatrix of each processor in 1d
     float *tmp;            // get data of row k
     int np;                // submatrix size of each processor
+    int first;             // global index of the first row of submatrix
+    int *counts, *displs;  // elements of every processor's rows and where they start in a
 
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &num);
+    traceInit();
     MPI_Status status1, status2, status3;
     MPI_Request request1, request2, request3;
 
-    a = new float[n][n];
-    np = n / num;          // lines of submatrix
-    sub = new float[n][n]; // store tmp result during computation
+    np = partitionRows(n, num, myid); // lines of submatrix, the first n % num processors take one more
+    first = partitionFirst(n, num, myid);
+    counts = new int[num];
+    displs = new int[num];
+    partitionCounts(n, num, n, counts, displs);
+    if (myid == 0)
+        a = new float[n][n]; // whole matrix only where it is read and collected
+    sub = new float[np][n];  // store tmp result during computation
     tmp = new float[n];    // store row k during computation
 
+    string matrixPath = "./" + to_string(n) + ".bin";
+    MPI_Barrier(MPI_COMM_WORLD);
     if (myid == 0)
     {
-        readMatrix(a);
         s_time = MPI_Wtime();
     }
 
-    // distribute task to each processor
-    MPI_Scatter(&a[0][0], n * np, MPI_FLOAT, &sub[0][0], n * np, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    // every processor reads its own rows from the matrix file if there is one, or generates them,
+    // nothing is scattered
+    {
+        TraceSpan span(PHASE_PARSE, (long long)n * np * sizeof(float));
+        if (!matrixReadOrGenerateRows(MPI_COMM_WORLD, matrixPath.c_str(), matrixSeed(), n, first, np, np, 1,
+                                      &sub[0][0], np))
+            MPI_Abort(MPI_COMM_WORLD, 1);
+    }
 
-    for (int i = 0; i < myid * np; i++)
+    TraceSpan reduceSpan(PHASE_REDUCE);
+
+    for (int i = 0; i < first; i++)
     {
         // Get data from last level of pipeline ( blocking )
-        MPI_Recv(tmp, n, MPI_FLOAT, myid - 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        {
+            TraceSpan span(PHASE_RECV, n * sizeof(float));
+            MPI_Recv(tmp, n, MPI_FLOAT, myid - 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
         // MPI_Irecv(tmp, n, MPI_FLOAT, myid - 1, 0, MPI_COMM_WORLD, &request1);
         // // Wait until received
         // MPI_Wait(&request1, MPI_STATUS_IGNORE);
@@ -202,6 +177,7 @@ void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
         // send data to next level of pipeline ( non-blocking )
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND, n * sizeof(float));
             MPI_Isend(tmp, n, MPI_FLOAT, myid + 1, 0, MPI_COMM_WORLD, &request2);
         }
 
@@ -219,6 +195,7 @@ void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
         // wait until sended
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND);
             MPI_Wait(&request2, MPI_STATUS_IGNORE);
         }
     }
@@ -226,11 +203,11 @@ void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
     for (int row = 0; row < np; row++)
     {
         // calculation first
-        for (int j = myid * np + row + 1; j < n; j++)
+        for (int j = first + row + 1; j < n; j++)
         {
-            sub[row][j] = sub[row][j] / sub[row][np * myid + row];
+            sub[row][j] = sub[row][j] / sub[row][first + row];
         }
-        sub[row][np * myid + row] = 1;
+        sub[row][first + row] = 1;
 
         for (int i = 0; i < n; i++)
         {
@@ -240,28 +217,35 @@ void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
         // send result to next pipeline ( non-blocking )
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND, n * sizeof(float));
             MPI_Isend(tmp, n, MPI_FLOAT, myid + 1, 0, MPI_COMM_WORLD, &request3);
         }
 
         // eliminate individually
         for (int i = row + 1; i < np; i++)
         {
-            for (int j = myid * np + row + 1; j < n; j++)
+            for (int j = first + row + 1; j < n; j++)
             {
-                sub[i][j] -= sub[i][myid * np + row] * tmp[j];
+                sub[i][j] -= sub[i][first + row] * tmp[j];
             }
-            sub[i][myid * np + row] = 0;
+            sub[i][first + row] = 0;
         }
 
         if (myid != (num - 1))
         {
+            TraceSpan span(PHASE_SEND);
             MPI_Wait(&request3, MPI_STATUS_IGNORE);
         }
     }
 
+    reduceSpan.end();
+
     // Synchronize and gather rows
-    MPI_Barrier(MPI_COMM_WORLD);
-    MPI_Gather(&sub[0][0], n * np, MPI_FLOAT, &a[0][0], n * np, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    {
+        TraceSpan span(PHASE_GATHER, (long long)n * np * sizeof(float));
+        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Gatherv(&sub[0][0], n * np, MPI_FLOAT, (float *)a, counts, displs, MPI_FLOAT, 0, MPI_COMM_WORLD);
+    }
 
     // // to correct result
     // if (myid == 0)
@@ -275,5 +259,12 @@ void gaussEliminationMPIPipeline(float (*a)[n], int argc, char *argv[])
         cout << "time consuming: " << e_time - s_time << endl;
     }
 
+    if (myid == 0)
+        delete[] a;
+    delete[] sub;
+    delete[] tmp;
+    delete[] counts;
+    delete[] displs;
+    traceFinish();
     MPI_Finalize();
 }
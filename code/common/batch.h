@@ -0,0 +1,102 @@
+/**
+ * @file batch.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief gauss elimination of many small independent matrices, SIMD across matrices and spread over a thread pool
+ * @version 0.1
+ * @date 2022-07-22
+ *
+ * @copyright Copyright (c) 2022
+ * @details the engines vectorize along a row, at n = 4 to 64 a row fills one or two vectors at most and most of the
+ *          work is tails and loop overhead, and creating threads for one such matrix costs more than eliminating it.
+ *          here SIMD_BATCH matrices are interleaved into a group, element (i, j) of matrix w of the group is
+ *          group[(i * n + j) * SIMD_BATCH + w], so a vector holds the same element of SIMD_BATCH matrices and
+ *          simdBatchEliminate runs the serial algorithm on all of them at once, with no tails for any n. groups are
+ *          split evenly over the threads of a pool, a group is n * n * SIMD_BATCH floats and stays in L1 or L2.
+ *          lanes after the last matrix are filled with the identity, they eliminate without dividing by zero.
+ *
+ *          usage:
+ *              std::vector<float> groups(batchFloats(n, count));
+ *              batchPack(n, count, matrices, groups.data());   // count n x n row-major matrices one after another
+ *              batchEliminate(pool, n, count, groups.data());
+ *              batchUnpack(n, count, groups.data(), matrices);
+ *
+ */
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <vector>
+#include "simd.h"
+#include "threadPool.h"
+
+// groups holding count matrices
+static inline int batchGroups(int count)
+{
+    return (count + SIMD_BATCH - 1) / SIMD_BATCH;
+}
+
+// floats of the groups holding count n x n matrices
+static inline size_t batchFloats(int n, int count)
+{
+    return (size_t)batchGroups(count) * n * n * SIMD_BATCH;
+}
+
+// interleave count n x n matrices, stored one after another, into groups
+static inline void batchPack(int n, int count, const float *matrices, float *groups)
+{
+    size_t size = (size_t)n * n;
+    for (int g = 0; g < batchGroups(count); g++)
+    {
+        float *group = groups + g * size * SIMD_BATCH;
+        for (int w = 0; w < SIMD_BATCH; w++)
+        {
+            int m = g * SIMD_BATCH + w;
+            for (size_t e = 0; e < size; e++)
+                group[e * SIMD_BATCH + w] = m < count ? matrices[m * size + e] : (e % (n + 1) == 0 ? 1.0f : 0.0f);
+        }
+    }
+}
+
+// inverse of batchPack
+static inline void batchUnpack(int n, int count, const float *groups, float *matrices)
+{
+    size_t size = (size_t)n * n;
+    for (int m = 0; m < count; m++)
+    {
+        const float *group = groups + (size_t)(m / SIMD_BATCH) * size * SIMD_BATCH;
+        for (size_t e = 0; e < size; e++)
+            matrices[m * size + e] = group[e * SIMD_BATCH + m % SIMD_BATCH];
+    }
+}
+
+struct BatchParam
+{
+    int threadID;
+    int threads;
+    int n;
+    int groupCount;
+    float *groups;
+};
+
+// thread t eliminates groups [t * groupCount / threads, (t + 1) * groupCount / threads)
+static void *batchThread(void *param)
+{
+    BatchParam *p = static_cast<BatchParam *>(param);
+    size_t size = (size_t)p->n * p->n * SIMD_BATCH;
+    int begin = (int)((long long)p->threadID * p->groupCount / p->threads);
+    int end = (int)((long long)(p->threadID + 1) * p->groupCount / p->threads);
+    for (int g = begin; g < end; g++)
+        simdBatchEliminate(p->groups + g * size, p->n);
+    return NULL;
+}
+
+// eliminate the count matrices packed in groups on the threads of pool
+static inline void batchEliminate(ThreadPool &pool, int n, int count, float *groups)
+{
+    std::vector<BatchParam> params(pool.size());
+    for (int t = 0; t < pool.size(); t++)
+        params[t] = {t, pool.size(), n, batchGroups(count), groups};
+    pool.run(batchThread, params.data());
+}
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file cpus.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief cpus the gauss engines may run on
+ * @version 0.1
+ * @date 2022-07-26
+ *
+ * @copyright Copyright (c) 2022
+ * @details the online cpus of sysconf are not the cpus a process gets: taskset, cgroup cpusets and
+ *          mpirun --bind-to narrow the affinity mask. the pool pins its workers over these cpus, and whoever decides
+ *          between spinning and blocking or picks thread counts to try counts them, so that all agree on when
+ *          threads outnumber cpus.
+ *
+ *          usage:
+ *              std::vector<int> cpus = cpusAllowed();  // ids, e.g. to pin thread t to cpus[t % cpus.size()]
+ *              if (threads > cpusAllowedCount()) ...    // oversubscribed, block instead of spinning
+ *
+ *          linux only, like sched_getaffinity
+ *
+ */
+#ifndef CPUS_H
+#define CPUS_H
+
+#include <vector>
+#include <sched.h>
+#include <unistd.h>
+
+// cpus the calling thread may run on, all online cpus if the affinity cannot be read
+static inline std::vector<int> cpusAllowed()
+{
+    std::vector<int> cpus;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        for (int c = 0; c < CPU_SETSIZE; c++)
+        {
+            if (CPU_ISSET(c, &allowed))
+                cpus.push_back(c);
+        }
+    }
+    if (cpus.empty())
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int c = 0; c < (online > 1 ? online : 1); c++)
+            cpus.push_back(c);
+    }
+    return cpus;
+}
+
+// number of cpus the calling thread may run on, at least 1
+static inline int cpusAllowedCount()
+{
+    return (int)cpusAllowed().size();
+}
+
+#endif
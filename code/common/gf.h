@@ -0,0 +1,323 @@
+/**
+ * @file gf.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief arithmetic, vector kernels and row reduction of dense gauss elimination over a prime field GF(p), p < 2^31
+ * @version 0.1
+ * @date 2022-07-23
+ *
+ * @copyright Copyright (c) 2022
+ * @details rows are dense arrays of uint32_t in [0, p). the groebner engines reduce a row by the eliminator of its
+ *          leading (highest nonzero) column until it has none, an eliminator is monic, its leading element is 1.
+ *
+ *          reduction is delayed: gfReduceRow widens the row into 64-bit accumulators and a step only adds
+ *          factor * (p - e[j]) to every acc[j], which is congruent to subtracting factor * e[j] and never goes below
+ *          zero. no element is reduced in the hot loop, a sum stays below 2^64 for GFField::delay steps, after which
+ *          the accumulators are reduced once. columns the leading column search walks over are reduced on the way,
+ *          they are the only ones a step needs exactly. reduction is Barrett's: with m = floor((2^64 - 1) / p) the
+ *          quotient of x is the high half of x * m minus at most 2, so x mod p costs a 64 x 64 multiply and two
+ *          conditional subtractions instead of a division.
+ *
+ *          the step, acc[j] += factor * (p - e[j]), is a 32 x 32 -> 64 bit multiply-add and is vectorized like the
+ *          float kernels of simd.h, the backend is the one simd.h chose (SIMD_ISA picks both):
+ *              sse2 _mm_mul_epu32, avx2 _mm256_mul_epu32, avx512 _mm512_mul_epu32, neon vmlal_u32
+ *          delay is 3 steps for p near 2^31, over 10^9 for p < 2^16.
+ *
+ *          sparse lines are those of 消元子.txt with coefficients, columns in descending order, "col:coef" or a bare
+ *          "col" meaning coefficient 1, so GF(2) inputs are read as they are and rows over GF(2) are written alike.
+ *
+ *          usage:
+ *              GFField f = gfField(p);
+ *              gfParseLine(line, row, cols, f);                  // lead = gfLead(row, cols - 1)
+ *              lead = gfReduceRow(f, row, lead, acc, [&](int c) { return eliminator[c]; });   // nullptr if none
+ *              if (lead != -1) gfMakeMonic(f, row, lead);        // becomes the eliminator of lead
+ *              line = gfFormatLine(row, lead);
+ *
+ */
+#ifndef GF_H
+#define GF_H
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "simd.h"
+
+#define GF_DEFAULT_P 2147483647u // 2^31 - 1, largest prime below 2^31
+
+typedef struct GFField
+{
+    uint32_t p;       // prime modulus, p < 2^31
+    uint64_t barrett; // floor((2^64 - 1) / p)
+    int delay;        // steps an accumulator reduced below p takes without overflow
+} GFField;
+
+static inline GFField gfField(uint32_t p)
+{
+    GFField f;
+    f.p = p;
+    f.barrett = UINT64_MAX / p;
+    uint64_t step = (uint64_t)(p - 1) * p;                   // most a step adds
+    uint64_t steps = step == 0 ? 1 : (UINT64_MAX - (p - 1)) / step; // p - 1 is the most left after a reduction
+    f.delay = steps > (1u << 30) ? (1 << 30) : (int)steps;
+    return f;
+}
+
+// x mod p
+static inline uint32_t gfReduce(const GFField &f, uint64_t x)
+{
+    uint64_t q = (uint64_t)(((unsigned __int128)x * f.barrett) >> 64);
+    uint64_t r = x - q * f.p;
+    if (r >= f.p)
+        r -= f.p;
+    if (r >= f.p)
+        r -= f.p;
+    return (uint32_t)r;
+}
+
+static inline uint32_t gfMul(const GFField &f, uint32_t a, uint32_t b)
+{
+    return gfReduce(f, (uint64_t)a * b);
+}
+
+// a^(p-2) = 1 / a for a != 0, p prime
+static inline uint32_t gfInverse(const GFField &f, uint32_t a)
+{
+    uint32_t result = 1;
+    for (uint32_t e = f.p - 2; e > 0; e >>= 1)
+    {
+        if (e & 1)
+            result = gfMul(f, result, a);
+        a = gfMul(f, a, a);
+    }
+    return result;
+}
+
+typedef void (*GFAccumulateFunc)(uint64_t *acc, const uint32_t *row, int end, uint32_t factor, uint32_t p);
+
+typedef struct GFKernels
+{
+    const char *name;            // same as the SimdKernels backend
+    GFAccumulateFunc accumulate; // acc[j] += factor * (p - row[j]) for j in [0, end)
+} GFKernels;
+
+//===scalar======================================================================================================================
+static void gfAccumulateScalar(uint64_t *acc, const uint32_t *row, int end, uint32_t factor, uint32_t p)
+{
+    for (int j = 0; j < end; j++)
+        acc[j] += (uint64_t)factor * (p - row[j]);
+}
+
+#ifdef SIMD_X86
+//===sse2======================================================================================================================
+__attribute__((target("sse2"))) static void gfAccumulateSSE2(uint64_t *acc, const uint32_t *row, int end,
+                                                             uint32_t factor, uint32_t p)
+{
+    __m128i vf = _mm_set1_epi32((int)factor), vp = _mm_set1_epi32((int)p), zero = _mm_setzero_si128();
+    int j = 0;
+    for (; j + 4 <= end; j += 4)
+    {
+        __m128i ve = _mm_sub_epi32(vp, _mm_loadu_si128((const __m128i *)(row + j))); // in (0, p], no wrap
+        __m128i lo = _mm_mul_epu32(vf, _mm_unpacklo_epi32(ve, zero));
+        __m128i hi = _mm_mul_epu32(vf, _mm_unpackhi_epi32(ve, zero));
+        _mm_storeu_si128((__m128i *)(acc + j), _mm_add_epi64(_mm_loadu_si128((__m128i *)(acc + j)), lo));
+        _mm_storeu_si128((__m128i *)(acc + j + 2), _mm_add_epi64(_mm_loadu_si128((__m128i *)(acc + j + 2)), hi));
+    }
+    for (; j < end; j++)
+        acc[j] += (uint64_t)factor * (p - row[j]);
+}
+
+//===avx2======================================================================================================================
+__attribute__((target("avx2"))) static void gfAccumulateAVX2(uint64_t *acc, const uint32_t *row, int end,
+                                                             uint32_t factor, uint32_t p)
+{
+    __m256i vf = _mm256_set1_epi64x(factor), vp = _mm256_set1_epi64x(p);
+    int j = 0;
+    for (; j + 8 <= end; j += 8) // two independent chains
+    {
+        __m256i e0 = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(row + j)));
+        __m256i e1 = _mm256_cvtepu32_epi64(_mm_loadu_si128((const __m128i *)(row + j + 4)));
+        __m256i v0 = _mm256_mul_epu32(vf, _mm256_sub_epi64(vp, e0));
+        __m256i v1 = _mm256_mul_epu32(vf, _mm256_sub_epi64(vp, e1));
+        _mm256_storeu_si256((__m256i *)(acc + j), _mm256_add_epi64(_mm256_loadu_si256((__m256i *)(acc + j)), v0));
+        _mm256_storeu_si256((__m256i *)(acc + j + 4),
+                            _mm256_add_epi64(_mm256_loadu_si256((__m256i *)(acc + j + 4)), v1));
+    }
+    for (; j < end; j++)
+        acc[j] += (uint64_t)factor * (p - row[j]);
+}
+
+//===avx512======================================================================================================================
+// the maskz forms with a full mask keep GCC from warning about the undefined source operand of the plain ones
+__attribute__((target("avx512f"))) static void gfAccumulateAVX512(uint64_t *acc, const uint32_t *row, int end,
+                                                                  uint32_t factor, uint32_t p)
+{
+    __m512i vf = _mm512_set1_epi64(factor), vp = _mm512_set1_epi64(p);
+    int j = 0;
+    for (; j + 8 <= end; j += 8)
+    {
+        __m512i e = _mm512_maskz_cvtepu32_epi64(0xFF, _mm256_loadu_si256((const __m256i *)(row + j)));
+        __m512i v = _mm512_maskz_mul_epu32(0xFF, vf, _mm512_sub_epi64(vp, e));
+        _mm512_storeu_si512(acc + j, _mm512_add_epi64(_mm512_loadu_si512(acc + j), v));
+    }
+    for (; j < end; j++)
+        acc[j] += (uint64_t)factor * (p - row[j]);
+}
+#endif
+
+#ifdef SIMD_NEON
+//===neon======================================================================================================================
+static void gfAccumulateNEON(uint64_t *acc, const uint32_t *row, int end, uint32_t factor, uint32_t p)
+{
+    uint32x2_t vf = vdup_n_u32(factor);
+    uint32x4_t vp = vdupq_n_u32(p);
+    int j = 0;
+    for (; j + 4 <= end; j += 4)
+    {
+        uint32x4_t ve = vsubq_u32(vp, vld1q_u32(row + j));
+        vst1q_u64(acc + j, vmlal_u32(vld1q_u64(acc + j), vf, vget_low_u32(ve)));
+        vst1q_u64(acc + j + 2, vmlal_u32(vld1q_u64(acc + j + 2), vf, vget_high_u32(ve)));
+    }
+    for (; j < end; j++)
+        acc[j] += (uint64_t)factor * (p - row[j]);
+}
+#endif
+
+//===dispatch======================================================================================================================
+static const GFKernels gfBackends[] = {
+#ifdef SIMD_X86
+    {"avx512", gfAccumulateAVX512},
+    {"avx2", gfAccumulateAVX2},
+    {"sse2", gfAccumulateSSE2},
+#endif
+#ifdef SIMD_NEON
+    {"neon", gfAccumulateNEON},
+#endif
+    {"scalar", gfAccumulateScalar},
+};
+
+// backend of the same name as the one simd.h uses
+static inline const GFKernels &gfKernels()
+{
+    static const GFKernels *kernels = []() {
+        const int count = sizeof(gfBackends) / sizeof(GFKernels);
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(gfBackends[i].name, simdIsa()) == 0)
+                return &gfBackends[i];
+        }
+        return &gfBackends[count - 1];
+    }();
+    return *kernels;
+}
+
+//===rows======================================================================================================================
+// acc[j] += factor * (p - row[j]) for j in [0, end), congruent to acc[j] -= factor * row[j]
+static inline void gfAccumulate(uint64_t *acc, const uint32_t *row, int end, uint32_t factor, uint32_t p)
+{
+    gfKernels().accumulate(acc, row, end, factor, p);
+}
+
+// highest column of [0, from] whose element is not 0, -1 if none
+static inline int gfLead(const uint32_t *row, int from)
+{
+    for (int j = from; j >= 0; j--)
+    {
+        if (row[j] != 0)
+            return j;
+    }
+    return -1;
+}
+
+// highest column of acc[0, from] not congruent to 0, the columns walked over are reduced, -1 if none
+static inline int gfLeadReduce(const GFField &f, uint64_t *acc, int from)
+{
+    for (int j = from; j >= 0; j--)
+    {
+        acc[j] = gfReduce(f, acc[j]);
+        if (acc[j] != 0)
+            return j;
+    }
+    return -1;
+}
+
+/**
+ * @brief reduce row, whose leading column is lead, by eliminatorOf(c) while its leading column c has an eliminator
+ *
+ * @param row reduced in place, columns above the returned lead become 0
+ * @param lead leading column of row, -1 for a zero row
+ * @param acc scratch of at least lead + 1 accumulators
+ * @param eliminatorOf monic row with leading column c, or nullptr when c has none
+ * @return leading column left, -1 if row was reduced to 0
+ */
+template <class Lookup>
+static inline int gfReduceRow(const GFField &f, uint32_t *row, int lead, uint64_t *acc, Lookup eliminatorOf)
+{
+    if (lead < 0 || eliminatorOf(lead) == nullptr)
+        return lead;
+    int top = lead;
+    for (int j = 0; j <= top; j++)
+        acc[j] = row[j];
+    int pending = 0; // steps since acc was last reduced
+    const uint32_t *eliminator;
+    while (lead >= 0 && (eliminator = eliminatorOf(lead)) != nullptr)
+    {
+        if (pending == f.delay)
+        {
+            for (int j = 0; j < lead; j++)
+                acc[j] = gfReduce(f, acc[j]);
+            pending = 0;
+        }
+        gfAccumulate(acc, eliminator, lead, (uint32_t)acc[lead], f.p); // acc[lead] was reduced by gfLeadReduce
+        acc[lead] = 0;
+        pending++;
+        lead = gfLeadReduce(f, acc, lead - 1);
+    }
+    for (int j = 0; j <= top; j++)
+        row[j] = j <= lead ? gfReduce(f, acc[j]) : 0;
+    return lead;
+}
+
+// scale row so that row[lead] = 1
+static inline void gfMakeMonic(const GFField &f, uint32_t *row, int lead)
+{
+    uint32_t inverse = gfInverse(f, row[lead]);
+    for (int j = 0; j <= lead; j++)
+        row[j] = gfMul(f, row[j], inverse);
+}
+
+//===sparse lines======================================================================================================================
+// fill row[0, cols) from a line of descending "col:coef" or "col" tokens, coefficients are taken mod p
+static inline void gfParseLine(const std::string &line, uint32_t *row, int cols, const GFField &f)
+{
+    memset(row, 0, cols * sizeof(uint32_t));
+    std::stringstream ss(line);
+    std::string token;
+    while (ss >> token)
+    {
+        size_t colon = token.find(':');
+        int col = atoi(token.c_str());
+        long long coef = colon == std::string::npos ? 1 : atoll(token.c_str() + colon + 1);
+        if (col < 0 || col >= cols)
+            continue;
+        coef %= (long long)f.p;
+        row[col] = (uint32_t)(coef < 0 ? coef + f.p : coef);
+    }
+}
+
+// line of row[0, lead] in the format gfParseLine reads, coefficient 1 is written as a bare column
+static inline std::string gfFormatLine(const uint32_t *row, int lead)
+{
+    std::stringstream ss;
+    for (int j = lead; j >= 0; j--)
+    {
+        if (row[j] == 0)
+            continue;
+        ss << j;
+        if (row[j] != 1)
+            ss << ':' << row[j];
+        ss << ' ';
+    }
+    return ss.str();
+}
+
+#endif
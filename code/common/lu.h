@@ -0,0 +1,197 @@
+/**
+ * @file lu.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief LU factorization kept for reuse and batched triangular solves of many right-hand sides
+ * @version 0.1
+ * @date 2022-07-21
+ *
+ * @copyright Copyright (c) 2022
+ * @details the gauss engines turn a into an upper triangular matrix with unit diagonal and throw the multipliers
+ *          away (a[i][k] = 0), so every system costs a whole O(n^3) elimination. luFactor does the same elimination
+ *          with partial pivoting but keeps what a solve needs, in place of a:
+ *              a[i][j], j > i   U, unit upper triangular, its diagonal of ones is not stored
+ *              a[i][j], j <= i  L, lower triangular, a[i][i] is the pivot row i was divided by
+ *              perm[i]          row of the original matrix that became row i, so P * A = L * U
+ *          a solve is then a forward substitution L * y = P * b and a back substitution U * x = y, O(n^2) per
+ *          right-hand side.
+ *
+ *          luSolve takes m right-hand sides at once, stored as the columns of b: row i of b, ldb floats long, holds
+ *          element i of every right-hand side. a step of the substitutions is then row[j] -= factor * pivotRow[j]
+ *          across the batch, which the simd.h micro-kernels vectorize two steps per pass. the batch is cut into
+ *          blocks of LU_SOLVE_COLS columns, n x LU_SOLVE_COLS floats stay in L2 through both substitutions and L and
+ *          U are read once per block. blocks are independent, pool threads take them in turn and never wait for
+ *          each other. b is overwritten by the solutions.
+ *
+ *          usage:
+ *              std::vector<int> perm;
+ *              if (!luFactor(n, a, perm)) ...                  // singular, once per matrix
+ *              luSolve(pool, n, a, perm, b, ldb, m);           // as often as new right-hand sides come
+ *
+ */
+#ifndef LU_H
+#define LU_H
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "matrix.h"
+#include "simd.h"
+#include "threadPool.h"
+
+#define LU_SOLVE_COLS 64 // right-hand sides solved together by a thread, a multiple of every simd width
+
+// factor a in place into L and U with partial pivoting, false when a is singular
+static inline bool luFactor(int n, Matrix<float> &a, std::vector<int> &perm)
+{
+    float factors[SIMD_MAX_ROWS];
+    perm.resize(n);
+    for (int i = 0; i < n; i++)
+        perm[i] = i;
+    for (int k = 0; k < n; k++)
+    {
+        int p = k;
+        for (int i = k + 1; i < n; i++)
+        {
+            if (fabs(a[i][k]) > fabs(a[p][k]))
+                p = i;
+        }
+        if (a[p][k] == 0)
+            return false;
+        if (p != k)
+        {
+            // whole rows, multipliers of earlier steps move with their row
+            for (int j = 0; j < n; j++)
+            {
+                float t = a[k][j];
+                a[k][j] = a[p][j];
+                a[p][j] = t;
+            }
+            int t = perm[k];
+            perm[k] = perm[p];
+            perm[p] = t;
+        }
+
+        const float *pivotRow = a[k];
+        simdDivide(a[k], k + 1, n, a[k][k]); // a[k][k] stays, it is L[k][k]
+        for (int r0 = k + 1; r0 < n; r0 += SIMD_MAX_ROWS)
+        {
+            int group = n - r0 < SIMD_MAX_ROWS ? n - r0 : SIMD_MAX_ROWS;
+            for (int r = 0; r < group; r++)
+                factors[r] = a[r0 + r][k]; // stays as L[i][k] instead of becoming 0
+            simdEliminateRows(a.rows() + r0, &pivotRow, 1, factors, group, k + 1, n);
+        }
+    }
+    return true;
+}
+
+// rows[i] = rows[perm[i]] in columns [begin, end), moved along the cycles of perm, tmp holds end - begin floats
+static inline void luPermuteRows(int n, const int *perm, float *const *rows, int begin, int end, float *tmp,
+                                 std::vector<bool> &placed)
+{
+    placed.assign(n, false);
+    for (int i = 0; i < n; i++)
+    {
+        if (placed[i] || perm[i] == i)
+            continue;
+        memcpy(tmp, rows[i] + begin, (end - begin) * sizeof(float));
+        int j = i;
+        while (perm[j] != i)
+        {
+            memcpy(rows[j] + begin, rows[perm[j]] + begin, (end - begin) * sizeof(float));
+            placed[j] = true;
+            j = perm[j];
+        }
+        memcpy(rows[j] + begin, tmp, (end - begin) * sizeof(float));
+        placed[j] = true;
+    }
+}
+
+// L * y = b in columns [begin, end), two steps per pass: rows k and k + 1 are finished first, then every row below
+// takes both of them
+static inline void luForward(int n, const Matrix<float> &lu, float *const *rows, int begin, int end)
+{
+    float factors[SIMD_MAX_ROWS * 2];
+    int k = 0;
+    for (; k + 1 < n; k += 2)
+    {
+        simdDivide(rows[k], begin, end, lu[k][k]);
+        simdEliminate(rows[k + 1], rows[k], begin, end, lu[k + 1][k]);
+        simdDivide(rows[k + 1], begin, end, lu[k + 1][k + 1]);
+        const float *pivotRows[2] = {rows[k], rows[k + 1]};
+        for (int r0 = k + 2; r0 < n; r0 += SIMD_MAX_ROWS)
+        {
+            int group = n - r0 < SIMD_MAX_ROWS ? n - r0 : SIMD_MAX_ROWS;
+            for (int r = 0; r < group; r++)
+            {
+                factors[r * 2] = lu[r0 + r][k];
+                factors[r * 2 + 1] = lu[r0 + r][k + 1];
+            }
+            simdEliminateRows(rows + r0, pivotRows, 2, factors, group, begin, end);
+        }
+    }
+    if (k < n)
+        simdDivide(rows[k], begin, end, lu[k][k]);
+}
+
+// U * x = y in columns [begin, end), unit diagonal, two steps per pass from the last row up
+static inline void luBackward(int n, const Matrix<float> &lu, float *const *rows, int begin, int end)
+{
+    float factors[SIMD_MAX_ROWS * 2];
+    for (int k = n - 1; k > 0; k -= 2)
+    {
+        simdEliminate(rows[k - 1], rows[k], begin, end, lu[k - 1][k]);
+        const float *pivotRows[2] = {rows[k], rows[k - 1]};
+        for (int r0 = 0; r0 < k - 1; r0 += SIMD_MAX_ROWS)
+        {
+            int group = k - 1 - r0 < SIMD_MAX_ROWS ? k - 1 - r0 : SIMD_MAX_ROWS;
+            for (int r = 0; r < group; r++)
+            {
+                factors[r * 2] = lu[r0 + r][k];
+                factors[r * 2 + 1] = lu[r0 + r][k - 1];
+            }
+            simdEliminateRows(rows + r0, pivotRows, 2, factors, group, begin, end);
+        }
+    }
+}
+
+struct LUSolveParam
+{
+    int threadID;
+    int threads;
+    int n;
+    int m;                    // columns of b
+    const Matrix<float> *lu;
+    const int *perm;
+    float *const *rows;       // rows[i] is row i of b
+};
+
+// thread t solves column blocks t, t + threads, ...
+static void *luSolveThread(void *param)
+{
+    LUSolveParam *p = static_cast<LUSolveParam *>(param);
+    std::vector<float> tmp(LU_SOLVE_COLS);
+    std::vector<bool> placed;
+    for (int begin = p->threadID * LU_SOLVE_COLS; begin < p->m; begin += p->threads * LU_SOLVE_COLS)
+    {
+        int end = begin + LU_SOLVE_COLS < p->m ? begin + LU_SOLVE_COLS : p->m;
+        luPermuteRows(p->n, p->perm, p->rows, begin, end, tmp.data(), placed);
+        luForward(p->n, *p->lu, p->rows, begin, end);
+        luBackward(p->n, *p->lu, p->rows, begin, end);
+    }
+    return NULL;
+}
+
+// solve A * x = b for the m columns of b with the factors of luFactor, b is overwritten by x
+static inline void luSolve(ThreadPool &pool, int n, const Matrix<float> &lu, const std::vector<int> &perm, float *b,
+                           int ldb, int m)
+{
+    std::vector<float *> rows(n);
+    for (int i = 0; i < n; i++)
+        rows[i] = b + (size_t)i * ldb;
+    std::vector<LUSolveParam> params(pool.size());
+    for (int t = 0; t < pool.size(); t++)
+        params[t] = {t, pool.size(), n, m, &lu, perm.data(), rows.data()};
+    pool.run(luSolveThread, params.data());
+}
+
+#endif
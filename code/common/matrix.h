@@ -0,0 +1,180 @@
+/**
+ * @file matrix.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief runtime-sized dense matrix of gauss elimination
+ * @version 0.1
+ * @date 2022-07-12
+ *
+ * @copyright Copyright (c) 2022
+ * @details Matrix<T> holds n x n elements on the heap. n is chosen at runtime, so memory follows n instead of a
+ *          compile-time MAX_N and no rebuild is needed for larger systems. every row starts on a MATRIX_ALIGN byte
+ *          boundary. a[i] is the address of row i, so kernels written against float a[][MAX_N] keep their a[i][j],
+ *          and a.rows() is a table of row addresses for the simd.h micro-kernels.
+ *
+ *          the stride is n rounded up to a cache line plus padLines more lines. with n a power of two, rows i and
+ *          i + 1 of an unpadded matrix are 2^k bytes apart, so a[i][j] and a[k][j] fall into the same L1 set and
+ *          agree in the low 12 address bits (4K aliasing stalls a load behind an older store to a[i][j]). padding
+ *          shifts every row by padLines lines against the previous one. storage may be backed by 2MB transparent
+ *          huge pages, which saves TLB misses when one elimination step walks n rows. both are tunable per matrix or
+ *          for all matrices by environment variables, e.g. MATRIX_PAD=2 MATRIX_HUGEPAGE=1 ./test:
+ *              MATRIX_PAD       cache lines added to every row, MATRIX_PAD_LINES if not set, 0 for no padding
+ *              MATRIX_HUGEPAGE  1 to ask for huge pages, the kernel falls back to 4K pages when it has none
+ *          matrixBench.cpp compares strides and page sizes.
+ *
+ *          kernels may be specialized for the sizes benchmarks use most. matrixDispatch calls a kernel with
+ *          MatrixSize<n> when n is one of MATRIX_FIXED_SIZES and with MatrixSize<0> otherwise, matrixSize<N>(n) then
+ *          gives n as a compile-time constant to the specialized loops, so their trip counts are constexpr:
+ *              template <int N> void kernel(MatrixSize<N>, int n, Matrix<float> &a)
+ *              {
+ *                  n = matrixSize<N>(n);
+ *                  for (int k = 0; k < n; k++) ...
+ *              }
+ *              matrixDispatch(n, [&](auto size) { kernel(size, n, a); });
+ *
+ */
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+
+#define MATRIX_ALIGN 64            // bytes, one cache line and one avx512 vector
+#define MATRIX_PAD_LINES 1         // cache lines added to every row by default
+#define MATRIX_HUGE_PAGE (2 << 20) // bytes of a transparent huge page on x86 and aarch64
+
+// cache lines every row is padded by, from MATRIX_PAD
+static inline int matrixPadLines()
+{
+    const char *pad = getenv("MATRIX_PAD");
+    if (pad == nullptr || *pad == '\0')
+        return MATRIX_PAD_LINES;
+    return atoi(pad) > 0 ? atoi(pad) : 0;
+}
+
+// whether matrices ask for huge pages, from MATRIX_HUGEPAGE
+static inline bool matrixHugePages()
+{
+    const char *huge = getenv("MATRIX_HUGEPAGE");
+    return huge != nullptr && atoi(huge) > 0;
+}
+
+template <int N>
+struct MatrixSize
+{
+    static const int value = N; // 0 when size is only known at runtime
+};
+
+// n of a kernel specialized by MatrixSize<N>, a constant when N > 0
+template <int N>
+static inline constexpr int matrixSize(int n)
+{
+    return N > 0 ? N : n;
+}
+
+// call kernel(MatrixSize<n>()) for n in MATRIX_FIXED_SIZES and kernel(MatrixSize<0>()) for other n
+template <class Kernel>
+static inline void matrixDispatch(int n, Kernel kernel)
+{
+    switch (n) // MATRIX_FIXED_SIZES
+    {
+    case 256:
+        kernel(MatrixSize<256>());
+        break;
+    case 512:
+        kernel(MatrixSize<512>());
+        break;
+    case 1024:
+        kernel(MatrixSize<1024>());
+        break;
+    case 2048:
+        kernel(MatrixSize<2048>());
+        break;
+    default:
+        kernel(MatrixSize<0>());
+        break;
+    }
+}
+
+/**
+ * @brief n x n matrix on the heap with rows aligned to MATRIX_ALIGN bytes and padded by padLines cache lines,
+ *        zeroed on construction
+ *
+ */
+template <typename T>
+class Matrix
+{
+public:
+    explicit Matrix(int n, int padLines = matrixPadLines(), bool hugePages = matrixHugePages())
+        : order(n), rowStride(strideOf(n, padLines)), elements(nullptr), rowTable(n)
+    {
+        void *memory = nullptr;
+        size_t bytes = (size_t)n * rowStride * sizeof(T);
+        size_t align = MATRIX_ALIGN;
+        if (hugePages)
+        {
+            align = MATRIX_HUGE_PAGE; // a huge page can only back a 2MB aligned range
+            bytes = (bytes + MATRIX_HUGE_PAGE - 1) / MATRIX_HUGE_PAGE * MATRIX_HUGE_PAGE;
+        }
+        if (posix_memalign(&memory, align, bytes > 0 ? bytes : MATRIX_ALIGN) != 0)
+            throw std::bad_alloc();
+        elements = static_cast<T *>(memory);
+        if (hugePages && bytes > 0)
+            madvise(memory, bytes, MADV_HUGEPAGE); // only a hint, fails quietly when huge pages are off
+        memset(elements, 0, bytes);
+        for (int i = 0; i < n; i++)
+            rowTable[i] = elements + (size_t)i * rowStride;
+    }
+
+    ~Matrix()
+    {
+        free(elements);
+    }
+
+    Matrix(const Matrix &) = delete;
+    Matrix &operator=(const Matrix &) = delete;
+
+    T *operator[](int i)
+    {
+        return elements + (size_t)i * rowStride;
+    }
+
+    const T *operator[](int i) const
+    {
+        return elements + (size_t)i * rowStride;
+    }
+
+    // rows()[i] == (*this)[i]
+    T *const *rows() const
+    {
+        return rowTable.data();
+    }
+
+    int size() const
+    {
+        return order;
+    }
+
+    // elements between starts of two rows
+    int stride() const
+    {
+        return rowStride;
+    }
+
+    // element count per row rounded up to MATRIX_ALIGN bytes, plus padLines cache lines
+    static int strideOf(int n, int padLines = 0)
+    {
+        const int perLine = MATRIX_ALIGN / sizeof(T) > 0 ? MATRIX_ALIGN / sizeof(T) : 1;
+        return (n + perLine - 1) / perLine * perLine + padLines * perLine;
+    }
+
+private:
+    int order;
+    int rowStride;
+    T *elements;
+    std::vector<T *> rowTable;
+};
+
+#endif
@@ -0,0 +1,127 @@
+/**
+ * @file matrixBench.cpp
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief benchmark of padded row strides and huge pages of matrix.h
+ * @version 0.1
+ * @date 2022-07-13
+ *
+ * @copyright Copyright (c) 2022
+ * @details for every n, padding and page size, times a whole gauss elimination in two ways:
+ *              one-row: simdEliminate on every row, a[i] and a[k] are walked together, as in the pthread and OpenMP
+ *                       engines
+ *              scalar:  plain a[i][j] -= a[i][k] * a[k][j] loops as in the serial algorithm, compiled as they are
+ *          and reports seconds, GFLOP/s (2n^3/3 flops) and speedup against the unpadded stride with the same page size.
+ *          every measurement is the best of REPEATS runs on the same matrix.
+ *
+ *          build: g++ -O2 -o matrixBench matrixBench.cpp
+ *          run:   ./matrixBench [largest n = 2048] [largest padding in lines = 4]
+ *                 n runs over powers of two from 256 and n - 8 next to each, padding over 0, 1, 2, 4, ...
+ *
+ */
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "matrix.h"
+#include "simd.h"
+using namespace std;
+
+#define REPEATS 3 // runs of every measurement, the best is kept
+
+// diagonally dominant, so elimination neither overflows nor needs pivoting
+static void fill(Matrix<float> &a, int n)
+{
+    srand(1);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+            a[i][j] = rand() / (float)RAND_MAX + (i == j ? n : 0);
+    }
+}
+
+static void eliminateOneRow(Matrix<float> &a, int n)
+{
+    for (int k = 0; k < n; k++)
+    {
+        simdDivide(a[k], k + 1, n, a[k][k]);
+        a[k][k] = 1.0;
+        for (int i = k + 1; i < n; i++)
+        {
+            simdEliminate(a[i], a[k], k + 1, n, a[i][k]);
+            a[i][k] = 0;
+        }
+    }
+}
+
+static void eliminateScalar(Matrix<float> &a, int n)
+{
+    for (int k = 0; k < n; k++)
+    {
+        for (int j = k + 1; j < n; j++)
+            a[k][j] /= a[k][k];
+        a[k][k] = 1.0;
+        for (int i = k + 1; i < n; i++)
+        {
+            for (int j = k + 1; j < n; j++)
+                a[i][j] -= a[i][k] * a[k][j];
+            a[i][k] = 0;
+        }
+    }
+}
+
+// best seconds of REPEATS eliminations by kernel on an n x n matrix padded by padLines
+static double eliminateSeconds(void (*kernel)(Matrix<float> &, int), int n, int padLines, bool hugePages)
+{
+    Matrix<float> a(n, padLines, hugePages);
+    double best = 0;
+    for (int r = 0; r < REPEATS; r++)
+    {
+        fill(a, n);
+        auto start = chrono::steady_clock::now();
+        kernel(a, n);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        best = (r == 0 || seconds < best) ? seconds : best;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    int maxN = argc > 1 ? atoi(argv[1]) : 2048;
+    int maxPad = argc > 2 ? atoi(argv[2]) : 4;
+    vector<int> sizes, pads = {0};
+    for (int n = 256; n <= maxN; n *= 2)
+    {
+        sizes.push_back(n - 8);
+        sizes.push_back(n);
+    }
+    for (int pad = 1; pad <= maxPad; pad *= 2)
+        pads.push_back(pad);
+
+    cout << "isa: " << simdIsa() << endl;
+    cout << fixed << setprecision(3);
+    cout << "   n  pad  stride(B)  huge |  one-row s  GFLOP/s  speedup |  scalar s  GFLOP/s  speedup" << endl;
+    for (int n : sizes)
+    {
+        double flops = 2.0 * n * n * n / 3;
+        for (bool huge : {false, true})
+        {
+            double oneRowBase = 0, scalarBase = 0;
+            for (int pad : pads)
+            {
+                double oneRow = eliminateSeconds(eliminateOneRow, n, pad, huge);
+                double scalar = eliminateSeconds(eliminateScalar, n, pad, huge);
+                if (pad == 0)
+                {
+                    oneRowBase = oneRow;
+                    scalarBase = scalar;
+                }
+                cout << setw(4) << n << setw(5) << pad << setw(11) << Matrix<float>::strideOf(n, pad) * sizeof(float)
+                     << setw(6) << (huge ? "yes" : "no") << " |" << setw(11) << oneRow << setw(9)
+                     << flops / oneRow / 1e9 << setw(9) << oneRowBase / oneRow << " |" << setw(10) << scalar
+                     << setw(9) << flops / scalar / 1e9 << setw(9) << scalarBase / scalar << endl;
+            }
+        }
+    }
+    return 0;
+}
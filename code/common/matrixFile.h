@@ -0,0 +1,128 @@
+/**
+ * @file matrixFile.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief binary matrix files of the gauss engines, mmap loading and MPI-IO reading of row sets
+ * @version 0.1
+ * @date 2022-07-20
+ *
+ * @copyright Copyright (c) 2022
+ * @details matrices used to be text files of whitespace separated floats parsed through a stringstream, which at
+ *          n = 4096 took longer than the elimination. a binary file is a MATRIX_FILE_HEADER byte header followed by
+ *          n x n floats in row-major order, so row i starts at byte MATRIX_FILE_HEADER + i * n * 4:
+ *              bytes 0..7   magic "GAUSSMAT"
+ *              bytes 8..11  n, int32
+ *              bytes 12..15 bytes of an element, 4 for float
+ *              rest         zero up to MATRIX_FILE_HEADER
+ *          files are in the byte order of the machine that wrote them.
+ *
+ *          matrixFileLoad maps the file and copies rows to memory of any row stride, matrixFileSave writes one.
+ *          when mpi.h is included before this header, matrixFileReadRows reads only the rows a processor owns with
+ *          one collective MPI_File_read_at_all, straight into its local storage:
+ *              if (myid == 0 && !matrixFileValid(path, n))
+ *                  ...generate and matrixFileSave(path, a, n, n);
+ *              MPI_Barrier(MPI_COMM_WORLD);
+ *              matrixFileReadRows(MPI_COMM_WORLD, path, n, first, np, np, 1, &sub[0][0], np); // rows [first, first + np)
+ *              // or blocks of block_size rows every num * block_size rows, placed alike in a full size frame
+ *              matrixFileReadRows(MPI_COMM_WORLD, path, n, myid * block_size, block_size, num * block_size,
+ *                                 n / block_size / num, &a[myid * block_size][0], num * block_size);
+ *
+ */
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MATRIX_FILE_HEADER 64        // bytes before the first row
+#define MATRIX_FILE_MAGIC "GAUSSMAT" // first 8 bytes of a matrix file
+
+struct MatrixFileHeader
+{
+    char magic[8];
+    int32_t n;
+    int32_t elementSize;
+};
+
+// whether path is a matrix file of n x n floats
+static inline bool matrixFileValid(const char *path, int n)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    MatrixFileHeader header;
+    struct stat info;
+    bool valid = read(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) && fstat(fd, &info) == 0 &&
+                 memcmp(header.magic, MATRIX_FILE_MAGIC, 8) == 0 && header.n == n &&
+                 header.elementSize == (int32_t)sizeof(float) &&
+                 info.st_size >= (off_t)(MATRIX_FILE_HEADER + (size_t)n * n * sizeof(float));
+    close(fd);
+    return valid;
+}
+
+// copy the n x n matrix of path to a, rows rowStride floats apart, false if path is no such file
+static inline bool matrixFileLoad(const char *path, float *a, int n, int rowStride)
+{
+    if (!matrixFileValid(path, n))
+        return false;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    size_t bytes = MATRIX_FILE_HEADER + (size_t)n * n * sizeof(float);
+    void *map = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+    madvise(map, bytes, MADV_SEQUENTIAL);
+    const float *rows = reinterpret_cast<const float *>(static_cast<const char *>(map) + MATRIX_FILE_HEADER);
+    for (int i = 0; i < n; i++)
+        memcpy(a + (size_t)i * rowStride, rows + (size_t)i * n, n * sizeof(float));
+    munmap(map, bytes);
+    return true;
+}
+
+// write the n x n matrix a, rows rowStride floats apart, to path
+static inline bool matrixFileSave(const char *path, const float *a, int n, int rowStride)
+{
+    FILE *file = fopen(path, "wb");
+    if (file == nullptr)
+        return false;
+    char header[MATRIX_FILE_HEADER] = {0};
+    MatrixFileHeader fields = {{0}, n, (int32_t)sizeof(float)};
+    memcpy(fields.magic, MATRIX_FILE_MAGIC, 8);
+    memcpy(header, &fields, sizeof(fields));
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    for (int i = 0; ok && i < n; i++)
+        ok = fwrite(a + (size_t)i * rowStride, sizeof(float), n, file) == (size_t)n;
+    return fclose(file) == 0 && ok;
+}
+
+#ifdef MPI_VERSION
+// collective over comm: read blocks of blockRows rows, the b-th starting at row first + b * blockStep, to
+// dst + b * dstStep * n, every processor passing its own row set. the file must be valid on every processor
+static inline bool matrixFileReadRows(MPI_Comm comm, const char *path, int n, int first, int blockRows, int blockStep,
+                                      int blocks, float *dst, int dstStep)
+{
+    MPI_File file;
+    if (MPI_File_open(comm, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+        return false;
+    MPI_Datatype fileType, memType;
+    MPI_Type_vector(blocks, blockRows * n, blockStep * n, MPI_FLOAT, &fileType);
+    MPI_Type_vector(blocks, blockRows * n, dstStep * n, MPI_FLOAT, &memType);
+    MPI_Type_commit(&fileType);
+    MPI_Type_commit(&memType);
+    MPI_Offset disp = MATRIX_FILE_HEADER + (MPI_Offset)first * n * sizeof(float);
+    MPI_File_set_view(file, disp, MPI_FLOAT, fileType, "native", MPI_INFO_NULL);
+    int ok = MPI_File_read_at_all(file, 0, dst, blocks > 0 ? 1 : 0, memType, MPI_STATUS_IGNORE) == MPI_SUCCESS;
+    MPI_Type_free(&fileType);
+    MPI_Type_free(&memType);
+    MPI_File_close(&file);
+    return ok;
+}
+#endif
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * @file matrixGen.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief reproducible test matrices from a counter-based generator, any row generated on its own
+ * @version 0.1
+ * @date 2022-07-25
+ *
+ * @copyright Copyright (c) 2022
+ * @details initMatrix and m_reset drew every element from rand() seeded with time(0) and then added 10 n random
+ *          rows to each other one after another, so no two runs had the same matrix and nothing of it could be
+ *          made in parallel. here every random number is Philox4x32-10 of a counter, a pure function of the seed
+ *          and of where the number is used, and the matrix is A = L * U with
+ *              U[k][k] = 1, U[k][j] = uniform in [-1, 1) for j > k, 0 below the diagonal
+ *              L unit lower triangular, row i of L has MATRIX_GEN_MIX more ones at columns drawn from [0, i)
+ *          so row i of A is U[i] plus MATRIX_GEN_MIX earlier rows of U, all generated on demand. a row costs
+ *          (MATRIX_GEN_MIX + 1) rows of U and depends on nothing but the seed: threads (OpenMP, when enabled) and
+ *          processors make their rows independently, always adding in the same order, so the matrix is bit for bit
+ *          the same for a given seed whatever the number of threads or processors. elimination needs no pivoting,
+ *          its leading minors are those of U.
+ *
+ *          the seed is MATRIX_SEED of the environment, MATRIX_SEED_DEFAULT if unset.
+ *
+ *          U with uniform entries is badly conditioned, in float an elimination of a large A keeps few correct
+ *          digits and engines that round differently (fma or not) disagree completely. matrixGenCheck makes a
+ *          strictly diagonally dominant matrix of the same seed, on which every engine agrees to a few ulps and
+ *          partial pivoting swaps no rows, for checking an engine against another.
+ *
+ *          usage:
+ *              matrixGenRows(matrixSeed(), n, 0, n, a[0], a.stride());        // whole matrix
+ *              matrixGenRows(matrixSeed(), n, first, np, &sub[0][0], n);      // rows [first, first + np) only
+              matrixGenCheck(matrixSeed(), n, c[0], c.stride());             // well conditioned, for checks
+ *              // MPI: rows of a matrix file when there is one, generated rows otherwise, as matrixFileReadRows
+ *              matrixReadOrGenerateRows(MPI_COMM_WORLD, path, matrixSeed(), n, first, np, np, 1, &sub[0][0], np);
+ *
+ */
+#ifndef MATRIX_GEN_H
+#define MATRIX_GEN_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#define MATRIX_SEED_DEFAULT 20220725 // seed when MATRIX_SEED is not set
+#define MATRIX_GEN_MIX 10            // earlier rows of U added to each row, 10 n row additions as initMatrix did
+
+// seed of the generated matrices
+static inline uint64_t matrixSeed()
+{
+    const char *seed = getenv("MATRIX_SEED");
+    return seed != nullptr && *seed != '\0' ? strtoull(seed, nullptr, 10) : MATRIX_SEED_DEFAULT;
+}
+
+// Philox4x32-10 of counter c with key k, result in c
+static inline void philox4x32(uint32_t c[4], uint32_t k0, uint32_t k1)
+{
+    for (int round = 0; round < 10; round++)
+    {
+        uint64_t p0 = (uint64_t)0xD2511F53u * c[0];
+        uint64_t p1 = (uint64_t)0xCD9E8D57u * c[2];
+        uint32_t c1 = c[1], c3 = c[3];
+        c[0] = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c[1] = (uint32_t)p1;
+        c[2] = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c[3] = (uint32_t)p0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+}
+
+// uniform in [-1, 1), 24 random bits so that every value is exact in float
+static inline float matrixGenUniform(uint32_t x)
+{
+    return (float)(x >> 8) * (1.0f / 8388608.0f) - 1.0f;
+}
+
+// row[j] += U[k][j] for j in [k, n), stream 0 of the generator, four elements per counter
+static inline void matrixGenAddU(uint64_t seed, int n, int k, float *row)
+{
+    row[k] += 1.0f;
+    for (int b = (k + 1) / 4; b * 4 < n; b++)
+    {
+        uint32_t c[4] = {(uint32_t)b, (uint32_t)k, 0, 0};
+        philox4x32(c, (uint32_t)seed, (uint32_t)(seed >> 32));
+        for (int e = 0; e < 4; e++)
+        {
+            int j = b * 4 + e;
+            if (j > k && j < n)
+                row[j] += matrixGenUniform(c[e]);
+        }
+    }
+}
+
+// row i of the matrix of seed, n floats
+static inline void matrixGenRow(uint64_t seed, int n, int i, float *row)
+{
+    memset(row, 0, n * sizeof(float));
+    matrixGenAddU(seed, n, i, row);
+    if (i == 0)
+        return;
+    uint32_t c[4];
+    for (int m = 0; m < MATRIX_GEN_MIX; m++)
+    {
+        if (m % 4 == 0) // stream 1: earlier rows added to row i
+        {
+            c[0] = (uint32_t)(m / 4), c[1] = (uint32_t)i, c[2] = 1, c[3] = 0;
+            philox4x32(c, (uint32_t)seed, (uint32_t)(seed >> 32));
+        }
+        int k = (int)(((uint64_t)c[m % 4] * (uint32_t)i) >> 32); // in [0, i)
+        matrixGenAddU(seed, n, k, row);
+    }
+}
+
+// rows [first, first + count) of the matrix of seed, rows stride floats apart, split over OpenMP threads if enabled
+static inline void matrixGenRows(uint64_t seed, int n, int first, int count, float *rows, int stride)
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (int r = 0; r < count; r++)
+        matrixGenRow(seed, n, first + r, rows + (size_t)r * stride);
+}
+
+// symmetric matrix of seed, U[i][j] at (i, j) and (j, i) for j > i and n on the diagonal, rows stride floats apart
+static inline void matrixGenCheck(uint64_t seed, int n, float *rows, int stride)
+{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for (int i = 0; i < n; i++)
+    {
+        float *row = rows + (size_t)i * stride;
+        memset(row, 0, n * sizeof(float));
+        matrixGenAddU(seed, n, i, row);
+        row[i] = (float)n;
+    }
+    for (int i = 1; i < n; i++)
+    {
+        for (int j = 0; j < i; j++)
+            rows[(size_t)i * stride + j] = rows[(size_t)j * stride + i];
+    }
+}
+
+#if defined(MPI_VERSION) && defined(MATRIX_FILE_H)
+// collective over comm, the row set of matrixFileReadRows: read from path when processor 0 finds a matrix file of n
+// there, generated from seed otherwise, so that every processor takes the same way
+static inline bool matrixReadOrGenerateRows(MPI_Comm comm, const char *path, uint64_t seed, int n, int first,
+                                            int blockRows, int blockStep, int blocks, float *dst, int dstStep)
+{
+    int myid, fromFile;
+    MPI_Comm_rank(comm, &myid);
+    fromFile = myid == 0 && matrixFileValid(path, n);
+    MPI_Bcast(&fromFile, 1, MPI_INT, 0, comm);
+    if (fromFile)
+        return matrixFileReadRows(comm, path, n, first, blockRows, blockStep, blocks, dst, dstStep);
+    for (int b = 0; b < blocks; b++)
+        matrixGenRows(seed, n, first + b * blockStep, blockRows, dst + (size_t)b * dstStep * n, n);
+    return true;
+}
+#endif
+
+#endif
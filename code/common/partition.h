@@ -0,0 +1,54 @@
+/**
+ * @file partition.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief contiguous row partition of the MPI gauss engines for any number of processors
+ * @version 0.1
+ * @date 2022-07-19
+ *
+ * @copyright Copyright (c) 2022
+ * @details rows [0, rows) are split into num contiguous parts, the first rows % num processors take one row more, so
+ *          num need not divide the matrix size. every processor allocates only its own part and the parts are moved
+ *          with MPI_Scatterv and MPI_Gatherv, whose counts and displacements partitionCounts fills in.
+ *
+ *          usage:
+ *              int np = partitionRows(n, num, myid);        // own rows
+ *              int first = partitionFirst(n, num, myid);    // global index of the first of them
+ *              int owner = partitionOwner(n, num, k);       // processor holding row k
+ *              float (*sub)[n] = new float[np][n];
+ *              partitionCounts(n, num, n, counts, displs); // elements of every processor, rows of n floats
+ *              MPI_Scatterv(a, counts, displs, MPI_FLOAT, &sub[0][0], np * n, MPI_FLOAT, 0, MPI_COMM_WORLD);
+ *
+ */
+#ifndef PARTITION_H
+#define PARTITION_H
+
+// rows of processor p
+static inline int partitionRows(int rows, int num, int p)
+{
+    return rows / num + (p < rows % num ? 1 : 0);
+}
+
+// global index of the first row of processor p
+static inline int partitionFirst(int rows, int num, int p)
+{
+    return p * (rows / num) + (p < rows % num ? p : rows % num);
+}
+
+// processor holding row i
+static inline int partitionOwner(int rows, int num, int i)
+{
+    int q = rows / num, big = rows % num; // the first big processors hold q + 1 rows
+    return i < big * (q + 1) ? i / (q + 1) : big + (i - big * (q + 1)) / q;
+}
+
+// counts[p] and displs[p] in elements of rows of rowLength for every processor p
+static inline void partitionCounts(int rows, int num, int rowLength, int *counts, int *displs)
+{
+    for (int p = 0; p < num; p++)
+    {
+        counts[p] = partitionRows(rows, num, p) * rowLength;
+        displs[p] = partitionFirst(rows, num, p) * rowLength;
+    }
+}
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file rowScheduler.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief lock-free dynamic row scheduling and row readiness of the pthread gauss engines
+ * @version 0.1
+ * @date 2022-07-15
+ *
+ * @copyright Copyright (c) 2022
+ * @details the dynamic engines used to take a mutex for every single row they eliminated, and to reset one shared
+ *          row counter for the next step while slower threads were still claiming rows of the current one, which let
+ *          a row be eliminated twice. RowScheduler keeps one counter per step, each on its own cache line, so a step
+ *          never touches the counter of another one and nothing has to be reset between steps. a thread claims a
+ *          chunk of rows with a single fetch_add, no lock and no retry. chunks are guided: a claim takes
+ *          remaining / (ROWS_GUIDE * threads) rows but at least the minimum chunk, so early claims are large and
+ *          cheap and the last ones are small enough to even out threads that were slowed down.
+ *
+ *          usage:
+ *              RowScheduler rows;
+ *              rows.start(n, NUM_THREADS);                // before threads run, steps 0..n-1
+ *              ...
+ *              int begin, end;                            // in a thread, step k owns rows [k + 1, n)
+ *              while (rows.claim(k, k + 1, n, begin, end))
+ *                  for (int i = begin; i < end; i++) ...
+ *
+ *          RowProgress drops the barriers altogether for engines that give every row a fixed owner. each row carries
+ *          the number of steps it went through, its owner publishes it with a release store after a step and a thread
+ *          that needs pivot row k waits for the acquire load to reach k + 1 (eliminated through step k - 1 and
+ *          divided). a waiting thread polls ROWS_SPIN times and then yields, at once when threads outnumber the cpus
+ *          the process may run on (cpus.h).
+ *              RowProgress ready;
+ *              ready.start(n, NUM_THREADS);               // before threads run, every row at step 0
+ *              ...
+ *              ready.waitFor(k, k + 1);                   // row k is a pivot row now
+ *              ready.publish(i, k + 1);                   // by the owner of row i, after step k
+ *
+ */
+#ifndef ROW_SCHEDULER_H
+#define ROW_SCHEDULER_H
+
+#include <atomic>
+#include <vector>
+#include <sched.h>
+#include <unistd.h>
+#include "cpus.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ROWS_PAUSE() _mm_pause()
+#elif defined(__aarch64__)
+#define ROWS_PAUSE() __asm__ __volatile__("yield")
+#else
+#define ROWS_PAUSE()
+#endif
+
+#define ROWS_MIN_CHUNK 1 // fewest rows of a claim
+#define ROWS_GUIDE 2     // a claim takes 1 / (ROWS_GUIDE * threads) of rows left
+#define ROWS_LINE 64     // bytes of a cache line
+#define ROWS_SPIN 4000   // polls of a waiting thread before it yields
+
+/**
+ * @brief per-step atomic row counters handing out guided chunks
+ *
+ */
+class RowScheduler
+{
+public:
+    RowScheduler() : threads(1), minChunk(ROWS_MIN_CHUNK)
+    {
+    }
+
+    // counters for steps [0, steps) shared by threads, not thread safe, call before threads claim
+    void start(int steps, int threads, int minChunk = ROWS_MIN_CHUNK)
+    {
+        if ((int)counters.size() < steps)
+            counters = std::vector<Counter>(steps);
+        for (int k = 0; k < steps; k++)
+            counters[k].claimed.store(0, std::memory_order_relaxed);
+        this->threads = threads > 0 ? threads : 1;
+        this->minChunk = minChunk > 0 ? minChunk : 1;
+    }
+
+    // claim rows [begin, end) of step among rows [first, last), false when all of them were claimed
+    bool claim(int step, int first, int last, int &begin, int &end)
+    {
+        std::atomic<int> &claimed = counters[step].claimed;
+        int left = last - first - claimed.load(std::memory_order_relaxed); // may be stale, only sizes the chunk
+        int chunk = left / (ROWS_GUIDE * threads);
+        if (chunk < minChunk)
+            chunk = minChunk;
+        begin = first + claimed.fetch_add(chunk, std::memory_order_relaxed);
+        end = begin + chunk < last ? begin + chunk : last;
+        return begin < last;
+    }
+
+private:
+    struct alignas(ROWS_LINE) Counter
+    {
+        std::atomic<int> claimed; // rows of a step handed out
+    };
+
+    std::vector<Counter> counters;
+    int threads;
+    int minChunk;
+};
+
+/**
+ * @brief per-row atomic step counters, published by the owner of a row and awaited by readers of it
+ *
+ */
+class RowProgress
+{
+public:
+    RowProgress() : spin(ROWS_SPIN)
+    {
+    }
+
+    // every row of [0, rows) at step 0, not thread safe, call before threads run
+    void start(int rows, int threads)
+    {
+        if ((int)counters.size() < rows)
+            counters = std::vector<Counter>(rows);
+        for (int i = 0; i < rows; i++)
+            counters[i].steps.store(0, std::memory_order_relaxed);
+        spin = threads > cpusAllowedCount() ? 0 : ROWS_SPIN;
+    }
+
+    // row went through steps, what was written to it before is visible to threads that wait for it
+    void publish(int row, int steps)
+    {
+        counters[row].steps.store(steps, std::memory_order_release);
+    }
+
+    // return once row went through at least steps
+    void waitFor(int row, int steps)
+    {
+        std::atomic<int> &done = counters[row].steps;
+        for (int i = 0; i < spin; i++)
+        {
+            if (done.load(std::memory_order_acquire) >= steps)
+                return;
+            ROWS_PAUSE();
+        }
+        while (done.load(std::memory_order_acquire) < steps)
+            sched_yield();
+    }
+
+private:
+    struct alignas(ROWS_LINE) Counter
+    {
+        std::atomic<int> steps; // steps a row went through
+    };
+
+    std::vector<Counter> counters;
+    int spin;
+};
+
+#endif
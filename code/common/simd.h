@@ -0,0 +1,828 @@
+/**
+ * @file simd.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief vector kernels of dense gauss elimination with runtime instruction set dispatch
+ * @version 0.1
+ * @date 2022-07-10
+ *
+ * @copyright Copyright (c) 2022
+ * @details one layer for the two inner loops of gauss elimination,
+ *              division:    row[j] /= pivot                 for j in [begin, end)
+ *              elimination: row[j] -= factor * pivotRow[j]  for j in [begin, end)
+ *          plus the max of a range used by partial pivoting. elimination also has a register-blocked micro-kernel
+ *          updating SimdKernels::rows rows by up to SIMD_MAX_PIVOTS pivot rows per pass:
+ *              rows[r][j] -= factors[r][0] * pivotRows[0][j], then -= factors[r][1] * pivotRows[1][j], ...
+ *          every vector of a pivot row is loaded once for all rows, the factors stay in registers and every vector of
+ *          a row is loaded and stored once for all pivot rows. one pivot row per pass is bound by loading and storing
+ *          the rows, two halve that traffic, which is why engines eliminate two steps per pass. backends:
+ *              x86:     scalar, sse2, avx2 (with fma), avx512, the best one supported by the cpu is picked at runtime,
+ *                       so one binary built without -march runs on every server
+ *              aarch64: scalar, neon
+ *          environment variable SIMD_ISA forces a backend, e.g. SIMD_ISA=sse2 ./test, an unsupported one falls back
+ *          to the best. loads are unaligned and tails are handled inside the kernels, so callers pass any range.
+ *
+ *          for many small matrices, where a row is too short to fill a vector, batchEliminate eliminates SIMD_BATCH
+ *          of them at once, interleaved so that element (i, j) of matrix w is group[(i * n + j) * SIMD_BATCH + w]:
+ *          every lane of a vector belongs to another matrix, a step is the same for all of them and no tail is left.
+ *
+ *          scalar and sse2 round every multiply and subtract like the serial loop and give bit-identical results to
+ *          it, avx2, avx512 and neon fuse them and may differ from it in the last bits. every kernel of a backend
+ *          rounds the same way and applies pivot rows in order, so results don't depend on how rows are grouped or
+ *          how many steps a pass does.
+ *
+ *          usage:
+ *              simdDivide(a[k], k + 1, n, a[k][k]);
+ *              simdEliminate(a[i], a[k], k + 1, n, a[i][k]);
+ *              simdUpdateRows(rowPtr + k + 1, n - k - 1, a[k], k, n);  // step k on rows k+1..n-1, rowPtr[i] = a[i]
+ *
+ *              simdDividePair(a[k], a[k + 1], k, n);                     // steps k and k+1 in one pass, k+1 < n
+ *              simdUpdateRows2(rowPtr + k + 2, n - k - 2, a[k], a[k + 1], k, n);
+ *              simdBatchEliminate(group, n);                             // SIMD_BATCH interleaved n x n matrices
+ *              cout << simdIsa() << endl;
+ *
+ */
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) // vdivq_f32 and vmaxvq_f32 are aarch64 only
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+typedef void (*SimdDivideFunc)(float *row, int begin, int end, float pivot);
+typedef void (*SimdEliminateFunc)(float *row, const float *pivotRow, int begin, int end, float factor);
+typedef float (*SimdMaxFunc)(const float *values, int begin, int end);
+typedef void (*SimdEliminateRowsFunc)(float *const *rows, const float *const *pivotRows, int pivots,
+                                      const float *factors, int count, int begin, int end);
+typedef void (*SimdBatchEliminateFunc)(float *group, int n);
+
+#define SIMD_MAX_ROWS 8   // most rows updated together by a micro-kernel
+#define SIMD_MAX_PIVOTS 2 // most pivot rows applied by a micro-kernel in one pass
+#define SIMD_BATCH 16     // matrices interleaved by batchEliminate, the widest vector, so the layout fits every backend
+
+typedef struct SimdKernels
+{
+    const char *name;                    // value of SIMD_ISA selecting the backend
+    int width;                           // floats per vector
+    SimdDivideFunc divide;               // row[j] /= pivot
+    SimdEliminateFunc eliminate;         // row[j] -= factor * pivotRow[j]
+    SimdMaxFunc max;                     // max of values[begin, end), begin < end
+    int rows;                            // rows updated together by eliminateRows
+    SimdEliminateRowsFunc eliminateRows; // rows[r][j] -= factors[r * pivots + p] * pivotRows[p][j], p in order
+    SimdBatchEliminateFunc batchEliminate; // gauss elimination of SIMD_BATCH interleaved n x n matrices
+} SimdKernels;
+
+//===scalar======================================================================================================================
+static void simdDivideScalar(float *row, int begin, int end, float pivot)
+{
+    for (int j = begin; j < end; j++)
+        row[j] /= pivot;
+}
+
+static void simdEliminateScalar(float *row, const float *pivotRow, int begin, int end, float factor)
+{
+    for (int j = begin; j < end; j++)
+        row[j] -= factor * pivotRow[j];
+}
+
+static float simdMaxScalar(const float *values, int begin, int end)
+{
+    float m = values[begin];
+    for (int j = begin + 1; j < end; j++)
+        m = values[j] > m ? values[j] : m;
+    return m;
+}
+
+// without vectors there is nothing to share between rows, update them one by one
+static void simdEliminateRowsScalar(float *const *rows, const float *const *pivotRows, int pivots, const float *factors,
+                                    int count, int begin, int end)
+{
+    for (int r = 0; r < count; r++)
+    {
+        for (int p = 0; p < pivots; p++)
+            simdEliminateScalar(rows[r], pivotRows[p], begin, end, factors[r * pivots + p]);
+    }
+}
+
+// feed count rows to Kernel::eliminate<R, P> R at a time, the rest R / 2, R / 4, ... at a time
+template <class Kernel, int R, int P>
+static void simdEliminateRowsBy(float *const *rows, const float *const *pivotRows, const float *factors, int count,
+                                int begin, int end)
+{
+    int r = 0;
+    for (; r + R <= count; r += R)
+        Kernel::template eliminate<R, P>(rows + r, pivotRows, factors + r * P, begin, end);
+    if (R > 1 && r < count)
+        simdEliminateRowsBy<Kernel, (R > 1 ? R / 2 : 1), P>(rows + r, pivotRows, factors + r * P, count - r, begin,
+                                                            end);
+}
+
+template <class Kernel, int R>
+static void simdEliminateRowsBy(float *const *rows, const float *const *pivotRows, int pivots, const float *factors,
+                                int count, int begin, int end)
+{
+    if (pivots == 2)
+        simdEliminateRowsBy<Kernel, R, 2>(rows, pivotRows, factors, count, begin, end);
+    else
+        simdEliminateRowsBy<Kernel, R, 1>(rows, pivotRows, factors, count, begin, end);
+}
+
+// element (i, j) of the first matrix of an interleaved group
+#define SIMD_BATCH_AT(group, n, i, j) ((group) + ((size_t)(i) * (n) + (j)) * SIMD_BATCH)
+
+static void simdBatchEliminateScalar(float *group, int n)
+{
+    for (int k = 0; k < n; k++)
+    {
+        float *rowK = SIMD_BATCH_AT(group, n, k, 0);
+        for (int w = 0; w < SIMD_BATCH; w++)
+        {
+            for (int j = k + 1; j < n; j++)
+                rowK[j * SIMD_BATCH + w] /= rowK[k * SIMD_BATCH + w];
+            rowK[k * SIMD_BATCH + w] = 1.0;
+            for (int i = k + 1; i < n; i++)
+            {
+                float *rowI = SIMD_BATCH_AT(group, n, i, 0);
+                for (int j = k + 1; j < n; j++)
+                    rowI[j * SIMD_BATCH + w] -= rowI[k * SIMD_BATCH + w] * rowK[j * SIMD_BATCH + w];
+                rowI[k * SIMD_BATCH + w] = 0;
+            }
+        }
+    }
+}
+
+#ifdef SIMD_X86
+//===sse2======================================================================================================================
+__attribute__((target("sse2"))) static void simdDivideSSE2(float *row, int begin, int end, float pivot)
+{
+    __m128 vt = _mm_set1_ps(pivot);
+    int j = begin;
+    for (; j + 4 <= end; j += 4)
+        _mm_storeu_ps(row + j, _mm_div_ps(_mm_loadu_ps(row + j), vt));
+    for (; j < end; j++)
+        row[j] /= pivot;
+}
+
+__attribute__((target("sse2"))) static void simdEliminateSSE2(float *row, const float *pivotRow, int begin, int end,
+                                                              float factor)
+{
+    __m128 vf = _mm_set1_ps(factor);
+    int j = begin;
+    for (; j + 4 <= end; j += 4)
+    {
+        __m128 vx = _mm_mul_ps(vf, _mm_loadu_ps(pivotRow + j));
+        _mm_storeu_ps(row + j, _mm_sub_ps(_mm_loadu_ps(row + j), vx));
+    }
+    for (; j < end; j++)
+        row[j] -= factor * pivotRow[j];
+}
+
+struct SimdRowsSSE2
+{
+    template <int R, int P>
+    __attribute__((target("sse2")))
+    static void eliminate(float *const *rows, const float *const *pivotRows, const float *factors, int begin, int end)
+    {
+        __m128 vf[R * P];
+        for (int t = 0; t < R * P; t++)
+            vf[t] = _mm_set1_ps(factors[t]);
+        int j = begin;
+        for (; j + 4 <= end; j += 4)
+        {
+            __m128 vp[P], v[R];
+            for (int p = 0; p < P; p++)
+                vp[p] = _mm_loadu_ps(pivotRows[p] + j);
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                v[r] = _mm_loadu_ps(rows[r] + j);
+            for (int p = 0; p < P; p++)
+            {
+#pragma GCC unroll 8
+                for (int r = 0; r < R; r++)
+                    v[r] = _mm_sub_ps(v[r], _mm_mul_ps(vf[r * P + p], vp[p]));
+            }
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                _mm_storeu_ps(rows[r] + j, v[r]);
+        }
+        for (; j < end; j++)
+        {
+            for (int r = 0; r < R; r++)
+            {
+                for (int p = 0; p < P; p++)
+                    rows[r][j] = rows[r][j] - factors[r * P + p] * pivotRows[p][j];
+            }
+        }
+    }
+};
+
+static void simdEliminateRowsSSE2(float *const *rows, const float *const *pivotRows, int pivots,
+                                  const float *factors, int count, int begin, int end)
+{
+    // 8 factors, 2 pivot vectors and 4 row vectors fill the 16 xmm registers
+    simdEliminateRowsBy<SimdRowsSSE2, 4>(rows, pivotRows, pivots, factors, count, begin, end);
+}
+
+__attribute__((target("sse2"))) static float simdMaxSSE2(const float *values, int begin, int end)
+{
+    if (end - begin < 4)
+        return simdMaxScalar(values, begin, end);
+    __m128 vm = _mm_loadu_ps(values + begin);
+    int j = begin + 4;
+    for (; j + 4 <= end; j += 4)
+        vm = _mm_max_ps(vm, _mm_loadu_ps(values + j));
+    float lanes[4];
+    _mm_storeu_ps(lanes, vm);
+    float m = simdMaxScalar(lanes, 0, 4);
+    for (; j < end; j++)
+        m = values[j] > m ? values[j] : m;
+    return m;
+}
+
+// the SIMD_BATCH / 4 vectors of an element are independent chains
+__attribute__((target("sse2"))) static void simdBatchEliminateSSE2(float *group, int n)
+{
+    const int V = SIMD_BATCH / 4;
+    for (int k = 0; k < n; k++)
+    {
+        float *rowK = SIMD_BATCH_AT(group, n, k, 0);
+        __m128 vt[V];
+        for (int v = 0; v < V; v++)
+        {
+            vt[v] = _mm_loadu_ps(rowK + k * SIMD_BATCH + v * 4);
+            _mm_storeu_ps(rowK + k * SIMD_BATCH + v * 4, _mm_set1_ps(1.0));
+        }
+        for (int j = k + 1; j < n; j++)
+        {
+            float *pk = rowK + j * SIMD_BATCH;
+            for (int v = 0; v < V; v++)
+                _mm_storeu_ps(pk + v * 4, _mm_div_ps(_mm_loadu_ps(pk + v * 4), vt[v]));
+        }
+        for (int i = k + 1; i < n; i++)
+        {
+            float *rowI = SIMD_BATCH_AT(group, n, i, 0);
+            __m128 vf[V];
+            for (int v = 0; v < V; v++)
+            {
+                vf[v] = _mm_loadu_ps(rowI + k * SIMD_BATCH + v * 4);
+                _mm_storeu_ps(rowI + k * SIMD_BATCH + v * 4, _mm_setzero_ps());
+            }
+            for (int j = k + 1; j < n; j++)
+            {
+                float *pk = rowK + j * SIMD_BATCH, *pi = rowI + j * SIMD_BATCH;
+                for (int v = 0; v < V; v++)
+                {
+                    __m128 vx = _mm_mul_ps(vf[v], _mm_loadu_ps(pk + v * 4));
+                    _mm_storeu_ps(pi + v * 4, _mm_sub_ps(_mm_loadu_ps(pi + v * 4), vx));
+                }
+            }
+        }
+    }
+}
+
+//===avx2+fma======================================================================================================================
+__attribute__((target("avx2,fma"))) static void simdDivideAVX2(float *row, int begin, int end, float pivot)
+{
+    __m256 vt = _mm256_set1_ps(pivot);
+    int j = begin;
+    for (; j + 8 <= end; j += 8)
+        _mm256_storeu_ps(row + j, _mm256_div_ps(_mm256_loadu_ps(row + j), vt));
+    for (; j < end; j++)
+        row[j] /= pivot;
+}
+
+__attribute__((target("avx2,fma"))) static void simdEliminateAVX2(float *row, const float *pivotRow, int begin,
+                                                                  int end, float factor)
+{
+    __m256 vf = _mm256_set1_ps(factor);
+    int j = begin;
+    for (; j + 16 <= end; j += 16) // two independent chains to hide fma latency
+    {
+        __m256 v0 = _mm256_fnmadd_ps(vf, _mm256_loadu_ps(pivotRow + j), _mm256_loadu_ps(row + j));
+        __m256 v1 = _mm256_fnmadd_ps(vf, _mm256_loadu_ps(pivotRow + j + 8), _mm256_loadu_ps(row + j + 8));
+        _mm256_storeu_ps(row + j, v0);
+        _mm256_storeu_ps(row + j + 8, v1);
+    }
+    for (; j + 8 <= end; j += 8)
+        _mm256_storeu_ps(row + j, _mm256_fnmadd_ps(vf, _mm256_loadu_ps(pivotRow + j), _mm256_loadu_ps(row + j)));
+    for (; j < end; j++)
+        row[j] = __builtin_fmaf(-factor, pivotRow[j], row[j]); // fused like the vector part
+}
+
+struct SimdRowsAVX2
+{
+    template <int R, int P>
+    __attribute__((target("avx2,fma")))
+    static void eliminate(float *const *rows, const float *const *pivotRows, const float *factors, int begin, int end)
+    {
+        __m256 vf[R * P];
+        for (int t = 0; t < R * P; t++)
+            vf[t] = _mm256_set1_ps(factors[t]);
+        int j = begin;
+        for (; j + 8 <= end; j += 8)
+        {
+            __m256 vp[P], v[R];
+            for (int p = 0; p < P; p++)
+                vp[p] = _mm256_loadu_ps(pivotRows[p] + j);
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                v[r] = _mm256_loadu_ps(rows[r] + j);
+            for (int p = 0; p < P; p++)
+            {
+#pragma GCC unroll 8
+                for (int r = 0; r < R; r++)
+                    v[r] = _mm256_fnmadd_ps(vf[r * P + p], vp[p], v[r]);
+            }
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                _mm256_storeu_ps(rows[r] + j, v[r]);
+        }
+        for (; j < end; j++)
+        {
+            for (int r = 0; r < R; r++)
+            {
+                for (int p = 0; p < P; p++)
+                    rows[r][j] = __builtin_fmaf(-factors[r * P + p], pivotRows[p][j], rows[r][j]);
+            }
+        }
+    }
+};
+
+static void simdEliminateRowsAVX2(float *const *rows, const float *const *pivotRows, int pivots,
+                                  const float *factors, int count, int begin, int end)
+{
+    // 8 factors, 2 pivot vectors and 4 row vectors fill the 16 ymm registers
+    simdEliminateRowsBy<SimdRowsAVX2, 4>(rows, pivotRows, pivots, factors, count, begin, end);
+}
+
+__attribute__((target("avx2,fma"))) static float simdMaxAVX2(const float *values, int begin, int end)
+{
+    if (end - begin < 8)
+        return simdMaxScalar(values, begin, end);
+    __m256 vm = _mm256_loadu_ps(values + begin);
+    int j = begin + 8;
+    for (; j + 8 <= end; j += 8)
+        vm = _mm256_max_ps(vm, _mm256_loadu_ps(values + j));
+    __m128 vh = _mm_max_ps(_mm256_castps256_ps128(vm), _mm256_extractf128_ps(vm, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, vh);
+    float m = simdMaxScalar(lanes, 0, 4);
+    for (; j < end; j++)
+        m = values[j] > m ? values[j] : m;
+    return m;
+}
+
+__attribute__((target("avx2,fma"))) static void simdBatchEliminateAVX2(float *group, int n)
+{
+    const int V = SIMD_BATCH / 8;
+    for (int k = 0; k < n; k++)
+    {
+        float *rowK = SIMD_BATCH_AT(group, n, k, 0);
+        __m256 vt[V];
+        for (int v = 0; v < V; v++)
+        {
+            vt[v] = _mm256_loadu_ps(rowK + k * SIMD_BATCH + v * 8);
+            _mm256_storeu_ps(rowK + k * SIMD_BATCH + v * 8, _mm256_set1_ps(1.0));
+        }
+        for (int j = k + 1; j < n; j++)
+        {
+            float *pk = rowK + j * SIMD_BATCH;
+            for (int v = 0; v < V; v++)
+                _mm256_storeu_ps(pk + v * 8, _mm256_div_ps(_mm256_loadu_ps(pk + v * 8), vt[v]));
+        }
+        for (int i = k + 1; i < n; i++)
+        {
+            float *rowI = SIMD_BATCH_AT(group, n, i, 0);
+            __m256 vf[V];
+            for (int v = 0; v < V; v++)
+            {
+                vf[v] = _mm256_loadu_ps(rowI + k * SIMD_BATCH + v * 8);
+                _mm256_storeu_ps(rowI + k * SIMD_BATCH + v * 8, _mm256_setzero_ps());
+            }
+            for (int j = k + 1; j < n; j++)
+            {
+                float *pk = rowK + j * SIMD_BATCH, *pi = rowI + j * SIMD_BATCH;
+                for (int v = 0; v < V; v++)
+                {
+                    __m256 vx = _mm256_fnmadd_ps(vf[v], _mm256_loadu_ps(pk + v * 8), _mm256_loadu_ps(pi + v * 8));
+                    _mm256_storeu_ps(pi + v * 8, vx);
+                }
+            }
+        }
+    }
+}
+
+//===avx512======================================================================================================================
+// tails are done by masked loads and stores instead of scalar loops
+__attribute__((target("avx512f"))) static void simdDivideAVX512(float *row, int begin, int end, float pivot)
+{
+    __m512 vt = _mm512_set1_ps(pivot);
+    int j = begin;
+    for (; j + 16 <= end; j += 16)
+        _mm512_storeu_ps(row + j, _mm512_div_ps(_mm512_loadu_ps(row + j), vt));
+    if (j < end)
+    {
+        __mmask16 mask = (__mmask16)((1u << (end - j)) - 1);
+        _mm512_mask_storeu_ps(row + j, mask, _mm512_div_ps(_mm512_maskz_loadu_ps(mask, row + j), vt));
+    }
+}
+
+__attribute__((target("avx512f"))) static void simdEliminateAVX512(float *row, const float *pivotRow, int begin,
+                                                                   int end, float factor)
+{
+    __m512 vf = _mm512_set1_ps(factor);
+    int j = begin;
+    for (; j + 32 <= end; j += 32) // two independent chains to hide fma latency
+    {
+        __m512 v0 = _mm512_fnmadd_ps(vf, _mm512_loadu_ps(pivotRow + j), _mm512_loadu_ps(row + j));
+        __m512 v1 = _mm512_fnmadd_ps(vf, _mm512_loadu_ps(pivotRow + j + 16), _mm512_loadu_ps(row + j + 16));
+        _mm512_storeu_ps(row + j, v0);
+        _mm512_storeu_ps(row + j + 16, v1);
+    }
+    for (; j + 16 <= end; j += 16)
+        _mm512_storeu_ps(row + j, _mm512_fnmadd_ps(vf, _mm512_loadu_ps(pivotRow + j), _mm512_loadu_ps(row + j)));
+    if (j < end)
+    {
+        __mmask16 mask = (__mmask16)((1u << (end - j)) - 1);
+        __m512 v = _mm512_fnmadd_ps(vf, _mm512_maskz_loadu_ps(mask, pivotRow + j), _mm512_maskz_loadu_ps(mask, row + j));
+        _mm512_mask_storeu_ps(row + j, mask, v);
+    }
+}
+
+struct SimdRowsAVX512
+{
+    template <int R, int P>
+    __attribute__((target("avx512f")))
+    static void eliminate(float *const *rows, const float *const *pivotRows, const float *factors, int begin, int end)
+    {
+        __m512 vf[R * P];
+        for (int t = 0; t < R * P; t++)
+            vf[t] = _mm512_set1_ps(factors[t]);
+        int j = begin;
+        for (; j + 16 <= end; j += 16)
+        {
+            __m512 vp[P], v[R];
+            for (int p = 0; p < P; p++)
+                vp[p] = _mm512_loadu_ps(pivotRows[p] + j);
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                v[r] = _mm512_loadu_ps(rows[r] + j);
+            for (int p = 0; p < P; p++)
+            {
+#pragma GCC unroll 8
+                for (int r = 0; r < R; r++)
+                    v[r] = _mm512_fnmadd_ps(vf[r * P + p], vp[p], v[r]);
+            }
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                _mm512_storeu_ps(rows[r] + j, v[r]);
+        }
+        if (j < end)
+        {
+            __mmask16 mask = (__mmask16)((1u << (end - j)) - 1);
+            for (int r = 0; r < R; r++)
+            {
+                __m512 v = _mm512_maskz_loadu_ps(mask, rows[r] + j);
+                for (int p = 0; p < P; p++)
+                    v = _mm512_fnmadd_ps(vf[r * P + p], _mm512_maskz_loadu_ps(mask, pivotRows[p] + j), v);
+                _mm512_mask_storeu_ps(rows[r] + j, mask, v);
+            }
+        }
+    }
+};
+
+static void simdEliminateRowsAVX512(float *const *rows, const float *const *pivotRows, int pivots,
+                                  const float *factors, int count, int begin, int end)
+{
+    // more rows gain nothing and thrash L1 when rows are 2^k floats apart
+    simdEliminateRowsBy<SimdRowsAVX512, 4>(rows, pivotRows, pivots, factors, count, begin, end);
+}
+
+// an element of the group is one vector, two rows below the pivot row are updated together to hide fma latency
+__attribute__((target("avx512f"))) static void simdBatchEliminateAVX512(float *group, int n)
+{
+    for (int k = 0; k < n; k++)
+    {
+        float *rowK = SIMD_BATCH_AT(group, n, k, 0);
+        __m512 vt = _mm512_loadu_ps(rowK + k * SIMD_BATCH);
+        _mm512_storeu_ps(rowK + k * SIMD_BATCH, _mm512_set1_ps(1.0));
+        for (int j = k + 1; j < n; j++)
+            _mm512_storeu_ps(rowK + j * SIMD_BATCH, _mm512_div_ps(_mm512_loadu_ps(rowK + j * SIMD_BATCH), vt));
+        int i = k + 1;
+        for (; i + 2 <= n; i += 2)
+        {
+            float *row0 = SIMD_BATCH_AT(group, n, i, 0), *row1 = SIMD_BATCH_AT(group, n, i + 1, 0);
+            __m512 vf0 = _mm512_loadu_ps(row0 + k * SIMD_BATCH), vf1 = _mm512_loadu_ps(row1 + k * SIMD_BATCH);
+            _mm512_storeu_ps(row0 + k * SIMD_BATCH, _mm512_setzero_ps());
+            _mm512_storeu_ps(row1 + k * SIMD_BATCH, _mm512_setzero_ps());
+            for (int j = k + 1; j < n; j++)
+            {
+                __m512 vp = _mm512_loadu_ps(rowK + j * SIMD_BATCH);
+                float *p0 = row0 + j * SIMD_BATCH, *p1 = row1 + j * SIMD_BATCH;
+                _mm512_storeu_ps(p0, _mm512_fnmadd_ps(vf0, vp, _mm512_loadu_ps(p0)));
+                _mm512_storeu_ps(p1, _mm512_fnmadd_ps(vf1, vp, _mm512_loadu_ps(p1)));
+            }
+        }
+        if (i < n)
+        {
+            float *row0 = SIMD_BATCH_AT(group, n, i, 0);
+            __m512 vf0 = _mm512_loadu_ps(row0 + k * SIMD_BATCH);
+            _mm512_storeu_ps(row0 + k * SIMD_BATCH, _mm512_setzero_ps());
+            for (int j = k + 1; j < n; j++)
+            {
+                float *p0 = row0 + j * SIMD_BATCH;
+                __m512 vp = _mm512_loadu_ps(rowK + j * SIMD_BATCH);
+                _mm512_storeu_ps(p0, _mm512_fnmadd_ps(vf0, vp, _mm512_loadu_ps(p0)));
+            }
+        }
+    }
+}
+#endif
+
+#ifdef SIMD_NEON
+//===neon======================================================================================================================
+static void simdDivideNEON(float *row, int begin, int end, float pivot)
+{
+    float32x4_t vt = vdupq_n_f32(pivot);
+    int j = begin;
+    for (; j + 4 <= end; j += 4)
+        vst1q_f32(row + j, vdivq_f32(vld1q_f32(row + j), vt));
+    for (; j < end; j++)
+        row[j] /= pivot;
+}
+
+static void simdEliminateNEON(float *row, const float *pivotRow, int begin, int end, float factor)
+{
+    float32x4_t vf = vdupq_n_f32(factor);
+    int j = begin;
+    for (; j + 4 <= end; j += 4)
+        vst1q_f32(row + j, vfmsq_f32(vld1q_f32(row + j), vf, vld1q_f32(pivotRow + j)));
+    for (; j < end; j++)
+        row[j] = __builtin_fmaf(-factor, pivotRow[j], row[j]); // fused like the vector part
+}
+
+struct SimdRowsNEON
+{
+    template <int R, int P>
+    static void eliminate(float *const *rows, const float *const *pivotRows, const float *factors, int begin, int end)
+    {
+        float32x4_t vf[R * P];
+        for (int t = 0; t < R * P; t++)
+            vf[t] = vdupq_n_f32(factors[t]);
+        int j = begin;
+        for (; j + 4 <= end; j += 4)
+        {
+            float32x4_t vp[P], v[R];
+            for (int p = 0; p < P; p++)
+                vp[p] = vld1q_f32(pivotRows[p] + j);
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                v[r] = vld1q_f32(rows[r] + j);
+            for (int p = 0; p < P; p++)
+            {
+#pragma GCC unroll 8
+                for (int r = 0; r < R; r++)
+                    v[r] = vfmsq_f32(v[r], vf[r * P + p], vp[p]);
+            }
+#pragma GCC unroll 8
+            for (int r = 0; r < R; r++)
+                vst1q_f32(rows[r] + j, v[r]);
+        }
+        for (; j < end; j++)
+        {
+            for (int r = 0; r < R; r++)
+            {
+                for (int p = 0; p < P; p++)
+                    rows[r][j] = __builtin_fmaf(-factors[r * P + p], pivotRows[p][j], rows[r][j]);
+            }
+        }
+    }
+};
+
+static void simdEliminateRowsNEON(float *const *rows, const float *const *pivotRows, int pivots,
+                                  const float *factors, int count, int begin, int end)
+{
+    // more rows gain nothing and thrash L1 when rows are 2^k floats apart
+    simdEliminateRowsBy<SimdRowsNEON, 4>(rows, pivotRows, pivots, factors, count, begin, end);
+}
+
+static void simdBatchEliminateNEON(float *group, int n)
+{
+    const int V = SIMD_BATCH / 4;
+    for (int k = 0; k < n; k++)
+    {
+        float *rowK = SIMD_BATCH_AT(group, n, k, 0);
+        float32x4_t vt[V];
+        for (int v = 0; v < V; v++)
+        {
+            vt[v] = vld1q_f32(rowK + k * SIMD_BATCH + v * 4);
+            vst1q_f32(rowK + k * SIMD_BATCH + v * 4, vdupq_n_f32(1.0));
+        }
+        for (int j = k + 1; j < n; j++)
+        {
+            float *pk = rowK + j * SIMD_BATCH;
+            for (int v = 0; v < V; v++)
+                vst1q_f32(pk + v * 4, vdivq_f32(vld1q_f32(pk + v * 4), vt[v]));
+        }
+        for (int i = k + 1; i < n; i++)
+        {
+            float *rowI = SIMD_BATCH_AT(group, n, i, 0);
+            float32x4_t vf[V];
+            for (int v = 0; v < V; v++)
+            {
+                vf[v] = vld1q_f32(rowI + k * SIMD_BATCH + v * 4);
+                vst1q_f32(rowI + k * SIMD_BATCH + v * 4, vdupq_n_f32(0));
+            }
+            for (int j = k + 1; j < n; j++)
+            {
+                float *pk = rowK + j * SIMD_BATCH, *pi = rowI + j * SIMD_BATCH;
+                for (int v = 0; v < V; v++)
+                    vst1q_f32(pi + v * 4, vfmsq_f32(vld1q_f32(pi + v * 4), vf[v], vld1q_f32(pk + v * 4)));
+            }
+        }
+    }
+}
+
+static float simdMaxNEON(const float *values, int begin, int end)
+{
+    if (end - begin < 4)
+        return simdMaxScalar(values, begin, end);
+    float32x4_t vm = vld1q_f32(values + begin);
+    int j = begin + 4;
+    for (; j + 4 <= end; j += 4)
+        vm = vmaxq_f32(vm, vld1q_f32(values + j));
+    float m = vmaxvq_f32(vm);
+    for (; j < end; j++)
+        m = values[j] > m ? values[j] : m;
+    return m;
+}
+#endif
+
+//===dispatch======================================================================================================================
+static const SimdKernels simdBackends[] = {
+#ifdef SIMD_X86
+    {"avx512", 16, simdDivideAVX512, simdEliminateAVX512, simdMaxAVX2, 4, simdEliminateRowsAVX512, // max is not hot
+     simdBatchEliminateAVX512},
+    {"avx2", 8, simdDivideAVX2, simdEliminateAVX2, simdMaxAVX2, 4, simdEliminateRowsAVX2, simdBatchEliminateAVX2},
+    {"sse2", 4, simdDivideSSE2, simdEliminateSSE2, simdMaxSSE2, 4, simdEliminateRowsSSE2, simdBatchEliminateSSE2},
+#endif
+#ifdef SIMD_NEON
+    {"neon", 4, simdDivideNEON, simdEliminateNEON, simdMaxNEON, 4, simdEliminateRowsNEON, simdBatchEliminateNEON},
+#endif
+    {"scalar", 1, simdDivideScalar, simdEliminateScalar, simdMaxScalar, 4, simdEliminateRowsScalar,
+     simdBatchEliminateScalar},
+};
+
+static bool simdSupported(const SimdKernels &kernels)
+{
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if (strcmp(kernels.name, "avx512") == 0)
+        return __builtin_cpu_supports("avx512f");
+    if (strcmp(kernels.name, "avx2") == 0)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (strcmp(kernels.name, "sse2") == 0)
+        return __builtin_cpu_supports("sse2");
+#endif
+    return true;
+}
+
+// backends are listed from best to worst, take the one forced by SIMD_ISA or else the first supported
+static const SimdKernels *simdSelect()
+{
+    const int count = sizeof(simdBackends) / sizeof(SimdKernels);
+    const char *forced = getenv("SIMD_ISA");
+    if (forced != nullptr && *forced != '\0')
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (strcmp(simdBackends[i].name, forced) == 0 && simdSupported(simdBackends[i]))
+                return &simdBackends[i];
+        }
+        std::cerr << "SIMD_ISA=" << forced << " is not supported here, using the best one" << std::endl;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        if (simdSupported(simdBackends[i]))
+            return &simdBackends[i];
+    }
+    return &simdBackends[count - 1];
+}
+
+// backend used by this process, chosen on first call
+static inline const SimdKernels &simdKernels()
+{
+    static const SimdKernels *kernels = simdSelect();
+    return *kernels;
+}
+
+//===kernels======================================================================================================================
+// row[j] /= pivot for j in [begin, end)
+static inline void simdDivide(float *row, int begin, int end, float pivot)
+{
+    simdKernels().divide(row, begin, end, pivot);
+}
+
+// row[j] -= factor * pivotRow[j] for j in [begin, end), row and pivotRow must not overlap
+static inline void simdEliminate(float *row, const float *pivotRow, int begin, int end, float factor)
+{
+    simdKernels().eliminate(row, pivotRow, begin, end, factor);
+}
+
+// rows[r][j] -= factors[r * pivots + p] * pivotRows[p][j] for p in [0, pivots) in order, r in [0, count) and j in
+// [begin, end), pivots <= SIMD_MAX_PIVOTS, rows must not overlap pivot rows
+static inline void simdEliminateRows(float *const *rows, const float *const *pivotRows, int pivots,
+                                     const float *factors, int count, int begin, int end)
+{
+    simdKernels().eliminateRows(rows, pivotRows, pivots, factors, count, begin, end);
+}
+
+// step k on rows[0, count) by pivotRow: factor of row r is rows[r][k], columns (k, n) are updated and rows[r][k]
+// becomes 0
+static inline void simdUpdateRows(float *const *rows, int count, const float *pivotRow, int k, int n)
+{
+    float factors[SIMD_MAX_ROWS];
+    for (int r0 = 0; r0 < count; r0 += SIMD_MAX_ROWS)
+    {
+        int group = count - r0 < SIMD_MAX_ROWS ? count - r0 : SIMD_MAX_ROWS;
+        for (int r = 0; r < group; r++)
+        {
+            factors[r] = rows[r0 + r][k];
+            rows[r0 + r][k] = 0;
+        }
+        simdEliminateRows(rows + r0, &pivotRow, 1, factors, group, k + 1, n);
+    }
+}
+
+// divide row k, then do step k on row k + 1 and divide it, so both can be pivot rows of simdUpdateRows2, k + 1 < n
+static inline void simdDividePair(float *rowK, float *rowK1, int k, int n)
+{
+    simdDivide(rowK, k + 1, n, rowK[k]);
+    rowK[k] = 1.0;
+    simdUpdateRows(&rowK1, 1, rowK, k, n);
+    simdDivide(rowK1, k + 2, n, rowK1[k + 1]);
+    rowK1[k + 1] = 1.0;
+}
+
+// steps k and k + 1 on rows[0, count) in one pass, pivot rows come from simdDividePair. factor of step k + 1 is
+// rows[r][k + 1] after step k, which is worked out first, so every element is rounded as by two simdUpdateRows
+static inline void simdUpdateRows2(float *const *rows, int count, const float *pivotRowK, const float *pivotRowK1,
+                                   int k, int n)
+{
+    const float *pivotRows[2] = {pivotRowK, pivotRowK1};
+    float factors[SIMD_MAX_ROWS * 2];
+    for (int r0 = 0; r0 < count; r0 += SIMD_MAX_ROWS)
+    {
+        int group = count - r0 < SIMD_MAX_ROWS ? count - r0 : SIMD_MAX_ROWS;
+        for (int r = 0; r < group; r++)
+        {
+            float *row = rows[r0 + r];
+            factors[r * 2] = row[k];
+            simdEliminate(row, pivotRowK, k + 1, k + 2, row[k]); // column k + 1 by step k
+            factors[r * 2 + 1] = row[k + 1];
+            row[k] = 0;
+            row[k + 1] = 0;
+        }
+        simdEliminateRows(rows + r0, pivotRows, 2, factors, group, k + 2, n);
+    }
+}
+
+// gauss elimination of the SIMD_BATCH n x n matrices interleaved in group, element (i, j) of matrix w is
+// group[(i * n + j) * SIMD_BATCH + w], every matrix ends upper triangular with unit diagonal like the serial algorithm
+static inline void simdBatchEliminate(float *group, int n)
+{
+    simdKernels().batchEliminate(group, n);
+}
+
+// max of values[begin, end), begin < end
+static inline float simdMax(const float *values, int begin, int end)
+{
+    return simdKernels().max(values, begin, end);
+}
+
+// name of backend in use
+static inline const char *simdIsa()
+{
+    return simdKernels().name;
+}
+
+// floats per vector of backend in use
+static inline int simdWidth()
+{
+    return simdKernels().width;
+}
+
+// rows per micro-kernel call of backend in use, engines splitting rows among threads should hand out multiples of it
+static inline int simdRows()
+{
+    return simdKernels().rows;
+}
+
+#endif
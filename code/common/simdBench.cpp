@@ -0,0 +1,235 @@
+/**
+ * @file simdBench.cpp
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief microbenchmark of elimination kernels of simd.h against peak of one core
+ * @version 0.1
+ * @date 2022-07-11
+ *
+ * @copyright Copyright (c) 2022
+ * @details for every backend supported by the cpu, measures GFLOP/s of
+ *              one-row:    eliminate called on every row, the pivot row is loaded again for each of them
+ *              multi-row:  eliminateRows by one pivot row, each vector of it is loaded once for SimdKernels::rows rows
+ *              two pivots: eliminateRows by two pivot rows, each vector of a row is also loaded and stored once for
+ *                          both of them, as engines eliminating steps k and k+1 in one pass do
+ *          on a block of rows small enough for L2 and a block much larger than it (memory bound).
+ *          peak is measured by independent fma (mul and add for sse2) chains kept in registers, so it is the
+ *          throughput of one core at its current clock. an update of an element is counted as 2 flops.
+ *
+ *          build: g++ -O2 -o simdBench simdBench.cpp
+ *          run:   ./simdBench [cols = 1024] [rows in cache = 48] [rows in memory = 4096]
+ *
+ */
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include "simd.h"
+using namespace std;
+
+#define PEAK_CHAINS 12        // independent chains, more than latency * ports of fma units
+#define PEAK_ITERS 20000000L  // iterations of peak loop
+#define MIN_SECONDS 0.2       // least time of each measurement
+
+//===peak======================================================================================================================
+// every chain is acc = acc * a + b, it converges instead of overflowing
+static double peakScalar(long iters)
+{
+    float acc[PEAK_CHAINS];
+    for (int c = 0; c < PEAK_CHAINS; c++)
+        acc[c] = c;
+    for (long t = 0; t < iters; t++)
+    {
+#pragma GCC unroll 12
+        for (int c = 0; c < PEAK_CHAINS; c++)
+            acc[c] = acc[c] * 0.999999f + 1e-7f;
+    }
+    float sum = 0;
+    for (int c = 0; c < PEAK_CHAINS; c++)
+        sum += acc[c];
+    return sum;
+}
+
+#ifdef SIMD_X86
+__attribute__((target("sse2"))) static double peakSSE2(long iters)
+{
+    __m128 acc[PEAK_CHAINS];
+    __m128 a = _mm_set1_ps(0.999999f), b = _mm_set1_ps(1e-7f);
+    for (int c = 0; c < PEAK_CHAINS; c++)
+        acc[c] = _mm_set1_ps(c);
+    for (long t = 0; t < iters; t++)
+    {
+#pragma GCC unroll 12
+        for (int c = 0; c < PEAK_CHAINS; c++)
+            acc[c] = _mm_add_ps(_mm_mul_ps(acc[c], a), b);
+    }
+    float lanes[4], sum = 0;
+    for (int c = 0; c < PEAK_CHAINS; c++)
+    {
+        _mm_storeu_ps(lanes, acc[c]);
+        sum += lanes[0];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma"))) static double peakAVX2(long iters)
+{
+    __m256 acc[PEAK_CHAINS];
+    __m256 a = _mm256_set1_ps(0.999999f), b = _mm256_set1_ps(1e-7f);
+    for (int c = 0; c < PEAK_CHAINS; c++)
+        acc[c] = _mm256_set1_ps(c);
+    for (long t = 0; t < iters; t++)
+    {
+#pragma GCC unroll 12
+        for (int c = 0; c < PEAK_CHAINS; c++)
+            acc[c] = _mm256_fmadd_ps(acc[c], a, b);
+    }
+    float lanes[8], sum = 0;
+    for (int c = 0; c < PEAK_CHAINS; c++)
+    {
+        _mm256_storeu_ps(lanes, acc[c]);
+        sum += lanes[0];
+    }
+    return sum;
+}
+
+__attribute__((target("avx512f"))) static double peakAVX512(long iters)
+{
+    __m512 acc[PEAK_CHAINS];
+    __m512 a = _mm512_set1_ps(0.999999f), b = _mm512_set1_ps(1e-7f);
+    for (int c = 0; c < PEAK_CHAINS; c++)
+        acc[c] = _mm512_set1_ps(c);
+    for (long t = 0; t < iters; t++)
+    {
+#pragma GCC unroll 12
+        for (int c = 0; c < PEAK_CHAINS; c++)
+            acc[c] = _mm512_fmadd_ps(acc[c], a, b);
+    }
+    float lanes[16], sum = 0;
+    for (int c = 0; c < PEAK_CHAINS; c++)
+    {
+        _mm512_storeu_ps(lanes, acc[c]);
+        sum += lanes[0];
+    }
+    return sum;
+}
+#endif
+
+#ifdef SIMD_NEON
+static double peakNEON(long iters)
+{
+    float32x4_t acc[PEAK_CHAINS];
+    float32x4_t a = vdupq_n_f32(0.999999f), b = vdupq_n_f32(1e-7f);
+    for (int c = 0; c < PEAK_CHAINS; c++)
+        acc[c] = vdupq_n_f32(c);
+    for (long t = 0; t < iters; t++)
+    {
+#pragma GCC unroll 12
+        for (int c = 0; c < PEAK_CHAINS; c++)
+            acc[c] = vfmaq_f32(b, acc[c], a);
+    }
+    float sum = 0;
+    for (int c = 0; c < PEAK_CHAINS; c++)
+        sum += vgetq_lane_f32(acc[c], 0);
+    return sum;
+}
+#endif
+
+// GFLOP/s of peak loop of backend
+static double peakGflops(const SimdKernels &kernels)
+{
+    double (*peak)(long) = peakScalar;
+#ifdef SIMD_X86
+    if (strcmp(kernels.name, "sse2") == 0)
+        peak = peakSSE2;
+    if (strcmp(kernels.name, "avx2") == 0)
+        peak = peakAVX2;
+    if (strcmp(kernels.name, "avx512") == 0)
+        peak = peakAVX512;
+#endif
+#ifdef SIMD_NEON
+    if (strcmp(kernels.name, "neon") == 0)
+        peak = peakNEON;
+#endif
+    peak(PEAK_ITERS / 10); // warm up clock
+    auto start = chrono::steady_clock::now();
+    volatile double sink = peak(PEAK_ITERS);
+    (void)sink;
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return 2.0 * PEAK_CHAINS * kernels.width * PEAK_ITERS / seconds / 1e9;
+}
+
+//===elimination======================================================================================================================
+enum BenchKernel
+{
+    BENCH_ONE_ROW,   // eliminate row by row
+    BENCH_MULTI_ROW, // eliminateRows by one pivot row
+    BENCH_TWO_PIVOTS // eliminateRows by two pivot rows
+};
+
+// GFLOP/s of updating rows x cols by kernel, repeated until MIN_SECONDS passed
+static double eliminateGflops(const SimdKernels &kernels, BenchKernel kernel, int rows, int cols)
+{
+    int pivots = kernel == BENCH_TWO_PIVOTS ? 2 : 1;
+    vector<float> block((size_t)rows * cols), pivotBlock((size_t)pivots * cols), factors((size_t)rows * pivots);
+    vector<float *> rowPtr(rows);
+    const float *pivotRows[SIMD_MAX_PIVOTS];
+    for (int r = 0; r < rows; r++)
+    {
+        rowPtr[r] = block.data() + (size_t)r * cols;
+        for (int p = 0; p < pivots; p++)
+            factors[r * pivots + p] = (r % 2 == 0 ? 1e-4f : -1e-4f);
+        for (int j = 0; j < cols; j++)
+            rowPtr[r][j] = (float)(r + j) / cols;
+    }
+    for (int p = 0; p < pivots; p++)
+    {
+        pivotRows[p] = pivotBlock.data() + (size_t)p * cols;
+        for (int j = 0; j < cols; j++)
+            pivotBlock[(size_t)p * cols + j] = (float)(j + p) / cols;
+    }
+
+    long reps = 0;
+    double seconds = 0;
+    auto start = chrono::steady_clock::now();
+    while (seconds < MIN_SECONDS)
+    {
+        if (kernel == BENCH_ONE_ROW)
+        {
+            for (int r = 0; r < rows; r++)
+                kernels.eliminate(rowPtr[r], pivotRows[0], 0, cols, factors[r]);
+        }
+        else
+            kernels.eliminateRows(rowPtr.data(), pivotRows, pivots, factors.data(), rows, 0, cols);
+        reps++;
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    return 2.0 * pivots * rows * cols * reps / seconds / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    int cols = argc > 1 ? atoi(argv[1]) : 1024;
+    int cacheRows = argc > 2 ? atoi(argv[2]) : 48;
+    int memoryRows = argc > 3 ? atoi(argv[3]) : 4096;
+    const int count = sizeof(simdBackends) / sizeof(SimdKernels);
+
+    cout << fixed << setprecision(2);
+    cout << "isa     peak  | rows  cols  one-row  %peak  multi-row  %peak  two-pivots  %peak" << endl;
+    for (int i = 0; i < count; i++)
+    {
+        const SimdKernels &kernels = simdBackends[i];
+        if (!simdSupported(kernels))
+            continue;
+        double peak = peakGflops(kernels);
+        for (int rows : {cacheRows, memoryRows})
+        {
+            double one = eliminateGflops(kernels, BENCH_ONE_ROW, rows, cols);
+            double multi = eliminateGflops(kernels, BENCH_MULTI_ROW, rows, cols);
+            double two = eliminateGflops(kernels, BENCH_TWO_PIVOTS, rows, cols);
+            cout << setw(6) << left << kernels.name << right << setw(7) << peak << " | " << setw(5) << rows
+                 << setw(6) << cols << setw(9) << one << setw(7) << one / peak * 100 << setw(11) << multi << setw(7)
+                 << multi / peak * 100 << setw(12) << two << setw(7) << two / peak * 100 << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file threadPool.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief persistent worker pool with a sense-reversing barrier for the pthread gauss engines
+ * @version 0.1
+ * @date 2022-07-14
+ *
+ * @copyright Copyright (c) 2022
+ * @details the pthread engines used to create and join their threads on every call and to meet at two
+ *          pthread_barrier_wait per pivot step, each a futex sleep and wake. ThreadPool creates its workers once and
+ *          keeps them parked between calls. its barrier is sense-reversing: every thread flips a private sense, the
+ *          last one to arrive flips the shared sense and the others poll it, so a step costs a few cache line
+ *          transfers. a waiting thread polls POOL_SPIN times before it parks on a futex, and only parks at once
+ *          when there are more threads than cpus, where polling would steal the cpu of the thread being waited for.
+ *          cpus are those the process may run on (cpus.h), which taskset, cgroup cpusets and
+ *          mpirun --bind-to narrow. worker i is pinned to the (i % cpus)-th of them unless the pool is built with
+ *          pin = false, the calling thread is thread 0 and keeps its affinity, so OpenMP threads it creates later are
+ *          not squeezed onto one cpu. a worker that cannot be created pinned is created unpinned, one that cannot be
+ *          created at all aborts the program, since every barrier would wait for it forever.
+ *
+ *          usage:
+ *              ThreadPool pool(NUM_THREADS);          // once, threads 1..NUM_THREADS-1 start and park
+ *
+ *              void *threadFunc(void *param)          // same signature pthread_create takes
+ *              {
+ *                  ...
+ *                  pool.barrier(threadID);            // instead of pthread_barrier_wait
+ *                  return NULL;                       // not pthread_exit, the worker lives on
+ *              }
+ *
+ *              pool.run(threadFunc, threadParam);     // threadFunc(&threadParam[i]) on thread i, returns when all end
+ *
+ *          linux only, like pthread_barrier_t and pthread_setaffinity_np
+ *
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include "cpus.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define POOL_PAUSE() _mm_pause()
+#elif defined(__aarch64__)
+#define POOL_PAUSE() __asm__ __volatile__("yield")
+#else
+#define POOL_PAUSE()
+#endif
+
+#define POOL_SPIN 4000       // polls before a waiting thread parks, some microseconds
+#define POOL_MAX_THREADS 256 // most threads of a pool
+#define POOL_LINE 64         // bytes of a cache line, shared words get one each
+
+static_assert(sizeof(std::atomic<int>) == sizeof(int), "futex needs a plain int");
+
+// park while *word == value, returns at once if it already differs
+static inline void poolFutexWait(std::atomic<int> *word, int value)
+{
+    syscall(SYS_futex, reinterpret_cast<int *>(word), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+}
+
+// wake every thread parked on word
+static inline void poolFutexWake(std::atomic<int> *word)
+{
+    syscall(SYS_futex, reinterpret_cast<int *>(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+
+/**
+ * @brief workers created once, running one function on all threads per run and meeting at barrier
+ *
+ */
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int threads, bool pin = true)
+        : threads(threads < 1 ? 1 : (threads > POOL_MAX_THREADS ? POOL_MAX_THREADS : threads)), spin(POOL_SPIN),
+          arrived(0), sense(0), generation(0), sleepers(0), stop(false), job(nullptr), jobParams(nullptr),
+          jobParamSize(0)
+    {
+        std::vector<int> cpus = cpusAllowed();
+        if (this->threads > (int)cpus.size())
+            spin = 0;
+        for (int t = 0; t < this->threads; t++)
+            slots[t].sense = 0;
+
+        for (int t = 1; t < this->threads; t++)
+        {
+            workers[t].pool = this;
+            workers[t].threadID = t;
+            if (!(pin && start(t, cpus[t % cpus.size()])) && !start(t, -1))
+            {
+                fprintf(stderr, "ThreadPool: cannot create worker %d of %d\n", t, this->threads);
+                abort();
+            }
+        }
+    }
+
+    ~ThreadPool()
+    {
+        stop.store(true, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_seq_cst);
+        wake(generation);
+        for (int t = 1; t < threads; t++)
+            pthread_join(workers[t].handle, NULL);
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // func(&params[t]) on every thread t, the caller runs thread 0, returns after all of them and a barrier
+    template <class Param>
+    void run(void *(*func)(void *), Param *params)
+    {
+        job = func;
+        jobParams = reinterpret_cast<char *>(params);
+        jobParamSize = sizeof(Param);
+        generation.fetch_add(1, std::memory_order_seq_cst); // publishes job
+        wake(generation);
+        func(params);
+        barrier(0);
+    }
+
+    // wait until every thread of the pool called it, threadID in [0, size())
+    void barrier(int threadID)
+    {
+        int mySense = slots[threadID].sense = !slots[threadID].sense;
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) == threads - 1)
+        {
+            arrived.store(0, std::memory_order_relaxed); // nobody arrives again before sense flips
+            sense.store(mySense, std::memory_order_seq_cst);
+            wake(sense);
+        }
+        else
+            waitWhile(sense, !mySense);
+    }
+
+    int size() const
+    {
+        return threads;
+    }
+
+private:
+    struct alignas(POOL_LINE) Slot
+    {
+        int sense; // private sense of a thread, flipped at every barrier
+    };
+
+    struct Worker
+    {
+        ThreadPool *pool;
+        int threadID;
+        pthread_t handle;
+    };
+
+    // create worker t pinned to cpu, unpinned if cpu < 0, false if it was not created
+    bool start(int t, int cpu)
+    {
+        pthread_attr_t attr;
+        if (pthread_attr_init(&attr) != 0)
+            return false;
+        bool ok = true;
+        if (cpu >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            ok = pthread_attr_setaffinity_np(&attr, sizeof(set), &set) == 0;
+        }
+        ok = ok && pthread_create(&workers[t].handle, &attr, worker, &workers[t]) == 0;
+        pthread_attr_destroy(&attr);
+        return ok;
+    }
+
+    // poll word while it equals value, then park on it
+    void waitWhile(std::atomic<int> &word, int value)
+    {
+        for (int i = 0; i < spin; i++)
+        {
+            if (word.load(std::memory_order_acquire) != value)
+                return;
+            POOL_PAUSE();
+        }
+        sleepers.fetch_add(1, std::memory_order_seq_cst); // seen by wake unless word changed before futex checks it
+        while (word.load(std::memory_order_acquire) == value)
+            poolFutexWait(&word, value);
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // futex wake only when someone parked, polling threads need no system call
+    void wake(std::atomic<int> &word)
+    {
+        if (sleepers.load(std::memory_order_seq_cst) > 0)
+            poolFutexWake(&word);
+    }
+
+    static void *worker(void *param)
+    {
+        Worker *self = static_cast<Worker *>(param);
+        ThreadPool *pool = self->pool;
+        int seen = 0;
+        while (true)
+        {
+            pool->waitWhile(pool->generation, seen);
+            seen = pool->generation.load(std::memory_order_acquire);
+            if (pool->stop.load(std::memory_order_relaxed))
+                break;
+            pool->job(pool->jobParams + self->threadID * pool->jobParamSize);
+            pool->barrier(self->threadID);
+        }
+        return NULL;
+    }
+
+    int threads;
+    int spin;                                        // polls before parking, 0 when threads outnumber cpus
+    alignas(POOL_LINE) std::atomic<int> arrived;     // threads at the current barrier
+    alignas(POOL_LINE) std::atomic<int> sense;       // flipped by the last thread of a barrier
+    alignas(POOL_LINE) std::atomic<int> generation;  // bumped for every run
+    alignas(POOL_LINE) std::atomic<int> sleepers;    // threads parked on a futex
+    std::atomic<bool> stop;
+    void *(*job)(void *);
+    char *jobParams;
+    size_t jobParamSize;
+    Slot slots[POOL_MAX_THREADS];
+    Worker workers[POOL_MAX_THREADS];
+};
+
+#endif
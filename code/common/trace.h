@@ -0,0 +1,291 @@
+/**
+ * @file trace.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief phase tracer of MPI gauss elimination
+ * @version 0.1
+ * @date 2022-07-08
+ *
+ * @copyright Copyright (c) 2022
+ * @details spans of every rank and thread are recorded in memory while running, then gathered to processor 0 by
+ *          traceFinish, which writes a Chrome trace (open with chrome://tracing or ui.perfetto.dev) and a per-phase
+ *          summary csv. tracing is off unless environment variable MPI_TRACE is set to the output prefix, e.g.
+ *          MPI_TRACE=v4 mpirun -np 4 ./v4 writes v4.json and v4.csv
+ *
+ *          usage:
+ *              traceInit();                              // after MPI_Init
+ *              {
+ *                  TraceSpan span(PHASE_RECV, bytes);    // records the scope it lives in
+ *                  MPI_Recv(...);
+ *              }
+ *              TraceSpan reduce(PHASE_REDUCE);
+ *              ...
+ *              reduce.end();                             // or end a span explicitly
+ *              traceFinish();                            // before MPI_Finalize, out of parallel regions
+ *
+ *          spans may nest, time of a span in the csv excludes time of spans nested in it on the same thread
+ *
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "mpi.h"
+
+enum TracePhase
+{
+    PHASE_PARSE,     // read input files
+    PHASE_SCATTER,   // distribute task
+    PHASE_BCAST,     // broadcast rows
+    PHASE_ALLREDUCE, // global reduction, e.g. pivot search
+    PHASE_REDUCE,    // elimination
+    PHASE_RECV,      // wait in receive
+    PHASE_SEND,      // send rows
+    PHASE_RMA,       // one-sided get and put
+    PHASE_GATHER,    // collect result
+    PHASE_WRITE,     // write result
+    PHASE_NUM
+};
+
+static const char *tracePhaseName[PHASE_NUM] = {"parse", "scatter", "bcast", "allreduce", "reduce",
+                                                "recv", "send", "rma", "gather", "write"};
+
+typedef struct TraceEvent
+{
+    int phase;       // TracePhase
+    int tid;         // serial number of thread in rank
+    double begin;    // seconds since traceInit
+    double end;      // seconds since traceInit
+    double child;    // seconds spent in nested spans
+    long long bytes; // bytes moved by span
+} TraceEvent;
+
+typedef struct TraceBuffer
+{
+    int tid;
+    std::vector<TraceEvent> events;
+    std::vector<int> open; // spans not ended yet, innermost at back
+} TraceBuffer;
+
+static bool traceEnabled = false;
+static std::string tracePrefix;
+static std::chrono::steady_clock::time_point traceStart;
+static std::vector<TraceBuffer *> traceBuffers; // one per thread that recorded a span
+static std::mutex traceMutex;                   // guards traceBuffers
+static thread_local TraceBuffer *traceBuffer = nullptr;
+
+static inline double traceNow()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - traceStart).count();
+}
+
+static inline TraceBuffer *traceLocal()
+{
+    if (traceBuffer == nullptr)
+    {
+        std::lock_guard<std::mutex> guard(traceMutex);
+        traceBuffer = new TraceBuffer;
+        traceBuffer->tid = traceBuffers.size();
+        traceBuffer->events.reserve(4096);
+        traceBuffers.push_back(traceBuffer);
+    }
+    return traceBuffer;
+}
+
+/**
+ * @brief records scope it lives in as a span of phase, costs a branch when tracing is off
+ *
+ */
+class TraceSpan
+{
+public:
+    TraceSpan(int phase, long long bytes = 0) : buffer(nullptr), index(-1)
+    {
+        if (!traceEnabled)
+            return;
+        buffer = traceLocal();
+        index = buffer->events.size();
+        buffer->events.push_back({phase, buffer->tid, traceNow(), 0.0, 0.0, bytes});
+        buffer->open.push_back(index);
+    }
+
+    ~TraceSpan()
+    {
+        end();
+    }
+
+    // end span before its scope ends
+    void end()
+    {
+        if (buffer == nullptr)
+            return;
+        TraceEvent &event = buffer->events[index];
+        event.end = traceNow();
+        buffer->open.pop_back();
+        if (!buffer->open.empty())
+            buffer->events[buffer->open.back()].child += event.end - event.begin;
+        buffer = nullptr;
+    }
+
+    // add bytes known only after span begins
+    void addBytes(long long bytes)
+    {
+        if (buffer != nullptr)
+            buffer->events[index].bytes += bytes;
+    }
+
+private:
+    TraceBuffer *buffer;
+    int index;
+};
+
+/**
+ * @brief decide whether to trace and align clocks of all ranks, call after MPI_Init
+ *
+ */
+static void traceInit()
+{
+    int myid;
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    const char *prefix = getenv("MPI_TRACE");
+    int enabled = (prefix != nullptr && *prefix != '\0') ? 1 : 0;
+    MPI_Bcast(&enabled, 1, MPI_INT, 0, MPI_COMM_WORLD); // follow processor 0 in case environment differs
+    traceEnabled = enabled == 1;
+    if (!traceEnabled)
+        return;
+    if (myid == 0)
+        tracePrefix = prefix;
+    MPI_Barrier(MPI_COMM_WORLD);
+    traceStart = std::chrono::steady_clock::now();
+}
+
+static void traceWriteJson(TraceEvent *events, int *counts, int numprocs)
+{
+    std::ofstream out(tracePrefix + ".json");
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (int rank = 0; rank < numprocs; rank++)
+    {
+        out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"rank " << rank
+            << "\"}},\n";
+    }
+    bool first = true;
+    for (int rank = 0, k = 0; rank < numprocs; rank++)
+    {
+        for (int i = 0; i < counts[rank]; i++, k++)
+        {
+            TraceEvent &event = events[k];
+            out << (first ? "" : ",\n") << "{\"name\":\"" << tracePhaseName[event.phase]
+                << "\",\"cat\":\"mpi\",\"ph\":\"X\",\"pid\":" << rank << ",\"tid\":" << event.tid
+                << ",\"ts\":" << event.begin * 1e6 << ",\"dur\":" << (event.end - event.begin) * 1e6
+                << ",\"args\":{\"bytes\":" << event.bytes << "}}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+}
+
+static void traceWriteCsv(TraceEvent *events, int *counts, int numprocs)
+{
+    // seconds[rank][phase], summed over threads of rank
+    std::vector<std::vector<double>> seconds(numprocs, std::vector<double>(PHASE_NUM, 0.0));
+    std::vector<long long> calls(PHASE_NUM, 0);
+    std::vector<long long> bytes(PHASE_NUM, 0);
+    for (int rank = 0, k = 0; rank < numprocs; rank++)
+    {
+        for (int i = 0; i < counts[rank]; i++, k++)
+        {
+            TraceEvent &event = events[k];
+            seconds[rank][event.phase] += event.end - event.begin - event.child;
+            calls[event.phase]++;
+            bytes[event.phase] += event.bytes;
+        }
+    }
+
+    std::ofstream out(tracePrefix + ".csv");
+    out << "phase,calls,bytes,min_s,avg_s,max_s,max_rank\n";
+    out << std::fixed << std::setprecision(6);
+    for (int phase = 0; phase < PHASE_NUM; phase++)
+    {
+        if (calls[phase] == 0)
+            continue;
+        double minSeconds = seconds[0][phase], maxSeconds = seconds[0][phase], sumSeconds = 0.0;
+        int maxRank = 0;
+        for (int rank = 0; rank < numprocs; rank++)
+        {
+            sumSeconds += seconds[rank][phase];
+            if (seconds[rank][phase] < minSeconds)
+                minSeconds = seconds[rank][phase];
+            if (seconds[rank][phase] > maxSeconds)
+            {
+                maxSeconds = seconds[rank][phase];
+                maxRank = rank;
+            }
+        }
+        out << tracePhaseName[phase] << ',' << calls[phase] << ',' << bytes[phase] << ',' << minSeconds << ','
+            << sumSeconds / numprocs << ',' << maxSeconds << ',' << maxRank << '\n';
+    }
+    out.close();
+}
+
+/**
+ * @brief gather spans to processor 0 and write trace files, call before MPI_Finalize when no span is open
+ *
+ */
+static void traceFinish()
+{
+    if (!traceEnabled)
+        return;
+    int myid, numprocs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+
+    std::vector<TraceEvent> local;
+    for (TraceBuffer *buffer : traceBuffers)
+    {
+        local.insert(local.end(), buffer->events.begin(), buffer->events.end());
+        delete buffer;
+    }
+    traceBuffers.clear();
+    traceBuffer = nullptr;
+    traceEnabled = false;
+
+    int count = local.size() * sizeof(TraceEvent);
+    int *counts = nullptr;
+    int *displs = nullptr;
+    char *all = nullptr;
+    if (myid == 0)
+        counts = new int[numprocs];
+    MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (myid == 0)
+    {
+        displs = new int[numprocs];
+        int total = 0;
+        for (int rank = 0; rank < numprocs; rank++)
+        {
+            displs[rank] = total;
+            total += counts[rank];
+        }
+        all = new char[total > 0 ? total : 1];
+    }
+    MPI_Gatherv(local.data(), count, MPI_BYTE, all, counts, displs, MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    if (myid == 0)
+    {
+        for (int rank = 0; rank < numprocs; rank++)
+            counts[rank] /= sizeof(TraceEvent);
+        traceWriteJson((TraceEvent *)all, counts, numprocs);
+        traceWriteCsv((TraceEvent *)all, counts, numprocs);
+        delete[] counts;
+        delete[] displs;
+        delete[] all;
+    }
+}
+
+#endif
@@ -0,0 +1,284 @@
+/**
+ * @file tuning.h
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief tuning file of the autotuned gauss engines, the fastest configuration per cpu model and matrix size
+ * @version 0.1
+ * @date 2022-07-24
+ *
+ * @copyright Copyright (c) 2022
+ * @details which engine, how many threads and what schedule chunk is fastest depends on n and on the machine, and
+ *          was read off spreadsheets by hand. an autotuner measures the candidates once and keeps the winner here,
+ *          later runs on the same kind of cpu look it up and run it straight away. a tuning file is a text file,
+ *          one configuration per line, fields separated by tabs:
+ *              cpu model    n    mode    threads    chunk    seconds
+ *          the cpu model is "model name" of /proc/cpuinfo, or the implementer and part of an arm cpu, so one file
+ *          can be shared by machines of different kinds. tuningSave replaces the line of the same cpu and n through
+ *          a temporary file and rename, a reader never sees a half written file.
+ *
+ *
+ *          tuningSearch is the autotuner the programs share, in three rounds: every mode on all allowed cpus, then
+ *          the thread counts of the TUNING_KEEP fastest modes, then the chunks of the winner if it takes one. before
+ *          a configuration is timed it runs on the well conditioned matrixGenCheck matrix and must agree with the
+ *          serial engine there, wrong configurations are skipped and never saved. the measured matrix itself is not
+ *          compared, in float it is ill conditioned and engines with and without fma disagree on it.
+ *
+ *          usage:
+ *              TuningEntry best;
+ *              if (!tuningLoad(path, tuningCpuModel(), n, best))
+ *              {
+ *                  // modes: {mode, name, threaded, chunked} of the program, run: applies config and times its mode
+ *                  if (tuningSearch(n, modes, SERIAL_FUNC, CHUNK, run, a, a_bac, best))
+ *                      tuningSave(path, best);
+ *              }
+ *
+ */
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "cpus.h"
+#include "matrix.h"
+#include "matrixGen.h"
+
+#define TUNING_REPEAT 3       // runs of every configuration, the shortest counts
+#define TUNING_KEEP 3         // modes of the first round whose thread counts are tried
+#define TUNING_TOLERANCE 1e-3 // relative error a checked result may have
+#define TUNING_MAX_CHUNK 64   // largest chunk tried, chunks are powers of two
+
+struct TuningEntry
+{
+    std::string cpu; // cpu model the entry was measured on
+    int n;           // matrix size
+    int mode;        // engine, *_FUNC of the program
+    int threads;     // threads of the engine
+    int chunk;       // schedule chunk of the engine
+    double seconds;  // time measured for the configuration
+};
+
+// model of the cpu running the program, tabs replaced so that it fits in one field
+static inline std::string tuningCpuModel()
+{
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line, model, implementer, part;
+    while (std::getline(cpuinfo, line))
+    {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+        std::string key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        std::string value = colon + 2 <= line.size() ? line.substr(colon + 2) : "";
+        if (key == "model name" && model.empty())
+            model = value;
+        else if (key == "CPU implementer" && implementer.empty())
+            implementer = value;
+        else if (key == "CPU part" && part.empty())
+            part = value;
+    }
+    if (model.empty())
+        model = implementer.empty() ? "unknown" : "arm " + implementer + " " + part;
+    for (char &c : model)
+    {
+        if (c == '\t')
+            c = ' ';
+    }
+    return model;
+}
+
+// thread counts worth trying: powers of two below the number of allowed cpus, and the number of allowed cpus
+static inline std::vector<int> tuningThreadCounts()
+{
+    int cpus = cpusAllowedCount();
+    std::vector<int> counts;
+    for (int t = 1; t < cpus; t *= 2)
+        counts.push_back(t);
+    counts.push_back(cpus);
+    return counts;
+}
+
+static inline bool tuningParse(const std::string &line, TuningEntry &entry)
+{
+    size_t tab = line.find('\t');
+    if (tab == std::string::npos)
+        return false;
+    entry.cpu = line.substr(0, tab);
+    std::istringstream fields(line.substr(tab + 1));
+    return (bool)(fields >> entry.n >> entry.mode >> entry.threads >> entry.chunk >> entry.seconds);
+}
+
+static inline std::string tuningFormat(const TuningEntry &entry)
+{
+    std::ostringstream line;
+    line << entry.cpu << '\t' << entry.n << '\t' << entry.mode << '\t' << entry.threads << '\t' << entry.chunk << '\t'
+         << entry.seconds;
+    return line.str();
+}
+
+// entry of cpu and n in the tuning file at path, false if there is none
+static inline bool tuningLoad(const std::string &path, const std::string &cpu, int n, TuningEntry &entry)
+{
+    std::ifstream file(path);
+    std::string line;
+    TuningEntry e;
+    while (std::getline(file, line))
+    {
+        if (tuningParse(line, e) && e.cpu == cpu && e.n == n)
+        {
+            entry = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+// add entry to the tuning file at path, in place of an entry of the same cpu and n
+static inline bool tuningSave(const std::string &path, const TuningEntry &entry)
+{
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(path);
+        std::string line;
+        TuningEntry e;
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && !(tuningParse(line, e) && e.cpu == entry.cpu && e.n == entry.n))
+                lines.push_back(line);
+        }
+    }
+    lines.push_back(tuningFormat(entry));
+
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    {
+        std::ofstream file(tmp, std::ios::trunc);
+        for (const std::string &line : lines)
+            file << line << '\n';
+        if (!file.flush())
+            return false;
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0)
+    {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// a candidate engine of a program
+struct TuningMode
+{
+    int mode;         // *_FUNC of the program
+    const char *name; // printed while tuning
+    bool threaded;    // runs on config.threads threads, on one thread otherwise
+    bool chunked;     // takes config.chunk
+};
+
+// runs config.mode on a with config.threads and config.chunk applied, returns the seconds it took
+typedef std::function<double(const TuningEntry &config, Matrix<float> &a)> TuningRun;
+
+static inline void tuningCopy(int n, Matrix<float> &dst, const Matrix<float> &src)
+{
+    for (int i = 0; i < n; i++)
+        memcpy(dst[i], src[i], n * sizeof(float));
+}
+
+// fastest correct configuration of modes for a, which is restored from a_bac before every run. false when no
+// configuration agreed with serialMode, best is then serialMode on one thread, untimed, and should not be saved
+static inline bool tuningSearch(int n, const std::vector<TuningMode> &modes, int serialMode, int chunk,
+                                const TuningRun &run, Matrix<float> &a, const Matrix<float> &a_bac, TuningEntry &best)
+{
+    std::string cpu = tuningCpuModel();
+    std::vector<int> threadCounts = tuningThreadCounts();
+    Matrix<float> check(n), reference(n);
+    matrixGenCheck(matrixSeed(), n, check[0], check.stride());
+    tuningCopy(n, reference, check);
+    run({cpu, n, serialMode, 1, chunk, 0}, reference);
+
+    // check config against reference, then time it, false if its result is wrong
+    auto measure = [&](const TuningMode &m, TuningEntry &config) {
+        tuningCopy(n, a, check);
+        run(config, a);
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                if (!(fabs(a[i][j] - reference[i][j]) <= TUNING_TOLERANCE * (1 + fabs(reference[i][j]))))
+                {
+                    printf("  %s, %d threads, chunk %d: wrong result, skipped\n", m.name, config.threads, config.chunk);
+                    return false;
+                }
+            }
+        }
+        config.seconds = 1e30;
+        for (int r = 0; r < TUNING_REPEAT; r++)
+        {
+            tuningCopy(n, a, a_bac);
+            config.seconds = std::min(config.seconds, run(config, a));
+        }
+        printf("  %s, %d threads, chunk %d: %g\n", m.name, config.threads, config.chunk, config.seconds);
+        return true;
+    };
+
+    std::vector<std::pair<TuningEntry, TuningMode>> byMode;
+    for (const TuningMode &m : modes) // every mode on all allowed cpus
+    {
+        TuningEntry config = {cpu, n, m.mode, m.threaded ? threadCounts.back() : 1, chunk, 0};
+        if (measure(m, config))
+            byMode.push_back({config, m});
+    }
+    if (byMode.empty())
+    {
+        printf("  no configuration gave a correct result, untuned\n");
+        best = {cpu, n, serialMode, 1, chunk, 0};
+        return false;
+    }
+    std::sort(byMode.begin(), byMode.end(),
+              [](const std::pair<TuningEntry, TuningMode> &x, const std::pair<TuningEntry, TuningMode> &y) {
+                  return x.first.seconds < y.first.seconds;
+              });
+    best = byMode[0].first;
+    TuningMode bestMode = byMode[0].second;
+
+    for (int k = 0; k < TUNING_KEEP && k < (int)byMode.size(); k++) // thread counts of the fastest modes
+    {
+        const TuningMode &m = byMode[k].second;
+        if (!m.threaded)
+            continue;
+        for (int threads : threadCounts)
+        {
+            TuningEntry config = byMode[k].first;
+            if (threads == config.threads)
+                continue;
+            config.threads = threads;
+            if (measure(m, config) && config.seconds < best.seconds)
+            {
+                best = config;
+                bestMode = m;
+            }
+        }
+    }
+
+    if (bestMode.chunked) // chunks of the winner
+    {
+        TuningEntry base = best;
+        for (int c = 1; c <= TUNING_MAX_CHUNK; c *= 2)
+        {
+            TuningEntry config = base;
+            if (c == config.chunk)
+                continue;
+            config.chunk = c;
+            if (measure(bestMode, config) && config.seconds < best.seconds)
+                best = config;
+        }
+    }
+    return true;
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include <sstream>
 #include <string>
 #include <iostream>
+#include "mpi.h"
 using namespace std;
 #define ELIMINATANT false
 #define ELIMINATOR true
@@ -83,6 +84,39 @@ void writeResult(string filePath, string *sparseMatrix, int n)
     fStream.close();
 }
 
+/**
+ * @brief write result to file collectively, lines of each processor are written at their own offset
+ *
+ * @param filePath example directory path
+ * @param sparseMatrix elimination result held by current processor
+ * @param n lines held by current processor, lines of lower ranks come first in file
+ */
+void writeResultAll(string filePath, string *sparseMatrix, int n)
+{
+    filePath += "/resultFile2.txt";
+    int myid;
+    string buffer;
+    long long length;     // bytes written by current processor
+    long long offset = 0; // bytes written by lower ranks
+    MPI_File fh;
+
+    for (int i = 0; i < n; i++)
+    {
+        buffer += sparseMatrix[i];
+        buffer += '\n';
+    }
+    length = buffer.size();
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Exscan(&length, &offset, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if (myid == 0) // result of MPI_Exscan is undefined on rank 0
+        offset = 0;
+
+    MPI_File_open(MPI_COMM_WORLD, filePath.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+    MPI_File_set_size(fh, 0); // truncate as writeResult does
+    MPI_File_write_at_all(fh, offset, buffer.data(), (int)length, MPI_CHAR, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+}
+
 string getExampleName(int number)
 {
     switch (number)
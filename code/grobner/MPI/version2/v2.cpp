@@ -14,6 +14,7 @@
 #include <string>
 #include "file.h"
 #include "bitmap.h"
+#include "../../../common/trace.h"
 
 int myid;         // rank of current processor
 int numprocs;     // number of processor
@@ -47,6 +48,7 @@ int main(int argc, char *argv[])
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
     MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    traceInit();
     if (myid == 0)
         s_time = MPI_Wtime(); // start timing
 
@@ -68,6 +70,7 @@ int main(int argc, char *argv[])
         cout << "time: " << e_time - s_time << endl;
     }
 
+    traceFinish();
     MPI_Finalize();
     return 0;
 }
@@ -79,30 +82,48 @@ void init()
     wrdLen += wrdLen % INDEX_BLOCK_SIZE == 0 ? 0 : INDEX_BLOCK_SIZE - (wrdLen % INDEX_BLOCK_SIZE);
     eliminatant = new int[(long long)n_wndSize1 * wrdLen]{0};
     eliminator = new int[(long long)wndSize * wrdLen]{0};
+    int *packedEliminator = new int[(long long)wndSize2 * wrdLen]{0}; // eliminators without empty rows
+    int *lftCols = new int[wndSize2];                                   // leftest column of each packed eliminator
+
+    // only rank 0 reads and parses the files, others receive packed bitmaps
     if (myid == 0)
     {
+        TraceSpan span(PHASE_PARSE);
         string *eliminatantSparseWnd = new string[n_wndSize1];
         getSparseMatrix(examplePath, eliminatantSparseWnd, n_wndSize1, ELIMINATANT);
         createWnd(eliminatantSparseWnd, eliminatant, n_wndSize1, wrdLen, UNORDERED);
         delete[] eliminatantSparseWnd;
         eliminatantSparseWnd = nullptr;
+
+        string *eliminatorSparseWnd = new string[wndSize2];
+        getSparseMatrix(examplePath, eliminatorSparseWnd, wndSize2, ELIMINATOR);
+        createPackedWnd(eliminatorSparseWnd, packedEliminator, lftCols, wndSize2, wrdLen);
+        delete[] eliminatorSparseWnd;
+        eliminatorSparseWnd = nullptr;
+    }
+    {
+        TraceSpan span(PHASE_BCAST, (long long)wndSize2 * (wrdLen + 1) * sizeof(int));
+        MPI_Bcast(lftCols, wndSize2, MPI_INT, 0, MPI_COMM_WORLD);
+        MPI_Bcast(packedEliminator, wndSize2 * wrdLen, MPI_INT, 0, MPI_COMM_WORLD);
     }
-    string *eliminatorSparseWnd = new string[wndSize2];
-    getSparseMatrix(examplePath, eliminatorSparseWnd, wndSize2, ELIMINATOR);
-    createWnd(eliminatorSparseWnd, eliminator, wndSize2, wrdLen, ORDERED);
-    delete[] eliminatorSparseWnd;
-    eliminatorSparseWnd = nullptr;
+    unpackWnd(packedEliminator, lftCols, eliminator, wndSize2, wrdLen);
+    delete[] packedEliminator;
+    delete[] lftCols;
+    packedEliminator = nullptr;
+    lftCols = nullptr;
 }
 
 void broadcast()
 {
     np = n_wndSize1 / numprocs;
     sub = new int[(long long)np * wrdLen]{0};
+    TraceSpan span(PHASE_SCATTER, (long long)np * wrdLen * sizeof(int));
     MPI_Scatter(eliminatant, np * wrdLen, MPI_INT, sub, np * wrdLen, MPI_INT, 0, MPI_COMM_WORLD);
 }
 
 void gaussian()
 {
+    TraceSpan span(PHASE_REDUCE);
     MPI_Status status;
     subManager = new BitManager[np];
     eliminatorManager = new BitManager[wndSize];
@@ -116,11 +137,13 @@ void gaussian()
         {
             for (int j = myid + 1; j < numprocs; j++)
             {
+                TraceSpan span(PHASE_SEND, wrdLen * sizeof(int));
                 MPI_Send(tmp, wrdLen, MPI_INT, j, 0, MPI_COMM_WORLD); // sent to following processors
             }
         }
         if (myid > (i - 1) / np)
         {
+            TraceSpan span(PHASE_RECV, wrdLen * sizeof(int));
             MPI_Recv(tmp, wrdLen, MPI_INT, (i - 1) / np, 0, MPI_COMM_WORLD, &status);
         }
         if (myid >= i / np)
@@ -155,11 +178,12 @@ void gaussian()
 
 void write()
 {
-    MPI_Gather(sub, wrdLen * np, MPI_INT, eliminatant, np * wrdLen, MPI_INT, 0, MPI_COMM_WORLD);
-    if (myid == 0)
-    {
-        string *result = new string[wndSize1];
-        toString(eliminatant, wrdLen, result, wndSize1);
-        writeResult(examplePath, result, wndSize1);
-    }
+    TraceSpan span(PHASE_WRITE);
+    // each processor formats and writes its own rows, padding rows after wndSize1 are left out
+    int rows = max(0, min(np, wndSize1 - myid * np));
+    string *result = new string[rows];
+    toString(sub, wrdLen, result, rows);
+    writeResultAll(examplePath, result, rows);
+    delete[] result;
+    result = nullptr;
 }
\ No newline at end of file
@@ -275,6 +275,45 @@ void copyBitmapSingle(int *bitmap1, int *bitmap2, int wrdLen)
     }
 }
 
+/**
+ * @brief create wnd whose rows are stored one after another instead of by leftest column
+ *
+ * @param sparseWnd sparse lines of eliminators
+ * @param packedWnd result wnd, row i holds line i
+ * @param lftCols leftest column of each line, -1 for empty line
+ * @param rows number of sparse lines
+ * @param wrdLen cols per row
+ */
+void createPackedWnd(string *sparseWnd, int *packedWnd, int *lftCols, int rows, int wrdLen)
+{
+    for (int i = 0; i < rows; i++)
+    {
+        stringstream ss(*(sparseWnd + i));
+        lftCols[i] = -1;
+        ss >> lftCols[i];
+        createBitMap(sparseWnd + i, packedWnd + (long long)wrdLen * i);
+    }
+}
+
+/**
+ * @brief move rows of packed wnd to their leftest column of ordered wnd
+ *
+ * @param packedWnd wnd created by createPackedWnd
+ * @param lftCols leftest column of each row
+ * @param wnd ordered wnd
+ * @param rows rows of packed wnd
+ * @param wrdLen cols per row
+ */
+void unpackWnd(int *packedWnd, int *lftCols, int *wnd, int rows, int wrdLen)
+{
+    for (int i = 0; i < rows; i++)
+    {
+        if (lftCols[i] == -1)
+            continue;
+        copyBitmapSingle(packedWnd + (long long)wrdLen * i, wnd + (long long)wrdLen * lftCols[i], wrdLen);
+    }
+}
+
 void copyBitMap(int *bitmap1, int *bitmap2, BitManager *bitManager1, BitManager *bitManager2)
 {
     for (int i = 0; i < bitManager1->wrdLen; i++)
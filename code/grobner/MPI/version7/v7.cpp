@@ -0,0 +1,391 @@
+/**
+ * @file v7.cpp
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief
+ * @version 0.1
+ * @date 2022-07-05
+ *
+ * @copyright Copyright (c) 2022
+ * @details mainbody of MPI gauss elimination with eliminators sharded by column
+ *          each processor keeps eliminators whose leftest column lies in its own column range and exposes them
+ *          by MPI_Win, eliminators of other processors are fetched by MPI_Get into a small LRU cache, and rows
+ *          promoted to eliminators are published to their owner by MPI_Put plus a flag
+ *
+ */
+#include <stdio.h>
+#include "mpi.h"
+#include <string>
+#include <list>
+#include <algorithm>
+#include <unordered_map>
+#include "file.h"
+#include "bitmap.h"
+#include "../../../common/trace.h"
+
+#define CACHE_ROWS 64 // max eliminators of other processors cached
+
+typedef struct CacheLine
+{
+    int col;            // leftest column of eliminator
+    int *bitmap;        // copy of eliminator
+    BitManager manager; // manager of the copy
+} CacheLine;
+
+int myid;         // rank of current processor
+int numprocs;     // number of processor
+double s_time;    // start time
+double e_time;    // end time
+int *eliminatant; // eliminatant wnd
+int *shard;       // eliminators whose leftest column lies in [colBegin, colEnd)
+int *shardFlag;   // shardFlag[r] is 1 if shard row r holds an eliminator
+int *sub;         // task assigned to each processor
+int wndSize;      // max cols
+int wndSize1;     // rows of eliminatant wnd
+int wndSize2;     // rows of eliminator wnd
+int n_wndSize1;   // new rows of eliminatant
+int np;           // rows of sub
+int wrdLen;       // cols per row
+int shardCols;    // cols owned by each processor
+int colBegin;     // first col owned by current processor
+int colEnd;       // col after the last one owned by current processor
+MPI_Win shardWin; // window exposing shard
+MPI_Win flagWin;  // window exposing shardFlag
+BitManager *shardManager;
+BitManager *subManager;
+list<CacheLine> cache;                                 // remote eliminators, most recently used first
+unordered_map<int, list<CacheLine>::iterator> cacheIdx; // col -> line of cache
+
+// string basePath = "F:/大二下课程/并行计算/期末研究报告相关材料/data/Groebner/";
+string basePath = "/home/bill/Desktop/para/src/Groebner/";
+string examplePath = basePath + getExampleName(7);
+
+void init();
+void broadcast();
+void gaussian();
+void write();
+
+int main(int argc, char *argv[])
+{
+    getParam(examplePath, wndSize1, wndSize2, wndSize); // get size of wnd
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    traceInit();
+    if (myid == 0)
+        s_time = MPI_Wtime(); // start timing
+
+    /* init wnd and relavant params */
+    init();
+
+    /* broadcast task */
+    broadcast();
+
+    /* conduct elimination */
+    gaussian();
+
+    /*  gather and output result */
+    write();
+
+    if (myid == 0) // end timing
+    {
+        e_time = MPI_Wtime();
+        cout << "time: " << e_time - s_time << endl;
+    }
+
+    MPI_Win_free(&shardWin);
+    MPI_Win_free(&flagWin);
+    traceFinish();
+    MPI_Finalize();
+    return 0;
+}
+
+void init()
+{
+    n_wndSize1 = wndSize1 % numprocs == 0 ? wndSize1 : wndSize1 + (numprocs - wndSize1 % numprocs);
+    wrdLen = wndSize / WORD_BITS + 1;
+    wrdLen += wrdLen % INDEX_BLOCK_SIZE == 0 ? 0 : INDEX_BLOCK_SIZE - (wrdLen % INDEX_BLOCK_SIZE);
+    shardCols = wndSize % numprocs == 0 ? wndSize / numprocs : wndSize / numprocs + 1;
+    colBegin = min(myid * shardCols, wndSize);
+    colEnd = min(colBegin + shardCols, wndSize);
+    eliminatant = new int[(long long)n_wndSize1 * wrdLen]{0};
+
+    // shard rows are allocated for every processor alike so that displacement of column c is (c % shardCols) rows
+    MPI_Win_allocate((MPI_Aint)shardCols * wrdLen * sizeof(int), sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &shard, &shardWin);
+    MPI_Win_allocate((MPI_Aint)shardCols * sizeof(int), sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &shardFlag, &flagWin);
+    for (long long i = 0; i < (long long)shardCols * wrdLen; i++)
+    {
+        shard[i] = 0;
+    }
+    for (int i = 0; i < shardCols; i++)
+    {
+        shardFlag[i] = 0;
+    }
+
+    // only rank 0 reads and parses the files, each processor receives packed bitmaps of its own shard
+    int packedRows = 0;                                                               // eliminators of a shard
+    int *packedEliminator = new int[(long long)min(shardCols, wndSize2) * wrdLen]{0}; // eliminators of a shard without empty rows
+    int *lftCols = new int[min(shardCols, wndSize2)];                                 // leftest column of each packed eliminator
+    if (myid == 0)
+    {
+        TraceSpan span(PHASE_PARSE);
+        string *eliminatantSparseWnd = new string[n_wndSize1];
+        getSparseMatrix(examplePath, eliminatantSparseWnd, n_wndSize1, ELIMINATANT);
+        createWnd(eliminatantSparseWnd, eliminatant, n_wndSize1, wrdLen, UNORDERED);
+        delete[] eliminatantSparseWnd;
+        eliminatantSparseWnd = nullptr;
+
+        // sort sparse lines by owner so that a single shard is packed at a time
+        string *eliminatorSparseWnd = new string[wndSize2];
+        string *sortedSparseWnd = new string[wndSize2];
+        int *owners = new int[wndSize2];            // owner of each line, -1 for empty line
+        int *ownerBegin = new int[numprocs + 1]{0}; // lines of owner r are sorted into [ownerBegin[r], ownerBegin[r + 1])
+        int *ownerPos = new int[numprocs];
+        getSparseMatrix(examplePath, eliminatorSparseWnd, wndSize2, ELIMINATOR);
+        for (int i = 0; i < wndSize2; i++)
+        {
+            int lftCol = -1;
+            stringstream ss(eliminatorSparseWnd[i]);
+            ss >> lftCol;
+            owners[i] = lftCol == -1 ? -1 : lftCol / shardCols;
+            if (owners[i] != -1)
+                ownerBegin[owners[i] + 1]++;
+        }
+        for (int owner = 0; owner < numprocs; owner++)
+        {
+            ownerBegin[owner + 1] += ownerBegin[owner];
+            ownerPos[owner] = ownerBegin[owner];
+        }
+        for (int i = 0; i < wndSize2; i++)
+        {
+            if (owners[i] != -1)
+                sortedSparseWnd[ownerPos[owners[i]]++].swap(eliminatorSparseWnd[i]);
+        }
+        delete[] eliminatorSparseWnd;
+        delete[] owners;
+        delete[] ownerPos;
+        eliminatorSparseWnd = nullptr;
+        owners = nullptr;
+        ownerPos = nullptr;
+
+        for (int owner = numprocs - 1; owner >= 0; owner--)
+        {
+            packedRows = ownerBegin[owner + 1] - ownerBegin[owner];
+            createPackedWnd(sortedSparseWnd + ownerBegin[owner], packedEliminator, lftCols, packedRows, wrdLen);
+            if (owner != 0)
+            {
+                TraceSpan span(PHASE_SCATTER, (long long)packedRows * (wrdLen + 1) * sizeof(int));
+                MPI_Send(&packedRows, 1, MPI_INT, owner, 0, MPI_COMM_WORLD);
+                MPI_Send(lftCols, packedRows, MPI_INT, owner, 0, MPI_COMM_WORLD);
+                MPI_Send(packedEliminator, packedRows * wrdLen, MPI_INT, owner, 0, MPI_COMM_WORLD);
+                fill(packedEliminator, packedEliminator + (long long)packedRows * wrdLen, 0);
+            }
+        }
+        delete[] sortedSparseWnd;
+        delete[] ownerBegin;
+        sortedSparseWnd = nullptr;
+        ownerBegin = nullptr;
+    }
+    else
+    {
+        TraceSpan span(PHASE_SCATTER);
+        MPI_Recv(&packedRows, 1, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(lftCols, packedRows, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv(packedEliminator, packedRows * wrdLen, MPI_INT, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        span.addBytes((long long)packedRows * (wrdLen + 1) * sizeof(int));
+    }
+    unpackShard(packedEliminator, lftCols, shard, shardFlag, packedRows, wrdLen, colBegin);
+    delete[] packedEliminator;
+    delete[] lftCols;
+    packedEliminator = nullptr;
+    lftCols = nullptr;
+
+    shardManager = new BitManager[shardCols];
+    buildBitManager(shard, wrdLen, shardManager, shardCols);
+
+    // every shard must be ready before anyone reads it
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+void broadcast()
+{
+    np = n_wndSize1 / numprocs;
+    sub = new int[(long long)np * wrdLen]{0};
+    TraceSpan span(PHASE_SCATTER, (long long)np * wrdLen * sizeof(int));
+    MPI_Scatter(eliminatant, np * wrdLen, MPI_INT, sub, np * wrdLen, MPI_INT, 0, MPI_COMM_WORLD);
+}
+
+/**
+ * @brief get eliminator of column col, eliminators of other processors are fetched into cache
+ *
+ * @param col leftest column of eliminator
+ * @param manager set to manager of eliminator
+ * @return int* eliminator, or nullptr if column col has no eliminator yet
+ */
+int *getEliminator(int col, BitManager *&manager)
+{
+    int owner = col / shardCols;
+    int disp = col - owner * shardCols;
+    int flag = 0;
+
+    if (owner == myid)
+    {
+        MPI_Fetch_and_op(nullptr, &flag, MPI_INT, myid, disp, MPI_NO_OP, flagWin);
+        MPI_Win_flush(myid, flagWin);
+        if (flag == 0)
+            return nullptr;
+        if (shardManager[disp].lftCol == -1) // published by others after init
+        {
+            MPI_Win_sync(shardWin);
+            buildBitManager(shard + (long long)disp * wrdLen, wrdLen, shardManager + disp);
+        }
+        manager = shardManager + disp;
+        return shard + (long long)disp * wrdLen;
+    }
+
+    // eliminators never change once published, so cached ones are always valid
+    unordered_map<int, list<CacheLine>::iterator>::iterator it = cacheIdx.find(col);
+    if (it != cacheIdx.end())
+    {
+        cache.splice(cache.begin(), cache, it->second);
+        manager = &cache.front().manager;
+        return cache.front().bitmap;
+    }
+
+    {
+        TraceSpan span(PHASE_RMA, sizeof(int));
+        MPI_Fetch_and_op(nullptr, &flag, MPI_INT, owner, disp, MPI_NO_OP, flagWin);
+        MPI_Win_flush(owner, flagWin);
+    }
+    if (flag == 0)
+        return nullptr;
+
+    if (cache.size() == CACHE_ROWS) // reuse the least recently used line
+    {
+        cache.splice(cache.begin(), cache, --cache.end());
+        cacheIdx.erase(cache.front().col);
+    }
+    else
+    {
+        cache.push_front(CacheLine());
+        cache.front().bitmap = new int[wrdLen]{0};
+    }
+    CacheLine &line = cache.front();
+    line.col = col;
+    {
+        TraceSpan span(PHASE_RMA, wrdLen * sizeof(int));
+        MPI_Get(line.bitmap, wrdLen, MPI_INT, owner, (MPI_Aint)disp * wrdLen, wrdLen, MPI_INT, shardWin);
+        MPI_Win_flush(owner, shardWin);
+    }
+    buildBitManager(line.bitmap, wrdLen, &line.manager);
+    cacheIdx[col] = cache.begin();
+
+    manager = &line.manager;
+    return line.bitmap;
+}
+
+/**
+ * @brief publish bitmap as eliminator of column col to its owner
+ *
+ * @param bitmap row promoted to eliminator
+ * @param col leftest column of bitmap
+ */
+void putEliminator(int *bitmap, int col)
+{
+    int owner = col / shardCols;
+    int disp = col - owner * shardCols;
+    int flag = 1;
+    TraceSpan span(PHASE_RMA, (wrdLen + 1) * sizeof(int));
+
+    // row must be complete at owner before flag is visible
+    MPI_Put(bitmap, wrdLen, MPI_INT, owner, (MPI_Aint)disp * wrdLen, wrdLen, MPI_INT, shardWin);
+    MPI_Win_flush(owner, shardWin);
+    MPI_Accumulate(&flag, 1, MPI_INT, owner, disp, 1, MPI_INT, MPI_REPLACE, flagWin);
+    MPI_Win_flush(owner, flagWin);
+}
+
+/**
+ * @brief eliminate row of sub with every eliminator published so far
+ *
+ * @param row row of sub
+ * @return true if row has been changed
+ */
+bool eliminateRow(int row)
+{
+    bool changed = false;
+    BitManager *manager;
+    int *bitmap;
+    while (subManager[row].lftCol != -1 && (bitmap = getEliminator(subManager[row].lftCol, manager)) != nullptr)
+    {
+        xorBitmap(sub + wrdLen * row, bitmap, subManager + row, manager);
+        changed = true;
+    }
+    return changed;
+}
+
+void gaussian()
+{
+    TraceSpan span(PHASE_REDUCE);
+    MPI_Request request;
+    int token = 0;   // sent once all rows of a processor are published
+    int arrived = 1; // whether the previous processor has finished
+    subManager = new BitManager[np];
+    buildBitManager(sub, wrdLen, subManager, np);
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, shardWin);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, flagWin);
+
+    // every eliminator published so far comes from rows ahead of ours,
+    // so rows can be eliminated with them while the previous processors are still working
+    if (myid != 0)
+    {
+        MPI_Irecv(&token, 1, MPI_INT, myid - 1, 0, MPI_COMM_WORLD, &request);
+        arrived = 0;
+    }
+    while (!arrived)
+    {
+        bool changed = false;
+        for (int row = 0; row < np; row++)
+        {
+            changed = eliminateRow(row) || changed;
+        }
+        MPI_Test(&request, &arrived, MPI_STATUS_IGNORE);
+        if (!changed && !arrived)
+        {
+            TraceSpan span(PHASE_RECV, sizeof(int));
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+            arrived = 1;
+        }
+    }
+
+    // rows ahead of ours are all published, finish rows in order and publish the new eliminators
+    MPI_Win_sync(shardWin);
+    MPI_Win_sync(flagWin);
+    for (int row = 0; row < np; row++)
+    {
+        eliminateRow(row);
+        if (subManager[row].lftCol != -1)
+        {
+            putEliminator(sub + wrdLen * row, subManager[row].lftCol);
+        }
+    }
+    if (myid != numprocs - 1)
+    {
+        TraceSpan span(PHASE_SEND, sizeof(int));
+        MPI_Send(&token, 1, MPI_INT, myid + 1, 0, MPI_COMM_WORLD);
+    }
+
+    MPI_Win_unlock_all(shardWin);
+    MPI_Win_unlock_all(flagWin);
+}
+
+void write()
+{
+    TraceSpan span(PHASE_WRITE);
+    // each processor formats and writes its own rows, padding rows after wndSize1 are left out
+    int rows = max(0, min(np, wndSize1 - myid * np));
+    string *result = new string[rows];
+    toString(sub, wrdLen, result, rows);
+    writeResultAll(examplePath, result, rows);
+    delete[] result;
+    result = nullptr;
+}
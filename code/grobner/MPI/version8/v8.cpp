@@ -0,0 +1,301 @@
+/**
+ * @file v8.cpp
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief
+ * @version 0.1
+ * @date 2022-07-06
+ *
+ * @copyright Copyright (c) 2022
+ * @details mainbody of MPI gauss elimination and openmp and sse(SIMD) with a communication thread
+ *          thread 0 of each processor receives rows along the pipeline, applies them to the eliminators and
+ *          forwards them, then finishes its own rows in order, while the other threads keep eliminating
+ *          unfinished rows with whatever eliminators have been published
+ *
+ */
+#include <stdio.h>
+#include "mpi.h"
+#include <string>
+#include <atomic>
+#include <sched.h>
+#include "file.h"
+#include "bitmap.h"
+#include "../../../common/trace.h"
+#include <omp.h>
+
+int myid;         // rank of current processor
+int numprocs;     // number of processor
+double s_time;    // start time
+double e_time;    // end time
+int *eliminatant; // eliminatant wnd
+int *eliminator;  // eliminatant wnd
+int *sub;         // task assigned to each processor
+int wndSize;      // max cols
+int wndSize1;     // rows of eliminatant wnd
+int wndSize2;     // rows of eliminator wnd
+int n_wndSize1;   // new rows of eliminatant
+int np;           // rows of sub
+int wrdLen;       // cols per row
+BitManager *eliminatantManager;
+BitManager *eliminatorManager;
+BitManager *subManager;
+atomic<int> *published; // published[c] is 1 once eliminator of column c can be used by every thread
+atomic<int> epoch;      // increased whenever an eliminator is published
+atomic<int> finished;   // rows of sub finished by communication thread
+omp_lock_t *rowLock;    // held by the thread eliminating the row
+
+// string basePath = "F:/大二下课程/并行计算/期末研究报告相关材料/data/Groebner/";
+string basePath = "/home/bill/Desktop/para/src/Groebner/";
+string examplePath = basePath + getExampleName(7);
+
+void init();
+void broadcast();
+void gaussian();
+void write();
+
+int main(int argc, char *argv[])
+{
+    getParam(examplePath, wndSize1, wndSize2, wndSize); // get size of wnd
+    int provided;                                       // thread safety level provided
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    if (provided < MPI_THREAD_FUNNELED) // only the master thread communicates
+    {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    traceInit();
+    if (myid == 0)
+        s_time = MPI_Wtime(); // start timing
+
+    /* init wnd and relavant params */
+    init();
+
+    /* broadcast task */
+    broadcast();
+
+    /* conduct elimination */
+    gaussian();
+
+    /*  gather and output result */
+    write();
+
+    if (myid == 0) // end timing
+    {
+        e_time = MPI_Wtime();
+        cout << "time: " << e_time - s_time << endl;
+    }
+
+    traceFinish();
+    MPI_Finalize();
+    return 0;
+}
+
+void init()
+{
+    n_wndSize1 = wndSize1 % numprocs == 0 ? wndSize1 : wndSize1 + (numprocs - wndSize1 % numprocs);
+    wrdLen = wndSize / WORD_BITS + 1;
+    wrdLen += wrdLen % INDEX_BLOCK_SIZE == 0 ? 0 : INDEX_BLOCK_SIZE - (wrdLen % INDEX_BLOCK_SIZE);
+    eliminatant = new int[(long long)n_wndSize1 * wrdLen]{0};
+    eliminator = new int[(long long)wndSize * wrdLen]{0};
+    int *packedEliminator = new int[(long long)wndSize2 * wrdLen]{0}; // eliminators without empty rows
+    int *lftCols = new int[wndSize2];                                   // leftest column of each packed eliminator
+
+    // only rank 0 reads and parses the files, others receive packed bitmaps
+    if (myid == 0)
+    {
+        TraceSpan span(PHASE_PARSE);
+        string *eliminatantSparseWnd = new string[n_wndSize1];
+        getSparseMatrix(examplePath, eliminatantSparseWnd, n_wndSize1, ELIMINATANT);
+        createWnd(eliminatantSparseWnd, eliminatant, n_wndSize1, wrdLen, UNORDERED);
+        delete[] eliminatantSparseWnd;
+        eliminatantSparseWnd = nullptr;
+
+        string *eliminatorSparseWnd = new string[wndSize2];
+        getSparseMatrix(examplePath, eliminatorSparseWnd, wndSize2, ELIMINATOR);
+        createPackedWnd(eliminatorSparseWnd, packedEliminator, lftCols, wndSize2, wrdLen);
+        delete[] eliminatorSparseWnd;
+        eliminatorSparseWnd = nullptr;
+    }
+    {
+        TraceSpan span(PHASE_BCAST, (long long)wndSize2 * (wrdLen + 1) * sizeof(int));
+        MPI_Bcast(lftCols, wndSize2, MPI_INT, 0, MPI_COMM_WORLD);
+        MPI_Bcast(packedEliminator, wndSize2 * wrdLen, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+    unpackWnd(packedEliminator, lftCols, eliminator, wndSize2, wrdLen);
+    delete[] packedEliminator;
+    delete[] lftCols;
+    packedEliminator = nullptr;
+    lftCols = nullptr;
+}
+
+void broadcast()
+{
+    np = n_wndSize1 / numprocs;
+    sub = new int[(long long)np * wrdLen]{0};
+    TraceSpan span(PHASE_SCATTER, (long long)np * wrdLen * sizeof(int));
+    MPI_Scatter(eliminatant, np * wrdLen, MPI_INT, sub, np * wrdLen, MPI_INT, 0, MPI_COMM_WORLD);
+}
+
+/**
+ * @brief make bitmap the eliminator of its leftest column if that column has none
+ *
+ * @param bitmap row finished by elimination
+ * @param bitManager manager of bitmap
+ */
+void publish(int *bitmap, BitManager *bitManager)
+{
+    int lftCol = bitManager->lftCol;
+    if (lftCol == -1 || published[lftCol].load(memory_order_relaxed) == 1)
+        return;
+    copyBitMap(bitmap, eliminator + wrdLen * lftCol, bitManager, eliminatorManager + lftCol);
+    published[lftCol].store(1, memory_order_release);
+    epoch.fetch_add(1, memory_order_release);
+}
+
+/**
+ * @brief eliminate row of sub with every eliminator published so far
+ *
+ * @param row row of sub
+ */
+void eliminateRow(int row)
+{
+    int lftCol;
+    while ((lftCol = subManager[row].lftCol) != -1 && published[lftCol].load(memory_order_acquire) == 1)
+    {
+        xorBitmap(sub + wrdLen * row, eliminator + wrdLen * lftCol, subManager + row, eliminatorManager + lftCol);
+    }
+}
+
+/**
+ * @brief communication thread, the only one calling MPI
+ *
+ */
+void communicate()
+{
+    int *tmp = new int[wrdLen]{0};
+    BitManager tmpManager;
+
+    // rows of lower ranks arrive in order along the pipeline
+    for (int i = 0; i < myid * np; i++)
+    {
+        {
+            TraceSpan span(PHASE_RECV, wrdLen * sizeof(int));
+            MPI_Recv(tmp, wrdLen, MPI_INT, myid - 1, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        if (myid != (numprocs - 1))
+        {
+            TraceSpan span(PHASE_SEND, wrdLen * sizeof(int));
+            MPI_Send(tmp, wrdLen, MPI_INT, myid + 1, 0, MPI_COMM_WORLD);
+        }
+        buildBitManager(tmp, wrdLen, &tmpManager);
+        publish(tmp, &tmpManager);
+    }
+
+    // every row ahead is published, finish own rows in order and send them down the pipeline
+    for (int row = 0; row < np; row++)
+    {
+        TraceSpan span(PHASE_REDUCE);
+        omp_set_lock(rowLock + row);
+        eliminateRow(row);
+        publish(sub + wrdLen * row, subManager + row);
+        finished.store(row + 1, memory_order_release);
+        omp_unset_lock(rowLock + row);
+        if (myid != (numprocs - 1))
+        {
+            TraceSpan span(PHASE_SEND, wrdLen * sizeof(int));
+            MPI_Send(sub + wrdLen * row, wrdLen, MPI_INT, myid + 1, 0, MPI_COMM_WORLD);
+        }
+    }
+
+    freeBitManager(&tmpManager);
+    delete[] tmp;
+    tmp = nullptr;
+}
+
+/**
+ * @brief worker thread, eliminates unfinished rows whenever new eliminators are published
+ *
+ * @param worker serial number of worker
+ * @param workers number of workers
+ */
+void work(int worker, int workers)
+{
+    int seen = -1;                    // epoch of last sweep
+    int start = worker * np / workers; // workers start sweeping from different rows
+    while (finished.load(memory_order_acquire) < np)
+    {
+        int current = epoch.load(memory_order_acquire);
+        if (current == seen)
+        {
+            sched_yield();
+            continue;
+        }
+        seen = current;
+        TraceSpan span(PHASE_REDUCE);
+        for (int k = 0; k < np; k++)
+        {
+            int row = (start + k) % np;
+            if (row < finished.load(memory_order_acquire) || !omp_test_lock(rowLock + row))
+                continue;
+            if (row >= finished.load(memory_order_acquire))
+                eliminateRow(row);
+            omp_unset_lock(rowLock + row);
+        }
+    }
+}
+
+void gaussian()
+{
+    subManager = new BitManager[np];
+    eliminatorManager = new BitManager[wndSize];
+    buildBitManager(eliminator, wrdLen, eliminatorManager, wndSize);
+    buildBitManager(sub, wrdLen, subManager, np);
+
+    published = new atomic<int>[wndSize];
+    for (int i = 0; i < wndSize; i++)
+    {
+        published[i].store(eliminatorManager[i].lftCol == -1 ? 0 : 1, memory_order_relaxed);
+    }
+    rowLock = new omp_lock_t[np];
+    for (int row = 0; row < np; row++)
+    {
+        omp_init_lock(rowLock + row);
+    }
+    epoch.store(0);
+    finished.store(0);
+
+    // threads are decided by OMP_NUM_THREADS or hardware, thread 0 is the master thread and communicates
+#pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        if (tid == 0)
+        {
+            communicate();
+        }
+        else
+        {
+            work(tid - 1, omp_get_num_threads() - 1);
+        }
+    }
+
+    for (int row = 0; row < np; row++)
+    {
+        omp_destroy_lock(rowLock + row);
+    }
+    delete[] rowLock;
+    delete[] published;
+    rowLock = nullptr;
+    published = nullptr;
+}
+
+void write()
+{
+    TraceSpan span(PHASE_WRITE);
+    // each processor formats and writes its own rows, padding rows after wndSize1 are left out
+    int rows = max(0, min(np, wndSize1 - myid * np));
+    string *result = new string[rows];
+    toString(sub, wrdLen, result, rows);
+    writeResultAll(examplePath, result, rows);
+    delete[] result;
+    result = nullptr;
+}
\ No newline at end of file
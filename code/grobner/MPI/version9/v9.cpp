@@ -0,0 +1,264 @@
+/**
+ * @file v9.cpp
+ * @author GKC_NKCS (2012522@mail.nankai.edu.cn)
+ * @brief
+ * @version 0.1
+ * @date 2022-07-23
+ *
+ * @copyright Copyright (c) 2022
+ * @details mainbody of MPI gauss elimination over a prime field GF(p), pipeline non-blocking communication
+ *          the same pipeline as v4 on dense rows of GF(p) elements (../../../common/gf.h) instead of bitmaps.
+ *          rows are split contiguously by partition.h, so any number of processors works. every processor first
+ *          reduces its own rows with the eliminators of the file, then takes the finished rows of lower ranks in
+ *          order, forwards them and applies each to its rows whose leading column it is, and at last finishes its
+ *          own rows in order and sends on the nonzero ones, followed by a DONE_TAG message.
+ *          usage: mpirun -np 4 ./v9 [p], p a prime below 2^31, 2^31 - 1 by default
+ *
+ */
+#include <stdio.h>
+#include "mpi.h"
+#include <string>
+#include <vector>
+#include "file.h"
+#include "../../../common/trace.h"
+#include "../../../common/partition.h"
+#include "../../../common/gf.h"
+
+#define ROW_TAG 0  // a finished nonzero row, its elements up to its leading column
+#define DONE_TAG 1 // no more rows from the sender
+
+int myid;                        // rank of current processor
+int numprocs;                    // number of processor
+double s_time;                   // start time
+double e_time;                   // end time
+int wndSize;                     // max cols
+int wndSize1;                    // rows of eliminatant wnd
+int wndSize2;                    // rows of eliminator wnd
+int np;                          // rows of sub
+GFField field;                   // prime field
+vector<uint32_t> eliminatorData; // eliminators, each up to its leading column
+vector<const uint32_t *> table;  // eliminator of each column, nullptr if none
+vector<vector<uint32_t>> sub;    // rows assigned to current processor, each up to its leading column
+vector<int> lead;                // leading column of each row of sub, -1 for zero rows
+vector<vector<uint32_t>> got;    // rows received from lower ranks
+vector<uint64_t> acc;            // accumulators of gfReduceRow
+
+// string basePath = "F:/大二下课程/并行计算/期末研究报告相关材料/data/Groebner/";
+string basePath = "/home/bill/Desktop/para/src/Groebner/";
+string examplePath = basePath + getExampleName(7);
+
+void init();
+void broadcast();
+void gaussian();
+void write();
+
+int main(int argc, char *argv[])
+{
+    getParam(examplePath, wndSize1, wndSize2, wndSize); // get size of wnd
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    field = gfField(argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : GF_DEFAULT_P);
+    traceInit();
+    if (myid == 0)
+        s_time = MPI_Wtime(); // start timing
+
+    /* init eliminators on every processor */
+    init();
+
+    /* distribute eliminatant rows */
+    broadcast();
+
+    /* conduct elimination */
+    gaussian();
+
+    /*  output result */
+    write();
+
+    if (myid == 0) // end timing
+    {
+        e_time = MPI_Wtime();
+        cout << "time: " << e_time - s_time << endl;
+    }
+
+    traceFinish();
+    MPI_Finalize();
+    return 0;
+}
+
+// parse a sparse line into row, kept up to its leading column, and return the leading column
+int parseRow(const string &line, vector<uint32_t> &dense, vector<uint32_t> &row)
+{
+    gfParseLine(line, dense.data(), wndSize, field);
+    int lc = gfLead(dense.data(), wndSize - 1);
+    row.assign(dense.begin(), dense.begin() + (lc + 1));
+    return lc;
+}
+
+void init()
+{
+    // only rank 0 reads and parses the file, eliminators are made monic and packed one after another
+    vector<int> lftCols(wndSize2, -1); // leading column of each packed eliminator
+    long long total = 0;               // elements of all packed eliminators
+    if (myid == 0)
+    {
+        TraceSpan span(PHASE_PARSE);
+        string *eliminatorSparseWnd = new string[wndSize2];
+        getSparseMatrix(examplePath, eliminatorSparseWnd, wndSize2, ELIMINATOR);
+        vector<uint32_t> dense(wndSize), row;
+        vector<bool> taken(wndSize, false);
+        for (int i = 0; i < wndSize2; i++)
+        {
+            int lc = parseRow(eliminatorSparseWnd[i], dense, row);
+            if (lc == -1 || taken[lc])
+                continue;
+            gfMakeMonic(field, row.data(), lc);
+            eliminatorData.insert(eliminatorData.end(), row.begin(), row.end());
+            lftCols[i] = lc;
+            taken[lc] = true;
+        }
+        total = eliminatorData.size();
+        delete[] eliminatorSparseWnd;
+        eliminatorSparseWnd = nullptr;
+    }
+    {
+        TraceSpan span(PHASE_BCAST, wndSize2 * sizeof(int) + total * sizeof(uint32_t));
+        MPI_Bcast(lftCols.data(), wndSize2, MPI_INT, 0, MPI_COMM_WORLD);
+        MPI_Bcast(&total, 1, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+        eliminatorData.resize(total);
+        MPI_Bcast(eliminatorData.data(), (int)total, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+    }
+    table.assign(wndSize, nullptr);
+    long long offset = 0;
+    for (int i = 0; i < wndSize2; i++)
+    {
+        if (lftCols[i] == -1)
+            continue;
+        table[lftCols[i]] = eliminatorData.data() + offset;
+        offset += lftCols[i] + 1;
+    }
+}
+
+void broadcast()
+{
+    np = partitionRows(wndSize1, numprocs, myid);
+    vector<int> counts(numprocs), displs(numprocs);
+    vector<int> allLead;          // leading column of every eliminatant row, on rank 0
+    vector<uint32_t> packed;      // eliminatant rows one after another, on rank 0
+    vector<int> dataCounts(numprocs, 0), dataDispls(numprocs, 0);
+    if (myid == 0)
+    {
+        TraceSpan span(PHASE_PARSE);
+        string *eliminatantSparseWnd = new string[wndSize1];
+        getSparseMatrix(examplePath, eliminatantSparseWnd, wndSize1, ELIMINATANT);
+        vector<uint32_t> dense(wndSize), row;
+        allLead.resize(wndSize1);
+        for (int i = 0; i < wndSize1; i++)
+        {
+            allLead[i] = parseRow(eliminatantSparseWnd[i], dense, row);
+            packed.insert(packed.end(), row.begin(), row.end());
+            dataCounts[partitionOwner(wndSize1, numprocs, i)] += allLead[i] + 1;
+        }
+        for (int p = 1; p < numprocs; p++)
+            dataDispls[p] = dataDispls[p - 1] + dataCounts[p - 1];
+        delete[] eliminatantSparseWnd;
+        eliminatantSparseWnd = nullptr;
+    }
+
+    TraceSpan span(PHASE_SCATTER);
+    partitionCounts(wndSize1, numprocs, 1, counts.data(), displs.data());
+    lead.resize(np);
+    MPI_Scatterv(allLead.data(), counts.data(), displs.data(), MPI_INT, lead.data(), np, MPI_INT, 0, MPI_COMM_WORLD);
+    int length = 0; // elements of own rows
+    for (int i = 0; i < np; i++)
+        length += lead[i] + 1;
+    vector<uint32_t> own(length);
+    MPI_Scatterv(packed.data(), dataCounts.data(), dataDispls.data(), MPI_UINT32_T, own.data(), length,
+                 MPI_UINT32_T, 0, MPI_COMM_WORLD);
+    sub.resize(np);
+    for (int i = 0, offset = 0; i < np; offset += lead[i] + 1, i++)
+        sub[i].assign(own.begin() + offset, own.begin() + offset + lead[i] + 1);
+}
+
+// reduce row i of sub until its leading column has no eliminator
+void reduce(int i)
+{
+    lead[i] = gfReduceRow(field, sub[i].data(), lead[i], acc.data(), [](int c) { return table[c]; });
+}
+
+void gaussian()
+{
+    TraceSpan span(PHASE_REDUCE);
+    MPI_Status status;
+    MPI_Request request;
+    acc.resize(wndSize);
+    vector<uint32_t> tmp(wndSize); // row received from last level of pipeline
+
+    // with the eliminators of the file every processor works at once
+    for (int row = 0; row < np; row++)
+        reduce(row);
+
+    while (myid != 0)
+    {
+        // Get data from last level of pipeline
+        int count;
+        {
+            TraceSpan span(PHASE_RECV, wndSize * sizeof(uint32_t));
+            MPI_Recv(tmp.data(), wndSize, MPI_UINT32_T, myid - 1, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_UINT32_T, &count);
+        }
+        if (status.MPI_TAG == DONE_TAG)
+            break;
+
+        // send data to next level of pipeline
+        if (myid != (numprocs - 1))
+        {
+            TraceSpan span(PHASE_SEND, count * sizeof(uint32_t));
+            MPI_Isend(tmp.data(), count, MPI_UINT32_T, myid + 1, ROW_TAG, MPI_COMM_WORLD, &request);
+        }
+        // a finished row is monic and its leading column has no eliminator yet, in rank order as sequential
+        int lc = count - 1;
+        got.emplace_back(tmp.begin(), tmp.begin() + count);
+        table[lc] = got.back().data();
+        // only rows led by this column can go on
+        for (int row = 0; row < np; row++)
+        {
+            if (lead[row] == lc)
+                reduce(row);
+        }
+        if (myid != (numprocs - 1))
+        {
+            TraceSpan span(PHASE_SEND);
+            MPI_Wait(&request, MPI_STATUS_IGNORE);
+        }
+    }
+
+    // finish own rows in order, each nonzero one becomes an eliminator and goes on to next processor
+    for (int row = 0; row < np; row++)
+    {
+        reduce(row);
+        if (lead[row] == -1)
+            continue;
+        gfMakeMonic(field, sub[row].data(), lead[row]);
+        table[lead[row]] = sub[row].data();
+        if (myid != (numprocs - 1))
+        {
+            TraceSpan span(PHASE_SEND, (lead[row] + 1) * sizeof(uint32_t));
+            MPI_Send(sub[row].data(), lead[row] + 1, MPI_UINT32_T, myid + 1, ROW_TAG, MPI_COMM_WORLD);
+        }
+    }
+    if (myid != (numprocs - 1))
+        MPI_Send(tmp.data(), 0, MPI_UINT32_T, myid + 1, DONE_TAG, MPI_COMM_WORLD);
+}
+
+void write()
+{
+    TraceSpan span(PHASE_WRITE);
+    // each processor formats and writes its own rows, rows of lower ranks come first
+    string *result = new string[np];
+    for (int i = 0; i < np; i++)
+        result[i] = gfFormatLine(sub[i].data(), lead[i]);
+    writeResultAll(examplePath, result, np);
+    delete[] result;
+    result = nullptr;
+}
@@ -1,8 +1,9 @@
 #include <iostream>
-#include <arm_neon.h>
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include "../common/simd.h"
+#include "../common/matrixGen.h"
 using namespace std;
 
 const int maxN = 640; // 系数矩阵最大规模
@@ -40,149 +41,50 @@ void gaussEliminationOrdinary(int n, float a[][maxN])
     }
 }
 
-// SIMD化的高斯消去
+// SIMD化的高斯消去，除法和消去交给../common/simd.h，运行时选择指令集
 void gaussEliminationOptimisedUnmatched(int n, float a[][maxN])
 {
-    float32x4_t vt;   // 保存a[k][k]
-    float32x4_t va;   // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaik; // 保存a[i][k]
-    float32x4_t vakj; // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaij; // 保存a[i][j]~a[i][j+3]
-    float32x4_t vx;   // 保存(a[k][j]~a[k][j+3])*a[i][k]的值
-
-    int k;
-    int i;
-    int j;
-    int offset;
-    for (k = 0; k < n; k++)
+    for (int k = 0; k < n; k++)
     {
-        vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
-        for (j = k + 1; j + 4 <= n; j += 4)
-        {
-            va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-            va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-            vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
-        }
-        offset = (n - k - 1) % 4;
-        for (j = n - offset; j < n; j++)
-        {
-            a[k][j] /= a[k][k]; // 未处理的元素
-        }
+        simdDivide(a[k], k + 1, n, a[k][k]); // a[k][j] /= a[k][k]
         a[k][k] = 1.0;
-        for (i = k + 1; i < n; i++)
+        for (int i = k + 1; i < n; i++)
         {
-            vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            for (j = k + 1; j + 4 <= n; j += 4)
-            {
-                vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
-            }
-            for (j = n - offset; j < n; j++)
-            {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
-            }
+            simdEliminate(a[i], a[k], k + 1, n, a[i][k]); // a[i][j] -= a[i][k] * a[k][j]
             a[i][k] = 0;
         }
     }
 }
 
-// 对齐的SIMD化的高斯消去
+// 对齐的SIMD化的高斯消去：行首不足一个向量宽度的部分单独处理，使向量部分从对齐位置开始
 void gaussEliminationOptimisedMatched(int n, float a[][maxN])
 {
-    float32x4_t vt;   // 保存a[k][k]
-    float32x4_t va;   // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaik; // 保存a[i][k]
-    float32x4_t vakj; // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaij; // 保存a[i][j]~a[i][j+3]
-    float32x4_t vx;   // 保存(a[k][j]~a[k][j+3])*a[i][k]的值
-
+    int width = simdWidth(); // 向量宽度，maxN是它的倍数，每行起始位置都对齐
     int k;
     int i;
     int j;
     int start;
-    int leftover = n % 4;
-    int end = n - leftover;
-    int handle;
     for (k = 0; k < n; k++)
     {
-        vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
         start = k + 1;
-        handle = start % 4;
+        int aligned = (start + width - 1) / width * width; // 第一个对齐位置
+        if (aligned > n)
+            aligned = n;
         // 掐头
-        switch (handle)
-        {
-        case 0:
-            break; // 开始位置已经对齐
-        case 1:
-            a[k][start] /= a[k][k];
-            a[k][start + 1] /= a[k][k];
-            a[k][start + 2] /= a[k][k];
-            start += 3;
-            break;
-        case 2:
-            a[k][start] /= a[k][k];
-            a[k][start + 1] /= a[k][k];
-            start += 2;
-            break;
-        case 3:
-            a[k][start] /= a[k][k];
-            start += 1;
-            break;
-        }
-        for (j = start; j + 4 <= end; j += 4)
-        {
-            va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-            va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-            vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
-        }
-        // 去尾巴
-        for (j = end; j < n; j++)
+        for (j = start; j < aligned; j++)
         {
-            a[k][j] /= a[k][k]; // 尾巴部分
+            a[k][j] /= a[k][k];
         }
+        simdDivide(a[k], aligned, n, a[k][k]); // 对齐部分，尾巴在内核中处理
         a[k][k] = 1.0;
         for (i = k + 1; i < n; i++)
         {
-            vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            start = k + 1;
-            handle = start % 4;
             // 掐头
-            switch (handle)
-            {
-            case 0:
-                break; // 开始位置已经对齐
-            case 1:
-                a[i][start] -= a[i][k] * a[k][start];
-                a[i][start + 1] -= a[i][k] * a[k][start + 1];
-                a[i][start + 2] -= a[i][k] * a[k][start + 2];
-                start += 3;
-                break;
-            case 2:
-                a[i][start] -= a[i][k] * a[k][start];
-                a[i][start + 1] -= a[i][k] * a[k][start + 1];
-                start += 2;
-                break;
-            case 3:
-                a[i][start] -= a[i][k] * a[k][start];
-                start += 1;
-                break;
-            }
-            for (j = start; j + 4 <= end; j += 4)
+            for (j = start; j < aligned; j++)
             {
-                vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
-            }
-            //  去尾
-            for (j = end; j < n; j++)
-            {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
+                a[i][j] -= a[i][k] * a[k][j];
             }
+            simdEliminate(a[i], a[k], aligned, n, a[i][k]);
             a[i][k] = 0;
         }
     }
@@ -203,30 +105,7 @@ void printMatrix(int n, float a[][maxN])
 
 void m_reset(int n, float a[][maxN])
 {
-    srand((unsigned)time(0));
-    for (int i = 0; i < n; i++)
-    {
-        for (int j = 0; j < i; j++)
-        {
-            a[i][j] = 0;
-        }
-        a[i][i] = 1.0;
-        for (int j = i + 1; j < n; j++)
-        {
-            int t = pow(-1, rand() % 2 + 1);
-            a[i][j] = t * rand() / float(RAND_MAX);
-        }
-    }
-    for (int k = 0; k < n; k++)
-    {
-        for (int i = k + 1; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                a[i][j] += a[k][j];
-            }
-        }
-    }
+    matrixGenRows(matrixSeed(), n, 0, n, a[0], maxN); // 按种子逐行生成，见../common/matrixGen.h
 }
 
 int main()
@@ -0,0 +1,211 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <omp.h>
+#include "../common/gf.h"
+#include "../common/threadPool.h"
+#include "../common/rowScheduler.h"
+using namespace std;
+
+// 素数域GF(p)上的稠密消去，p < 2^31
+// 输入与GF(2)版本相同：param.txt依次为列数、消元子行数、被消元行行数，消元子.txt和被消元行.txt每行是降序的列号，
+// 可以写成"列号:系数"，只写列号时系数为1，所以GF(2)的样例可以直接读入，p = 2时结果与GF(2)版本相同
+// 用法：grobner_gf [样例目录] [p] [serial|pthread|openmp]，结果写入样例目录下的resultGF.txt
+
+#define NUM_THREADS 4 // pthread和OpenMP的线程数
+#define OMP_CHUNK 8   // OpenMP动态调度的块大小
+
+string basePath = "/home/bill/Desktop/para/src/Groebner/";
+string exampleDirectory = "测试样例7 矩阵列数8399，非零消元子6375，被消元行4535";
+
+GFField field;                   // 素数域
+int columns;                     // 矩阵列数
+int eliminatorRows;              // 消元子行数
+int eliminatantRows;             // 被消元行行数
+vector<vector<uint32_t>> rows;   // 被消元行，每行只存到首项所在列
+vector<int> lead;                // 被消元行的首项列号，-1为空行
+vector<vector<uint32_t>> origin; // 读入的消元子
+vector<const uint32_t *> table;  // 以首项为下标的消元子，首项系数为1，没有时为nullptr
+
+// 读入一行稀疏向量，只保留到首项所在列
+int readRow(const string &line, vector<uint32_t> &dense, vector<uint32_t> &row)
+{
+    gfParseLine(line, dense.data(), columns, field);
+    int l = gfLead(dense.data(), columns - 1);
+    row.assign(dense.begin(), dense.begin() + (l + 1));
+    return l;
+}
+
+void init(const string &directory)
+{
+    fstream param(directory + "/param.txt", ios::in);
+    param >> columns >> eliminatorRows >> eliminatantRows;
+    param.close();
+
+    vector<uint32_t> dense(columns);
+    string line;
+    table.assign(columns, nullptr);
+    origin.resize(eliminatorRows);
+    fstream eliminator(directory + "/消元子.txt", ios::in);
+    for (int i = 0; i < eliminatorRows && getline(eliminator, line); i++)
+    {
+        int l = readRow(line, dense, origin[i]);
+        if (l == -1 || table[l] != nullptr)
+            continue;
+        gfMakeMonic(field, origin[i].data(), l); // 消元子的首项系数化为1
+        table[l] = origin[i].data();
+    }
+    eliminator.close();
+
+    rows.resize(eliminatantRows);
+    lead.assign(eliminatantRows, -1);
+    fstream eliminatant(directory + "/被消元行.txt", ios::in);
+    for (int i = 0; i < eliminatantRows && getline(eliminatant, line); i++)
+        lead[i] = readRow(line, dense, rows[i]);
+    eliminatant.close();
+}
+
+// 用当前的消元子把第i行消到首项没有消元子为止，acc为至少columns个64位累加器
+void reduce(int i, uint64_t *acc)
+{
+    lead[i] = gfReduceRow(field, rows[i].data(), lead[i], acc, [](int c) { return table[c]; });
+}
+
+// 串行：被消元行依次消去，首项没有消元子的行升格为消元子
+void serial()
+{
+    vector<uint64_t> acc(columns);
+    for (int i = 0; i < eliminatantRows; i++)
+    {
+        reduce(i, acc.data());
+        if (lead[i] != -1)
+        {
+            gfMakeMonic(field, rows[i].data(), lead[i]);
+            table[lead[i]] = rows[i].data();
+        }
+    }
+}
+
+// 并行版本按轮进行：每轮先并行地用当前消元子消去所有未完成的行，这时消元子只读不写；
+// 再串行地按行号顺序升格。一行消到首项没有消元子时，只有首项在本轮刚被升格占用才需要继续消去，
+// 此后的行还可能被这样的行升格出的消元子消去，所以除了空行都留到下一轮，结果与串行顺序完全相同
+// 每轮至少完成第一个未完成的行，返回本轮之后仍未完成的行
+vector<int> upgrade(const vector<int> &pending)
+{
+    vector<int> left;
+    for (int i : pending)
+    {
+        if (lead[i] == -1)
+            continue;
+        if (left.empty() && table[lead[i]] == nullptr) // 首项不是本轮刚升格的，之前也没有行留下
+        {
+            gfMakeMonic(field, rows[i].data(), lead[i]);
+            table[lead[i]] = rows[i].data();
+            continue;
+        }
+        left.push_back(i);
+    }
+    return left;
+}
+
+//===pthread===
+typedef struct
+{
+    int threadID;
+    int round;
+    const vector<int> *pending;
+    RowScheduler *scheduler;
+    vector<uint64_t> *acc;
+} threadParam_t;
+
+void *reduceFunc(void *param)
+{
+    threadParam_t *p = (threadParam_t *)param;
+    int begin, end;
+    while (p->scheduler->claim(p->round, 0, (int)p->pending->size(), begin, end))
+    {
+        for (int r = begin; r < end; r++)
+            reduce((*p->pending)[r], p->acc->data());
+    }
+    return NULL;
+}
+
+void pthreadVersion()
+{
+    ThreadPool pool(NUM_THREADS);
+    RowScheduler scheduler;
+    scheduler.start(eliminatantRows + 1, pool.size(), 1); // 每轮至少完成一行，轮数不超过行数
+    vector<vector<uint64_t>> acc(pool.size(), vector<uint64_t>(columns));
+    vector<threadParam_t> params(pool.size());
+    vector<int> pending(eliminatantRows);
+    for (int i = 0; i < eliminatantRows; i++)
+        pending[i] = i;
+    for (int round = 0; !pending.empty(); round++)
+    {
+        for (int t = 0; t < pool.size(); t++)
+            params[t] = {t, round, &pending, &scheduler, &acc[t]};
+        pool.run(reduceFunc, params.data());
+        pending = upgrade(pending);
+    }
+}
+
+//===OpenMP===
+void openmpVersion()
+{
+    vector<int> pending(eliminatantRows);
+    for (int i = 0; i < eliminatantRows; i++)
+        pending[i] = i;
+#pragma omp parallel num_threads(NUM_THREADS)
+    {
+        vector<uint64_t> acc(columns); // 每个线程自己的累加器
+        while (!pending.empty())
+        {
+#pragma omp for schedule(dynamic, OMP_CHUNK)
+            for (int r = 0; r < (int)pending.size(); r++)
+                reduce(pending[r], acc.data());
+#pragma omp single
+            pending = upgrade(pending);
+        }
+    }
+}
+
+void writeResult(const string &directory)
+{
+    fstream result(directory + "/resultGF.txt", ios::out | ios::trunc);
+    for (int i = 0; i < eliminatantRows; i++)
+        result << gfFormatLine(rows[i].data(), lead[i]) << endl;
+    result.close();
+}
+
+int main(int argc, char *argv[])
+{
+    string directory = argc > 1 ? argv[1] : basePath + exampleDirectory;
+    uint32_t p = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : GF_DEFAULT_P;
+    string mode = argc > 3 ? argv[3] : "serial";
+    if (p < 2 || p >= (1u << 31))
+    {
+        cout << "p must be a prime below 2^31" << endl;
+        return 1;
+    }
+    field = gfField(p);
+
+    using namespace std::chrono;
+    init(directory);
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    if (mode == "pthread")
+        pthreadVersion();
+    else if (mode == "openmp")
+        openmpVersion();
+    else
+        serial();
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+    duration<double> time_span = duration_cast<duration<double>>(end - start);
+    cout << mode << " GF(" << p << ") " << gfKernels().name << " time: " << time_span.count() << endl;
+
+    writeResult(directory);
+    return 0;
+}
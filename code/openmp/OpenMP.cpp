@@ -2,8 +2,9 @@
 // aarch64-linux-gnu-g++ -pthread -fopenmp -static -o test test.cpp
 // 鲲鹏服务器下编译选项：
 // g++ -g -march=native -pthread -fopenmp -o test test.cpp
+// x86服务器下编译选项（指令集在运行时选择，不需要-march，可用环境变量SIMD_ISA指定）：
+// g++ -O2 -pthread -fopenmp -o test OpenMP.cpp
 #include <iostream>
-#include <arm_neon.h>
 #include <stdlib.h>
 #include <chrono>
 #include <ratio>
@@ -11,15 +12,40 @@
 #include <pthread.h>
 #include <omp.h>
 #include <unistd.h>
+#include <vector>
+#include <algorithm>
+#include "../common/simd.h"
+#include "../common/threadPool.h"
+#include "../common/matrix.h"
+#include "../common/matrixGen.h"
+#include "../common/rowScheduler.h"
+#include "../common/matrixFile.h"
+#include "../common/lu.h"
+#include "../common/batch.h"
+#include "../common/tuning.h"
 using namespace std;
 
 //===线程数定义======================================================================================================================
-#define NUM_THREADS 4
+#define NUM_THREADS 4 //缺省线程数
+#define OMP_CHUNK 1   //缺省的OMP调度块大小，也是pthread动态认领的最小行数
+int numThreads = NUM_THREADS;                   //pthread和OpenMP消去的线程数，自动调优时改变
+int ompChunk = OMP_CHUNK;                       //循环调度和动态调度的块大小，自动调优时改变
+ThreadPool *pool = new ThreadPool(NUM_THREADS); //线程池，线程数不变时所有pthread消去共用
+
+//改变线程数，线程池按新的线程数重建
+void setThreads(int threads)
+{
+    numThreads = threads;
+    if (pool->size() != threads)
+    {
+        delete pool;
+        pool = new ThreadPool(threads);
+    }
+}
 
 //===系数矩阵相关======================================================================================================================
-#define MAX_N 2048
-float A[MAX_N][MAX_N] = {0.0};     //在堆区申请矩阵
-float A_BAC[MAX_N][MAX_N] = {0.0}; //矩阵的备份
+//矩阵是../common/matrix.h的Matrix<float>，规模n在运行时由命令行给出，按n在堆区申请，行首按缓存行对齐
+#define DEFAULT_N 1024 //命令行没有给出规模时的n
 
 //===函数执行方式======================================================================================================================
 #define SERIAL_FUNC 0              //串行
@@ -27,24 +53,49 @@ float A_BAC[MAX_N][MAX_N] = {0.0}; //矩阵的备份
 #define STATIC_FUNC 2              // pthread减法部分静态行划分
 #define STATIC_FUNC_COLUMN_MODE1 3 // pthread减法部分静态列划分(chunksize = 1)
 #define STATIC_FUNC_COLUMN_MODE2 4 // pthread减法部分静态列划分(chunksize = n/num_threads)
-#define SIMD_FUNC 5                // NEON
+#define SIMD_FUNC 5                // SIMD(运行时选择SSE2/AVX2/AVX-512/NEON)
 #define STATIC_FUNC_SIMD 6         // pthread减法部分静态行划分(SIMD)
 #define OMP_DEFAULT_FUNC 7         // OMP默认
 #define OMP_LOOP_FUNC 8            // OMP循环调度方式
 #define OMP_DYNAMIC_FUNC 9         // OMP动态调度方式
-#define OMP_LOOP_NEON_FUNC 10           // OMP循环调度方式+NEON
-#define OMP_DYNAMIC_NEON_FUNC 11        // OMP动态调度方式+NEON
+#define OMP_LOOP_NEON_FUNC 10           // OMP循环调度方式+SIMD
+#define OMP_DYNAMIC_NEON_FUNC 11        // OMP动态调度方式+SIMD
+#define BLOCK_FUNC 12              // 分块
+#define OMP_BLOCK_FUNC 13          // 分块+OMP
+#define PIVOT_FUNC 14              // 部分选主元
+#define SIMD_PIVOT_FUNC 15         // 部分选主元+SIMD
+#define STATIC_PIVOT_FUNC 16       // 部分选主元+pthread静态行划分
+#define OMP_PIVOT_FUNC 17          // 部分选主元+OMP
+#define DATAFLOW_FUNC 18           // pthread数据流，没有全局同步(SIMD)
+#define OMP_DATAFLOW_FUNC 19       // OMP数据流，没有隐式同步(SIMD)
+#define OMP_TASK_FUNC 20           // OMP任务图分块，任务间按块依赖
+#define FUNC_NUM 21                // 执行方式的个数
+
+//===分块参数======================================================================================================================
+#define BLOCK_SIZE 64 // 面板宽度b，尾部矩阵每b步才被读写一次
+#define TILE_COLS 256 // 尾部更新的列块宽度，b*TILE_COLS的U子块留在L2中
+#define TILE_ROWS 16  // OMP分块时每个任务的行数
+#define TASK_TILE 64  // OMP任务图中方块的边长
+
+//===多右端求解参数======================================================================================================================
+#define RHS_BATCH 1024 //一次分解后一批求解的右端向量个数
+
+//===批量小矩阵参数======================================================================================================================
+#define BATCH_N 16         //每个小矩阵的规模
+#define BATCH_COUNT 16384  //小矩阵的个数
 
 //===线程函数======================================================================================================================
 void *dynamicThreadFunc(void *parm);               //动态线程函数声明
 void *staticThreadFunc(void *parm);                //静态线程函数声明，消去按行划分
 void *staticThreadFunc_onColumn_mode1(void *parm); //静态线程函数声明：按列划分的第一种方式：跳跃式
 void *staticThreadFunc_onColumn_mode2(void *parm); //静态线程函数声明：按列划分的第二种方式：连续式
-void *staticThreadFunc_SIMD(void *parm);           //静态线程函数声明：NEON版本
+void *staticThreadFunc_SIMD(void *parm);           //静态线程函数声明：SIMD版本
+void *staticThreadFunc_Pivot(void *parm);          //静态线程函数声明：部分选主元版本
+void *dataflowThreadFunc(void *parm);              //数据流线程函数声明：按行就绪计数推进，不做全局同步
 
 //===矩阵相关函数======================================================================================================================
 //矩阵深拷贝
-void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
+void matrixDeepCopy(int n, Matrix<float> &b, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -56,27 +107,14 @@ void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
 }
 
 //矩阵初始化
-void m_reset(int n, float a[][MAX_N])
+void m_reset(int n, Matrix<float> &a)
 {
-    srand((unsigned)time(0));
-    for (int i = 0; i < n; i++)
-    {
-        int t = pow(-1, rand() % 2 + 1);
-        a[i][i] = t * rand() / float(RAND_MAX); //元素取值范围为[-1,1]之间的随机数
-    }
-    for (int i = 0; i < n * n; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j]; //随机线性组合
-        }
-    }
+    //../common/matrixGen.h按种子逐行生成，各行互不依赖，在OpenMP线程间并行；同一种子的矩阵与线程数无关，逐位相同
+    matrixGenRows(matrixSeed(), n, 0, n, a[0], a.stride());
 }
 
 //矩阵显示
-void printMatrix(int n, float a[][MAX_N])
+void printMatrix(int n, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -90,8 +128,11 @@ void printMatrix(int n, float a[][MAX_N])
 }
 
 //===串行高斯消去算法======================================================================================================================
-void gaussEliminationSerial(int n, float a[][MAX_N])
+//对元素类型T通用；N > 0时是规模为N的特化版本，n为编译期常量，循环次数都是常量
+template <typename T, int N>
+void gaussEliminationSerial(MatrixSize<N>, int n, Matrix<T> &a)
 {
+    n = matrixSize<N>(n);
     for (int k = 0; k < n; k++)
     {
         for (int j = k + 1; j < n; j++)
@@ -111,6 +152,13 @@ void gaussEliminationSerial(int n, float a[][MAX_N])
     }
 }
 
+//常用规模调用特化版本，其余规模调用通用版本
+template <typename T>
+void gaussEliminationSerial(int n, Matrix<T> &a)
+{
+    matrixDispatch(n, [&](auto size) { gaussEliminationSerial(size, n, a); });
+}
+
 //===线程参数定义======================================================================================================================
 typedef struct
 {
@@ -120,19 +168,16 @@ typedef struct
 } threadParam_t;
 
 //===按行划分的动态线程消去======================================================================================================================
-pthread_mutex_t mutex_dynamic;
-pthread_barrier_t barrier_division_dynamic;
-pthread_barrier_t barrier_elimination_dynamic;
-int dynamic_row = 1;
+RowScheduler dynamicRows; //每步一个原子计数器，线程用fetch_add认领一块行，不加锁
 
 //动态线程函数
 void *dynamicThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
-    int i = 1;                                             //每个线程的任务行,首先初始化为1
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
+    int begin, end;                                         //认领到的任务行[begin, end)
 
     for (int k = 0; k < n; k++)
     {
@@ -144,78 +189,51 @@ void *dynamicThreadFunc(void *param)
             }
             a[k][k] = 1.0;
         }
-        pthread_barrier_wait(&barrier_division_dynamic); //做完除法，所有线程同步
+        pool->barrier(threadID); //做完除法，所有线程同步
 
-        while (true) //所有线程从row中取值，并递增，需要用互斥量保护
+        while (dynamicRows.claim(k, k + 1, n, begin, end)) //第k步的计数器只属于第k步，不需要重置
         {
-            pthread_mutex_lock(&mutex_dynamic);
-            i = dynamic_row;
-            dynamic_row++;
-            if (i >= n)
+            for (int i = begin; i < end; i++)
             {
-                dynamic_row = k + 2;
-                i = k + 2;
-                pthread_mutex_unlock(&mutex_dynamic);
-                sched_yield();
-                break;
+                for (int j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
             }
-            sched_yield();
-            pthread_mutex_unlock(&mutex_dynamic);
-            for (int j = k + 1; j < n; j++)
-            {
-                a[i][j] -= a[i][k] * a[k][j];
-            }
-            a[i][k] = 0;
-            i++;
         }
-        pthread_barrier_wait(&barrier_elimination_dynamic); //所有线程从row中取值，并递增，需要用互斥量保护
+        pool->barrier(threadID); //做完消去，所有线程同步
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //动态线程高斯消去
-void gaussEliminationDynamic(int n, float a[][MAX_N])
+void gaussEliminationDynamic(int n, Matrix<float> &a)
 {
-    pthread_barrier_init(&barrier_division_dynamic, NULL, NUM_THREADS);
-    pthread_barrier_init(&barrier_elimination_dynamic, NULL, NUM_THREADS);
-    pthread_mutex_init(&mutex_dynamic, NULL);
+    dynamicRows.start(n, numThreads, ompChunk); //清零n步的计数器
 
-    //创建线程并传递参数
-    pthread_t handle[NUM_THREADS];          //线程句柄
-    threadParam_t threadParam[NUM_THREADS]; //线程参数
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, dynamicThreadFunc, &threadParam[threadID]);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    //等待线程结束
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
-    }
-
-    pthread_barrier_destroy(&barrier_division_dynamic);
-    pthread_barrier_destroy(&barrier_elimination_dynamic);
-    pthread_mutex_destroy(&mutex_dynamic);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(dynamicThreadFunc, threadParam.data());
 }
 
 //===按行划分的静态线程消去======================================================================================================================
-pthread_barrier_t barrier_division_static;
-pthread_barrier_t barrier_elimination_static;
 
 //静态线程函数
 void *staticThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
@@ -228,9 +246,9 @@ void *staticThreadFunc(void *param)
             a[k][k] = 1.0;
         }
 
-        pthread_barrier_wait(&barrier_division_static);
+        pool->barrier(threadID);
 
-        for (int i = k + threadID + 1; i < n; i += NUM_THREADS)
+        for (int i = k + threadID + 1; i < n; i += numThreads)
         {
             for (int j = k + 1; j < n; j++)
             {
@@ -239,130 +257,98 @@ void *staticThreadFunc(void *param)
             a[i][k] = 0;
         }
 
-        pthread_barrier_wait(&barrier_elimination_static);
+        pool->barrier(threadID);
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic(int n, float a[][MAX_N])
+void gaussEliminationStatic(int n, Matrix<float> &a)
 {
-    pthread_barrier_init(&barrier_division_static, NULL, NUM_THREADS);
-    pthread_barrier_init(&barrier_elimination_static, NULL, NUM_THREADS);
-
-    //创建线程并传递参数
-    pthread_t handle[NUM_THREADS];          //线程句柄
-    threadParam_t threadParam[NUM_THREADS]; //线程参数
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc, &threadParam[threadID]);
-    }
-
-    //等待线程结束
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    pthread_barrier_destroy(&barrier_division_static);
-    pthread_barrier_destroy(&barrier_elimination_static);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc, threadParam.data());
 }
 
 //===按列划分（跳跃式）的静态线程消去======================================================================================================================
-pthread_barrier_t barrier_division_static_onColumn_mode1;
-pthread_barrier_t barrier_elimination_static_onColumn_mode1;
 
 //静态线程函数,实现除法和消去均按列跳跃划分
 void *staticThreadFunc_onColumn_mode1(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
         //计算当前线程需要做除法的任务区间
         int division_start = threadID + k + 1;
-        for (int j = division_start; j < n; j += NUM_THREADS)
+        for (int j = division_start; j < n; j += numThreads)
         {
             a[k][j] /= a[k][k];
         }
 
         //所有线程同步
-        pthread_barrier_wait(&barrier_division_static_onColumn_mode1);
+        pool->barrier(threadID);
 
         //跳跃式分配任务
         a[k][k] = 1.0;
         for (int i = k + 1; i < n; i++)
         {
             int elimination_start = threadID + k + 1;
-            for (int j = elimination_start; j < n; j += NUM_THREADS)
+            for (int j = elimination_start; j < n; j += numThreads)
             {
                 a[i][j] -= a[i][k] * a[k][j];
             }
             //做完消去，所有线程同步
-            pthread_barrier_wait(&barrier_elimination_static_onColumn_mode1);
+            pool->barrier(threadID);
             a[i][k] = 0;
         }
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic_onColumn_mode1(int n, float a[][MAX_N])
+void gaussEliminationStatic_onColumn_mode1(int n, Matrix<float> &a)
 {
-    pthread_barrier_init(&barrier_division_static_onColumn_mode1, NULL, NUM_THREADS);
-    pthread_barrier_init(&barrier_elimination_static_onColumn_mode1, NULL, NUM_THREADS);
-
-    //创建线程并传递参数
-    pthread_t handle[NUM_THREADS];          //线程句柄
-    threadParam_t threadParam[NUM_THREADS]; //线程参数
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc_onColumn_mode1, &threadParam[threadID]);
-    }
-
-    //等待线程结束
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    pthread_barrier_destroy(&barrier_division_static_onColumn_mode1);
-    pthread_barrier_destroy(&barrier_elimination_static_onColumn_mode1);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc_onColumn_mode1, threadParam.data());
 }
 
 //===按列划分（连续式）的静态线程消去======================================================================================================================
-pthread_barrier_t barrier_division_static_onColumn_mode2;
-pthread_barrier_t barrier_elimination_static_onColumn_mode2;
 
 //静态线程函数,实现除法和消去均按列连续划分
 void *staticThreadFunc_onColumn_mode2(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
         //计算当前线程需要做除法的任务区间
         int amount_d = n - k - 1;                                                                      //需要做除法的总任务量
-        int extraTask_d = amount_d % NUM_THREADS;                                                      //额外的任务量
-        int h_d = amount_d / NUM_THREADS;                                                              //步长
+        int extraTask_d = amount_d % numThreads;                                                       //额外的任务量
+        int h_d = amount_d / numThreads;                                                               //步长
         int my_start_d = threadID * h_d + k + 1 + ((threadID < extraTask_d) ? threadID : extraTask_d); //当前线程的开始位置
         int my_end_d = my_start_d + h_d + ((threadID < extraTask_d) ? 1 : 0);                          //当前线程的结束位置
         for (int j = my_start_d; j < my_end_d && j < n; j++)
@@ -371,15 +357,15 @@ void *staticThreadFunc_onColumn_mode2(void *param)
         }
 
         //所有线程同步
-        pthread_barrier_wait(&barrier_division_static_onColumn_mode2);
+        pool->barrier(threadID);
 
         //以线程数为步长，划分任务
         a[k][k] = 1.0;
         for (int i = k + 1; i < n; i++)
         {
             int amount_e = n - k - 1;                                                                      //需要做除法的总任务量
-            int extraTask_e = amount_e % NUM_THREADS;                                                      //额外的任务量
-            int h_e = amount_e / NUM_THREADS;                                                              //步长
+            int extraTask_e = amount_e % numThreads;                                                       //额外的任务量
+            int h_e = amount_e / numThreads;                                                               //步长
             int my_start_e = threadID * h_e + k + 1 + ((threadID < extraTask_e) ? threadID : extraTask_e); //当前线程的开始位置
             int my_end_e = my_start_e + h_e + ((threadID < extraTask_e) ? 1 : 0);                          //当前线程的结束位置
             for (int j = my_start_e; j < my_end_e && j < n; j++)
@@ -388,210 +374,382 @@ void *staticThreadFunc_onColumn_mode2(void *param)
             }
 
             //做完消去，所有线程同步
-            pthread_barrier_wait(&barrier_elimination_static_onColumn_mode2);
+            pool->barrier(threadID);
             a[i][k] = 0;
         }
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic_onColumn_mode2(int n, float a[][MAX_N])
+void gaussEliminationStatic_onColumn_mode2(int n, Matrix<float> &a)
 {
-    pthread_barrier_init(&barrier_division_static_onColumn_mode2, NULL, NUM_THREADS);
-    pthread_barrier_init(&barrier_elimination_static_onColumn_mode2, NULL, NUM_THREADS);
-
-    //创建线程
-    pthread_t handle[NUM_THREADS];          //线程句柄
-    threadParam_t threadParam[NUM_THREADS]; //线程参数
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
+        threadParam[threadID].a = (void *)&a;
+    }
+
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc_onColumn_mode2, threadParam.data());
+}
+
+//===SIMD并行化高斯消去算法======================================================================================================================
+//除法和消去都交给../common/simd.h，运行时按CPU选择SSE2/AVX2/AVX-512/NEON
+//消去用多行微内核：每趟做第k、k+1两步，a[k]、a[k+1]的每个向量只加载一次，同时更新多行，
+//各行的两个消去因子留在寄存器中，每行每趟只读写一次，访存量是逐步消去的一半
+void gaussEliminationSIMD(int n, Matrix<float> &a)
+{
+    float *const *rowPtr = a.rows(); //行指针，交给多行微内核
+    for (int k = 0; k + 1 < n; k += 2)
+    {
+        simdDividePair(a[k], a[k + 1], k, n);                             //第k、k+1行做除法，a[k+1]先减去a[k]
+        simdUpdateRows2(rowPtr + k + 2, n - k - 2, a[k], a[k + 1], k, n); //其余行一趟消去第k、k+1列
+    }
+    if (n % 2 == 1)
+    {
+        a[n - 1][n - 1] = 1.0; //剩下最后一行，其后没有要做除法和消去的元素
+    }
+}
+
+//===SIMD、Pthread并行化高斯消去算法======================================================================================================================
+
+// SIMD与Pthread结合的线程函数
+void *staticThreadFunc_SIMD(void *param)
+{
+    threadParam_t *p = (threadParam_t *)param;
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
+    vector<float *> myRows(n / numThreads + 1);             //本线程负责的行，交给多行微内核
+
+    //每趟做第k、k+1两步
+    for (int k = 0; k + 1 < n; k += 2)
+    {
+        if (threadID == 0)
+        {
+            simdDividePair(a[k], a[k + 1], k, n); //第k、k+1行做除法，a[k+1]先减去a[k]
+        }
+
+        //所有线程同步
+        pool->barrier(threadID);
+
+        //以线程数为步长，划分任务
+        int count = 0;
+        for (int i = k + 2 + threadID; i < n; i += numThreads)
+        {
+            myRows[count++] = a[i];
+        }
+        simdUpdateRows2(myRows.data(), count, a[k], a[k + 1], k, n); //一趟消去第k、k+1列
+
+        //做完消去，所有线程同步
+        pool->barrier(threadID);
     }
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    if (threadID == 0 && n % 2 == 1)
     {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc_onColumn_mode2, &threadParam[threadID]);
+        a[n - 1][n - 1] = 1.0; //剩下最后一行，其后没有要做除法和消去的元素
     }
+    return NULL;
+}
 
-    //等待线程结束
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+// SIMD与Pthread结合的高斯消去
+void gaussEliminationSIMD_Pthread(int n, Matrix<float> &a)
+{
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
-        pthread_join(handle[threadID], NULL);
+        threadParam[threadID].threadID = threadID;
+        threadParam[threadID].n = n;
+        threadParam[threadID].a = (void *)&a;
     }
 
-    pthread_barrier_destroy(&barrier_division_static_onColumn_mode2);
-    pthread_barrier_destroy(&barrier_elimination_static_onColumn_mode2);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc_SIMD, threadParam.data());
 }
 
-//===NEON并行化高斯消去算法======================================================================================================================
-void gaussEliminationSIMD(int n, float a[][MAX_N])
+//===SIMD、Pthread并行化高斯消去算法======================================================================================================================
+
+//===数据流高斯消去======================================================================================================================
+//行按两行一组循环分给线程，第i行属于线程(i / 2) % numThreads，每行只由它的线程读写
+//每行带一个原子计数，记录它做完了几步（主元行的除法也算一步），第k、k+1行计数到k+2就是可用的主元行
+//线程等到第k、k+1行就绪就消去自己的行，不等其他线程做完第k步，没有全局同步
+//下一对主元行的线程先消去它们、做除法并发布（前瞻），其他线程在第k步的消去中就能等到它们，串行的除法被隐藏
+RowProgress rowReady; //每行做完的步数
+
+//数据流线程函数
+void *dataflowThreadFunc(void *param)
 {
-    float32x4_t vt;   // 保存a[k][k]
-    float32x4_t va;   // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaik; // 保存a[i][k]
-    float32x4_t vakj; // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaij; // 保存a[i][j]~a[i][j+3]
-    float32x4_t vx;   // 保存(a[k][j]~a[k][j+3])*a[i][k]的值
+    threadParam_t *p = (threadParam_t *)param;
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
+    vector<float *> myRows(n / numThreads + 2);             //本线程负责的行，交给多行微内核
 
-    int k;
-    int i;
-    int j;
-    int offset;
-    for (k = 0; k < n; k++)
+    if (n > 1 && threadID == 0) //第0、1行属于线程0
+    {
+        simdDividePair(a[0], a[1], 0, n);
+        rowReady.publish(0, 2);
+        rowReady.publish(1, 2);
+    }
+
+    //每趟做第k、k+1两步
+    for (int k = 0; k + 1 < n; k += 2)
     {
-        vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
-        for (j = k + 1; j + 4 <= n; j += 4)
+        rowReady.waitFor(k + 1, k + 2); //第k+1行在第k行之后发布，等到它两行就都可用
+
+        //前瞻：下一对主元行属于本线程时，先消去它们并做除法，尽早发布
+        int next = k + 2; //剩下要消去的第一行
+        if (k + 3 < n && (k + 2) / 2 % numThreads == threadID)
         {
-            va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-            va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-            vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
+            float *pivots[2] = {a[k + 2], a[k + 3]};
+            simdUpdateRows2(pivots, 2, a[k], a[k + 1], k, n);
+            simdDividePair(a[k + 2], a[k + 3], k + 2, n);
+            rowReady.publish(k + 2, k + 4);
+            rowReady.publish(k + 3, k + 4);
+            next = k + 4;
         }
-        offset = (n - k - 1) % 4;
-        for (j = n - offset; j < n; j++)
+
+        //本线程其余的行，从next所在的组开始找第一组属于本线程的
+        int count = 0;
+        int group = next / 2;
+        group += (threadID - group % numThreads + numThreads) % numThreads;
+        for (int i = group * 2; i < n; i += numThreads * 2)
         {
-            a[k][j] /= a[k][k]; // 未处理的元素
+            myRows[count++] = a[i];
+            if (i + 1 < n)
+            {
+                myRows[count++] = a[i + 1];
+            }
         }
-        a[k][k] = 1.0;
-        for (i = k + 1; i < n; i++)
+        simdUpdateRows2(myRows.data(), count, a[k], a[k + 1], k, n); //一趟消去第k、k+1列
+    }
+    if (n % 2 == 1 && (n - 1) / 2 % numThreads == threadID)
+    {
+        a[n - 1][n - 1] = 1.0; //剩下最后一行，其后没有要做除法和消去的元素
+    }
+    return NULL;
+}
+
+//数据流高斯消去，只在线程池返回时同步一次
+void gaussEliminationDataflow(int n, Matrix<float> &a)
+{
+    rowReady.start(n, numThreads);
+
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
+    {
+        threadParam[threadID].threadID = threadID;
+        threadParam[threadID].n = n;
+        threadParam[threadID].a = (void *)&a;
+    }
+
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(dataflowThreadFunc, threadParam.data());
+}
+
+// OpenMP数据流高斯消去：同一个线程函数，omp single和omp for的隐式同步都没有了
+void gaussEliminationOpenMPDataflow(int n, Matrix<float> &a)
+{
+    rowReady.start(n, numThreads);
+
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
+    {
+        threadParam[threadID].threadID = threadID;
+        threadParam[threadID].n = n;
+        threadParam[threadID].a = (void *)&a;
+    }
+
+    omp_set_dynamic(0); //每组行都有线程负责，线程数不能被运行时减少
+#pragma omp parallel num_threads(numThreads)
+    dataflowThreadFunc(&threadParam[omp_get_thread_num()]);
+}
+
+//===OpenMP高斯消去算法======================================================================================================================
+//以下三种OpenMP消去同串行版本，对常用规模有循环次数为常量的特化版本
+template <typename T, int N>
+void gaussEliminationOpenMP(MatrixSize<N>, int size, Matrix<T> &a)
+{
+    int i, j, k;
+#pragma omp parallel num_threads(numThreads) default(none) private(i, j, k) shared(a, size)
+    {
+        const int n = matrixSize<N>(size); //在并行区内求出，N > 0时各线程的循环次数也是常量
+        for (k = 0; k < n; k++)
         {
-            vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            for (j = k + 1; j + 4 <= n; j += 4)
+#pragma omp single
+            for (j = k + 1; j < n; j++)
             {
-                vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
+                a[k][j] /= a[k][k];
             }
-            for (j = n - offset; j < n; j++)
+            a[k][k] = 1.0;
+
+#pragma omp for
+            for (i = k + 1; i < n; i++)
             {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
+                for (j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
             }
-            a[i][k] = 0;
         }
     }
 }
 
-//===NEON、Pthread并行化高斯消去算法======================================================================================================================
-pthread_barrier_t barrier_division_static_SIMD;
-pthread_barrier_t barrier_elimination_static_SIMD;
-
-// SIMD与Pthread结合的线程函数
-void *staticThreadFunc_SIMD(void *param)
+template <typename T>
+void gaussEliminationOpenMP(int n, Matrix<T> &a)
 {
-    threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
-    int offset;                                            //处理剩下元素
-
-    float32x4_t vt;   // 保存a[k][k]
-    float32x4_t va;   // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaik; // 保存a[i][k]
-    float32x4_t vakj; // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaij; // 保存a[i][j]~a[i][j+3]
-    float32x4_t vx;   // 保存(a[k][j]~a[k][j+3])*a[i][k]的值
+    matrixDispatch(n, [&](auto size) { gaussEliminationOpenMP(size, n, a); });
+}
 
-    for (int k = 0; k < n; k++)
+//===OpenMP高斯消去，循环划分=====================================================================================================================
+template <typename T, int N>
+void gaussEliminationOpenMPLoop(MatrixSize<N>, int size, Matrix<T> &a)
+{
+    int i, j, k;
+#pragma omp parallel num_threads(numThreads) default(none) private(i, j, k) shared(a, size, ompChunk)
     {
-        if (threadID == 0)
+        const int n = matrixSize<N>(size); //在并行区内求出，N > 0时各线程的循环次数也是常量
+        for (k = 0; k < n; k++)
         {
-            vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
-            for (int j = k + 1; j + 4 <= n; j += 4)
+#pragma omp single
+            for (j = k + 1; j < n; j++)
             {
-                va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-                va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-                vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
+                a[k][j] /= a[k][k];
             }
-            offset = (n - k - 1) % 4;
-            for (int j = n - offset; j < n; j++)
+            a[k][k] = 1.0;
+
+#pragma omp for schedule(static, ompChunk)
+            for (i = k + 1; i < n; i++)
             {
-                a[k][j] /= a[k][k]; // 未处理的元素
+                for (j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
             }
-            a[k][k] = 1.0;
         }
+    }
+}
 
-        //所有线程同步
-        pthread_barrier_wait(&barrier_division_static_SIMD);
+template <typename T>
+void gaussEliminationOpenMPLoop(int n, Matrix<T> &a)
+{
+    matrixDispatch(n, [&](auto size) { gaussEliminationOpenMPLoop(size, n, a); });
+}
 
-        //以线程数为步长，划分任务
-        for (int i = k + 1 + threadID; i < n; i += NUM_THREADS)
+//===OpenMP高斯消去，动态调度=====================================================================================================================
+template <typename T, int N>
+void gaussEliminationOpenMPDynamic(MatrixSize<N>, int size, Matrix<T> &a)
+{
+    int i, j, k;
+#pragma omp parallel num_threads(numThreads) default(none) private(i, j, k) shared(a, size, ompChunk)
+    {
+        const int n = matrixSize<N>(size); //在并行区内求出，N > 0时各线程的循环次数也是常量
+        for (k = 0; k < n; k++)
         {
-            vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            for (int j = k + 1; j + 4 <= n; j += 4)
+#pragma omp single
+            for (j = k + 1; j < n; j++)
             {
-                vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
+                a[k][j] /= a[k][k];
             }
-            offset = (n - k - 1) % 4;
-            for (int j = n - offset; j < n; j++)
+            a[k][k] = 1.0;
+
+#pragma omp for schedule(dynamic, ompChunk)
+            for (i = k + 1; i < n; i++)
             {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
+                for (j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
             }
-            a[i][k] = 0;
         }
-
-        //做完消去，所有线程同步
-        pthread_barrier_wait(&barrier_elimination_static_SIMD);
     }
-    pthread_exit(NULL);
 }
 
-// NEON与Pthread结合的高斯消去
-void gaussEliminationSIMD_Pthread(int n, float a[][MAX_N])
+template <typename T>
+void gaussEliminationOpenMPDynamic(int n, Matrix<T> &a)
+{
+    matrixDispatch(n, [&](auto size) { gaussEliminationOpenMPDynamic(size, n, a); });
+}
+
+//===SIMD+OpenMP循环并行化高斯消去算法======================================================================================================================
+void gaussElimination_OpenMP_NEON_Loop(int n, Matrix<float> &a)
 {
-    pthread_barrier_init(&barrier_division_static_SIMD, NULL, NUM_THREADS);
-    pthread_barrier_init(&barrier_elimination_static_SIMD, NULL, NUM_THREADS);
+    int k;
+    int i;
+    int rows = simdRows();           //每个任务是微内核一次更新的行数
+    float *const *rowPtr = a.rows(); //行指针，交给多行微内核
 
-    //创建线程
-    pthread_t handle[NUM_THREADS];          //线程句柄
-    threadParam_t threadParam[NUM_THREADS]; //线程参数
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    #pragma omp parallel num_threads(numThreads) default(none) private(i, k) shared(a, n, rows, rowPtr, ompChunk)
+    for (k = 0; k + 1 < n; k += 2) //每趟做第k、k+1两步
     {
-        threadParam[threadID].threadID = threadID;
-        threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
+        #pragma omp single
+        {
+            simdDividePair(a[k], a[k + 1], k, n); //第k、k+1行做除法，a[k+1]先减去a[k]
+        }
+        
+        #pragma omp for schedule(static, ompChunk)
+        for (i = k + 2; i < n; i += rows)
+        {
+            simdUpdateRows2(rowPtr + i, n - i < rows ? n - i : rows, a[k], a[k + 1], k, n); //一趟消去第k、k+1列
+        }
     }
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    if (n % 2 == 1)
     {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc_SIMD, &threadParam[threadID]);
+        a[n - 1][n - 1] = 1.0; //剩下最后一行，其后没有要做除法和消去的元素
     }
+}
+
+//===SIMD+OpenMP动态调度高斯消去算法======================================================================================================================
+void gaussElimination_OpenMP_NEON_Dynamic(int n, Matrix<float> &a)
+{
+    int k;
+    int i;
+    int rows = simdRows();           //每个任务是微内核一次更新的行数
+    float *const *rowPtr = a.rows(); //行指针，交给多行微内核
 
-    //等待线程结束
-    for (int threadID = 0; threadID < NUM_THREADS; threadID++)
+    #pragma omp parallel num_threads(numThreads) default(none) private(i, k) shared(a, n, rows, rowPtr, ompChunk)
+    for (k = 0; k + 1 < n; k += 2) //每趟做第k、k+1两步
     {
-        pthread_join(handle[threadID], NULL);
+        #pragma omp single
+        {
+            simdDividePair(a[k], a[k + 1], k, n); //第k、k+1行做除法，a[k+1]先减去a[k]
+        }
+        
+        #pragma omp for schedule(dynamic, ompChunk)
+        for (i = k + 2; i < n; i += rows)
+        {
+            simdUpdateRows2(rowPtr + i, n - i < rows ? n - i : rows, a[k], a[k + 1], k, n); //一趟消去第k、k+1列
+        }
+    }
+    if (n % 2 == 1)
+    {
+        a[n - 1][n - 1] = 1.0; //剩下最后一行，其后没有要做除法和消去的元素
     }
-
-    pthread_barrier_destroy(&barrier_division_static_SIMD);
-    pthread_barrier_destroy(&barrier_elimination_static_SIMD);
 }
 
-//===SIMD、Pthread并行化高斯消去算法======================================================================================================================
-
-//===OpenMP高斯消去算法======================================================================================================================
-void gaussEliminationOpenMP(int n, float a[][MAX_N])
+//===分块高斯消去======================================================================================================================
+//面板分解：面板内的行[k0,kb)按原算法做整行的除法和消去，得到U的第[k0,kb)行
+void blockPanel(int n, Matrix<float> &a, int k0, int kb)
 {
-    int i, j, k;
-#pragma omp parallel num_threads(NUM_THREADS) default(none) private(i, j, k) shared(a, n)
-    for (k = 0; k < n; k++)
+    for (int k = k0; k < kb; k++)
     {
-#pragma omp single
-        for (j = k + 1; j < n; j++)
+        for (int j = k + 1; j < n; j++)
         {
             a[k][j] /= a[k][k];
         }
         a[k][k] = 1.0;
 
-#pragma omp for
-        for (i = k + 1; i < n; i++)
+        for (int i = k + 1; i < kb; i++)
         {
-            for (j = k + 1; j < n; j++)
+            for (int j = k + 1; j < n; j++)
             {
                 a[i][j] -= a[i][k] * a[k][j];
             }
@@ -600,158 +758,578 @@ void gaussEliminationOpenMP(int n, float a[][MAX_N])
     }
 }
 
-//===OpenMP高斯消去，循环划分=====================================================================================================================
-void gaussEliminationOpenMPLoop(int n, float a[][MAX_N])
+//尾部更新：对面板下方的行[rowBegin,rowEnd)，先在面板列内求出乘数L，再做 a[i][kb:n] -= L[i][k0:kb] * U[k0:kb][kb:n]
+void blockUpdate(int n, Matrix<float> &a, int k0, int kb, int rowBegin, int rowEnd)
 {
-    int i, j, k;
-#pragma omp parallel num_threads(NUM_THREADS) default(none) private(i, j, k) shared(a, n)
-    for (k = 0; k < n; k++)
+    //面板列内的消去，a[i][k]保留为乘数
+    for (int i = rowBegin; i < rowEnd; i++)
     {
-#pragma omp single
-        for (j = k + 1; j < n; j++)
+        for (int k = k0; k < kb; k++)
         {
-            a[k][j] /= a[k][k];
+            for (int j = k + 1; j < kb; j++)
+            {
+                a[i][j] -= a[i][k] * a[k][j];
+            }
         }
-        a[k][k] = 1.0;
+    }
 
-#pragma omp for schedule(static,1)
-        for (i = k + 1; i < n; i++)
+    //按列块遍历，列块内的U子块被每一行复用；每次更新4行，载入的U[k][j]在寄存器中复用4次
+    for (int jj = kb; jj < n; jj += TILE_COLS)
+    {
+        int je = min(jj + TILE_COLS, n);
+        int i = rowBegin;
+        for (; i + 4 <= rowEnd; i += 4)
         {
-            for (j = k + 1; j < n; j++)
+            float *r0 = a[i], *r1 = a[i + 1], *r2 = a[i + 2], *r3 = a[i + 3];
+            for (int k = k0; k < kb; k++)
             {
-                a[i][j] -= a[i][k] * a[k][j];
+                float l0 = r0[k], l1 = r1[k], l2 = r2[k], l3 = r3[k];
+                float *u = a[k];
+                for (int j = jj; j < je; j++)
+                {
+                    float ukj = u[j];
+                    r0[j] -= l0 * ukj;
+                    r1[j] -= l1 * ukj;
+                    r2[j] -= l2 * ukj;
+                    r3[j] -= l3 * ukj;
+                }
             }
+        }
+        for (; i < rowEnd; i++) //剩余的行
+        {
+            for (int k = k0; k < kb; k++)
+            {
+                float lik = a[i][k];
+                for (int j = jj; j < je; j++)
+                {
+                    a[i][j] -= lik * a[k][j];
+                }
+            }
+        }
+    }
+
+    for (int i = rowBegin; i < rowEnd; i++)
+    {
+        for (int k = k0; k < kb; k++)
+        {
             a[i][k] = 0;
         }
     }
 }
 
-//===OpenMP高斯消去，动态调度=====================================================================================================================
-void gaussEliminationOpenMPDynamic(int n, float a[][MAX_N])
+//分块高斯消去：每b列做一次面板分解和一次尾部更新，尾部矩阵的访存次数约为原算法的1/b
+void gaussEliminationBlock(int n, Matrix<float> &a)
 {
-    int i, j, k;
-#pragma omp parallel num_threads(NUM_THREADS) default(none) private(i, j, k) shared(a, n)
-    for (k = 0; k < n; k++)
+    for (int k0 = 0; k0 < n; k0 += BLOCK_SIZE)
     {
+        int kb = min(k0 + BLOCK_SIZE, n);
+        blockPanel(n, a, k0, kb);
+        blockUpdate(n, a, k0, kb, kb, n);
+    }
+}
+
+//===OpenMP分块高斯消去======================================================================================================================
+void gaussEliminationOpenMPBlock(int n, Matrix<float> &a)
+{
+    int k0, kb, i;
+#pragma omp parallel num_threads(numThreads) default(none) private(k0, kb, i) shared(a, n)
+    for (k0 = 0; k0 < n; k0 += BLOCK_SIZE)
+    {
+        kb = min(k0 + BLOCK_SIZE, n);
 #pragma omp single
-        for (j = k + 1; j < n; j++)
+        blockPanel(n, a, k0, kb);
+
+#pragma omp for schedule(static)
+        for (i = kb; i < n; i += TILE_ROWS)
         {
-            a[k][j] /= a[k][k];
+            blockUpdate(n, a, k0, kb, i, min(i + TILE_ROWS, n));
         }
-        a[k][k] = 1.0;
+    }
+}
 
-#pragma omp for schedule(dynamic,1)
-        for (i = k + 1; i < n; i++)
+//===OpenMP任务图分块高斯消去======================================================================================================================
+//矩阵切成TASK_TILE见方的块(I,J)，第K步有四种任务：
+//  对角块(K,K)分解，行块(K,J)的除法和块内消去，列块(I,K)求乘数，尾部块(I,J)减去L(I,K)*U(K,J)
+//任务之间只按读写的块depend，不按步同步，第K+1步的对角块在第K步的尾部更新做完之前就能开始
+//每个元素仍按k从小到大被消去，除数也相同，结果与串行算法逐位相同
+
+//对角块分解：块内逐行除法和消去，主元存进pivots，行块的除法还要用到它
+void tileFactor(Matrix<float> &a, float *pivots, int k0, int kb)
+{
+    for (int k = k0; k < kb; k++)
+    {
+        pivots[k] = a[k][k];
+        for (int j = k + 1; j < kb; j++)
         {
-            for (j = k + 1; j < n; j++)
+            a[k][j] /= pivots[k];
+        }
+        for (int i = k + 1; i < kb; i++)
+        {
+            for (int j = k + 1; j < kb; j++)
             {
                 a[i][j] -= a[i][k] * a[k][j];
             }
-            a[i][k] = 0;
         }
     }
 }
 
-//===NEON+OpenMP循环并行化高斯消去算法======================================================================================================================
-void gaussElimination_OpenMP_NEON_Loop(int n, float a[][MAX_N])
+//行块(K,J)：第k行的列[j0,je)做除法，再消去块内k以下的行，乘数取对角块的下三角
+void tileRowSolve(Matrix<float> &a, const float *pivots, int k0, int kb, int j0, int je)
 {
-    int k;
-    int i;
-    int j;
-    int offset;
-    
-    #pragma omp parallel num_threads(NUM_THREADS) default(none) private(i, j, k, offset) shared(a, n)
-    for (k = 0; k < n; k++)
+    for (int k = k0; k < kb; k++)
     {
-        #pragma omp single
+        for (int j = j0; j < je; j++)
+        {
+            a[k][j] /= pivots[k];
+        }
+        for (int i = k + 1; i < kb; i++)
         {
-            float32x4_t vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
-            for (j = k + 1; j + 4 <= n; j += 4)
+            for (int j = j0; j < je; j++)
             {
-                float32x4_t va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-                va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-                vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
+                a[i][j] -= a[i][k] * a[k][j];
             }
-            offset = (n - k - 1) % 4;
-            for (j = n - offset; j < n; j++)
+        }
+    }
+}
+
+//列块(I,K)：行[i0,ie)在对角块的列内消去，a[i][k0:kb]成为乘数L
+void tileColumn(Matrix<float> &a, int k0, int kb, int i0, int ie)
+{
+    for (int i = i0; i < ie; i++)
+    {
+        for (int k = k0; k < kb; k++)
+        {
+            for (int j = k + 1; j < kb; j++)
             {
-                a[k][j] /= a[k][k]; // 未处理的元素
+                a[i][j] -= a[i][k] * a[k][j];
             }
-            a[k][k] = 1.0;
         }
-        
-        #pragma omp for schedule(static,1)
-        for (i = k + 1; i < n; i++)
+    }
+}
+
+//尾部块(I,J)：a[i0:ie][j0:je] -= L[i0:ie][k0:kb] * U[k0:kb][j0:je]，每次更新4行，U[k][j]在寄存器中复用4次
+void tileUpdate(Matrix<float> &a, int k0, int kb, int i0, int ie, int j0, int je)
+{
+    int i = i0;
+    for (; i + 4 <= ie; i += 4)
+    {
+        float *r0 = a[i], *r1 = a[i + 1], *r2 = a[i + 2], *r3 = a[i + 3];
+        for (int k = k0; k < kb; k++)
         {
-            float32x4_t vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            for (j = k + 1; j + 4 <= n; j += 4)
+            float l0 = r0[k], l1 = r1[k], l2 = r2[k], l3 = r3[k];
+            float *u = a[k];
+            for (int j = j0; j < je; j++)
             {
-                float32x4_t vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                float32x4_t vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                float32x4_t vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
+                float ukj = u[j];
+                r0[j] -= l0 * ukj;
+                r1[j] -= l1 * ukj;
+                r2[j] -= l2 * ukj;
+                r3[j] -= l3 * ukj;
             }
-            for (j = n - offset; j < n; j++)
+        }
+    }
+    for (; i < ie; i++) //剩余的行
+    {
+        for (int k = k0; k < kb; k++)
+        {
+            float lik = a[i][k];
+            for (int j = j0; j < je; j++)
             {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
+                a[i][j] -= lik * a[k][j];
             }
+        }
+    }
+}
+
+//乘数用完后清零，对角元置1
+void tileClear(Matrix<float> &a, int k0, int kb, int i0, int ie)
+{
+    for (int i = i0; i < ie; i++)
+    {
+        for (int k = k0; k < kb && k < i; k++)
+        {
             a[i][k] = 0;
         }
+        if (i >= k0 && i < kb)
+        {
+            a[i][i] = 1.0;
+        }
     }
 }
 
-//===NEON+OpenMP循环并行化高斯消去算法======================================================================================================================
-void gaussElimination_OpenMP_NEON_Dynamic(int n, float a[][MAX_N])
+//一个线程按k的顺序创建全部任务，其余线程执行，depend的对象是每块一个的占位字节
+void gaussEliminationOpenMPTask(int n, Matrix<float> &a)
 {
-    int k;
-    int i;
-    int j;
-    int offset;
-    
-    #pragma omp parallel num_threads(NUM_THREADS) default(none) private(i, j, k, offset) shared(a, n)
-    for (k = 0; k < n; k++)
+    int tiles = (n + TASK_TILE - 1) / TASK_TILE; //每行每列的块数
+    vector<float> pivots(n);                     //每行做除法前的主元
+    vector<char> dep(tiles * tiles);             //块(I,J)的依赖占位
+    float *pivot = pivots.data();
+
+#pragma omp parallel num_threads(numThreads)
+#pragma omp single
+    for (int K = 0; K < tiles; K++)
     {
-        #pragma omp single
+        int k0 = K * TASK_TILE, kb = min(k0 + TASK_TILE, n);
+
+#pragma omp task depend(inout : dep.data()[K * tiles + K]) shared(a)
+        tileFactor(a, pivot, k0, kb);
+
+        for (int J = K + 1; J < tiles; J++)
+        {
+            int j0 = J * TASK_TILE, je = min(j0 + TASK_TILE, n);
+#pragma omp task depend(in : dep.data()[K * tiles + K]) depend(inout : dep.data()[K * tiles + J]) shared(a)
+            tileRowSolve(a, pivot, k0, kb, j0, je);
+        }
+
+        for (int I = K + 1; I < tiles; I++)
+        {
+            int i0 = I * TASK_TILE, ie = min(i0 + TASK_TILE, n);
+#pragma omp task depend(in : dep.data()[K * tiles + K]) depend(inout : dep.data()[I * tiles + K]) shared(a)
+            tileColumn(a, k0, kb, i0, ie);
+        }
+
+        for (int I = K + 1; I < tiles; I++)
+        {
+            int i0 = I * TASK_TILE, ie = min(i0 + TASK_TILE, n);
+            for (int J = K + 1; J < tiles; J++)
+            {
+                int j0 = J * TASK_TILE, je = min(j0 + TASK_TILE, n);
+#pragma omp task depend(in : dep.data()[I * tiles + K], dep.data()[K * tiles + J]) \
+    depend(inout : dep.data()[I * tiles + J]) shared(a)
+                tileUpdate(a, k0, kb, i0, ie, j0, je);
+            }
+        }
+
+        //对角块和列块的乘数等读它们的任务做完再清零
+        for (int I = K; I < tiles; I++)
+        {
+            int i0 = I * TASK_TILE, ie = min(i0 + TASK_TILE, n);
+#pragma omp task depend(inout : dep.data()[I * tiles + K]) shared(a)
+            tileClear(a, k0, kb, i0, ie);
+        }
+    }
+}
+
+//===部分选主元======================================================================================================================
+//交换行时只交换行指针，不搬移数据；第k步消去第i行时顺便把|a[i][k+1]|写入连续数组colAbs，第k+1步选主元只需在colAbs上求最大值
+vector<float *> pivotRows; //行指针，pivotRows[i]为当前的第i行
+vector<float> colAbs;      //colAbs[i]为当前第i行主元列元素的绝对值
+vector<int> pivotPerm;     //消去结束后结果的第i行来自原矩阵的第pivotPerm[i]行
+
+void pivotInit(int n, Matrix<float> &a)
+{
+    pivotRows.resize(n);
+    colAbs.resize(n);
+    pivotPerm.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        pivotRows[i] = a[i];
+        colAbs[i] = fabs(a[i][0]);
+    }
+}
+
+//在colAbs[k,n)中找最大值所在的行，以16个元素为一块用SIMD求块内最大值，只在比当前最大值大的块内逐个查找
+int pivotArgmax(int n, int k)
+{
+    int p = k;
+    float m = colAbs[k];
+    int i = k + 1;
+    for (; i + 16 <= n; i += 16)
+    {
+        if (simdMax(colAbs.data(), i, i + 16) > m)
         {
-            float32x4_t vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
-            for (j = k + 1; j + 4 <= n; j += 4)
+            for (int t = i; t < i + 16; t++)
             {
-                float32x4_t va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-                va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-                vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
+                if (colAbs[t] > m)
+                {
+                    m = colAbs[t];
+                    p = t;
+                }
             }
-            offset = (n - k - 1) % 4;
-            for (j = n - offset; j < n; j++)
+        }
+    }
+    for (; i < n; i++)
+    {
+        if (colAbs[i] > m)
+        {
+            m = colAbs[i];
+            p = i;
+        }
+    }
+    return p;
+}
+
+//把第p行换到第k行
+void pivotSwap(int k, int p)
+{
+    float *t = pivotRows[k];
+    pivotRows[k] = pivotRows[p];
+    pivotRows[p] = t;
+    float c = colAbs[k];
+    colAbs[k] = colAbs[p];
+    colAbs[p] = c;
+}
+
+//消去结束后按行指针把行放回原位，每行只搬移一次
+void pivotFinish(int n, Matrix<float> &a)
+{
+    vector<bool> placed(n, false);
+    vector<float> tmp(n);
+    for (int i = 0; i < n; i++)
+    {
+        pivotPerm[i] = (pivotRows[i] - a[0]) / a.stride();
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (placed[i] || pivotPerm[i] == i)
+            continue;
+        //沿置换环移动：第j行的数据来自第pivotPerm[j]行
+        for (int j = 0; j < n; j++)
+            tmp[j] = a[i][j];
+        int j = i;
+        while (pivotPerm[j] != i)
+        {
+            for (int t = 0; t < n; t++)
+                a[j][t] = a[pivotPerm[j]][t];
+            placed[j] = true;
+            j = pivotPerm[j];
+        }
+        for (int t = 0; t < n; t++)
+            a[j][t] = tmp[t];
+        placed[j] = true;
+    }
+}
+
+//部分选主元的串行高斯消去
+void gaussEliminationPivot(int n, Matrix<float> &a)
+{
+    pivotInit(n, a);
+    for (int k = 0; k < n; k++)
+    {
+        pivotSwap(k, pivotArgmax(n, k));
+        float *rk = pivotRows[k];
+        for (int j = k + 1; j < n; j++)
+        {
+            rk[j] /= rk[k];
+        }
+        rk[k] = 1.0;
+
+        for (int i = k + 1; i < n; i++)
+        {
+            float *ri = pivotRows[i];
+            float rik = ri[k];
+            for (int j = k + 1; j < n; j++)
             {
-                a[k][j] /= a[k][k]; // 未处理的元素
+                ri[j] -= rik * rk[j];
             }
-            a[k][k] = 1.0;
+            ri[k] = 0;
+            colAbs[i] = fabs(ri[k + 1]); //下一步的主元列
         }
-        
-        #pragma omp for schedule(dynamic,1)
+    }
+    pivotFinish(n, a);
+}
+
+//部分选主元的SIMD高斯消去
+void gaussEliminationSIMDPivot(int n, Matrix<float> &a)
+{
+    pivotInit(n, a);
+    for (int k = 0; k < n; k++)
+    {
+        pivotSwap(k, pivotArgmax(n, k));
+        float *rk = pivotRows[k];
+        simdDivide(rk, k + 1, n, rk[k]); // a[k][j] /= a[k][k]
+        rk[k] = 1.0;
+
+        simdUpdateRows(pivotRows.data() + k + 1, n - k - 1, rk, k, n); // a[i][j] -= a[i][k] * a[k][j]，a[i][k] = 0
+        for (int i = k + 1; i < n; i++)
+        {
+            colAbs[i] = fabs(pivotRows[i][k + 1]); //下一步的主元列
+        }
+    }
+    pivotFinish(n, a);
+}
+
+//===部分选主元的静态线程消去======================================================================================================================
+
+//静态线程函数，线程0选主元、交换行指针并做除法
+void *staticThreadFunc_Pivot(void *param)
+{
+    threadParam_t *p = (threadParam_t *)param;
+    int threadID = p->threadID; //获取线程ID
+    int n = p->n;               //获取矩阵规模
+
+    for (int k = 0; k < n; k++)
+    {
+        if (threadID == 0)
+        {
+            pivotSwap(k, pivotArgmax(n, k));
+            float *rk = pivotRows[k];
+            for (int j = k + 1; j < n; j++)
+            {
+                rk[j] /= rk[k];
+            }
+            rk[k] = 1.0;
+        }
+
+        pool->barrier(threadID);
+
+        float *rk = pivotRows[k];
+        for (int i = k + threadID + 1; i < n; i += numThreads)
+        {
+            float *ri = pivotRows[i];
+            float rik = ri[k];
+            for (int j = k + 1; j < n; j++)
+            {
+                ri[j] -= rik * rk[j];
+            }
+            ri[k] = 0;
+            colAbs[i] = fabs(ri[k + 1]);
+        }
+
+        pool->barrier(threadID);
+    }
+    return NULL;
+}
+
+//部分选主元的静态线程高斯消去
+void gaussEliminationStaticPivot(int n, Matrix<float> &a)
+{
+    pivotInit(n, a);
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
+    {
+        threadParam[threadID].threadID = threadID;
+        threadParam[threadID].n = n;
+        threadParam[threadID].a = (void *)&a;
+    }
+
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc_Pivot, threadParam.data());
+
+    pivotFinish(n, a);
+}
+
+//===部分选主元的OpenMP高斯消去======================================================================================================================
+void gaussEliminationOpenMPPivot(int n, Matrix<float> &a)
+{
+    int i, j, k;
+    pivotInit(n, a);
+#pragma omp parallel num_threads(numThreads) default(none) private(i, j, k) shared(a, n, pivotRows, colAbs)
+    for (k = 0; k < n; k++)
+    {
+#pragma omp single
+        {
+            pivotSwap(k, pivotArgmax(n, k));
+            for (j = k + 1; j < n; j++)
+            {
+                pivotRows[k][j] /= pivotRows[k][k];
+            }
+            pivotRows[k][k] = 1.0;
+        }
+
+#pragma omp for
         for (i = k + 1; i < n; i++)
         {
-            float32x4_t vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            for (j = k + 1; j + 4 <= n; j += 4)
+            float *ri = pivotRows[i];
+            float *rk = pivotRows[k];
+            float rik = ri[k];
+            for (j = k + 1; j < n; j++)
             {
-                float32x4_t vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                float32x4_t vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                float32x4_t vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
+                ri[j] -= rik * rk[j];
             }
-            for (j = n - offset; j < n; j++)
+            ri[k] = 0;
+            colAbs[i] = fabs(ri[k + 1]);
+        }
+    }
+    pivotFinish(n, a);
+}
+
+//===一次分解、多次求解======================================================================================================================
+//上面的消去把a[i][k]置0，乘数丢掉了，每解一个方程组都要重做O(n^3)的消去
+//../common/lu.h的LU分解保留乘数L和行置换，只做一次；之后每个右端向量只需O(n^2)的前代和回代
+//右端向量按列存放：b的第i行是所有右端向量的第i个元素，SIMD沿右端向量方向，线程按列块划分，线程之间不需要同步
+
+//对a做LU分解，再一批求解RHS_BATCH个右端向量，返回求解用时，factorTime为分解用时
+double luSolveTime(int n, Matrix<float> &a, double &factorTime)
+{
+    using namespace std::chrono;
+    int ldb = Matrix<float>::strideOf(RHS_BATCH); // b的行首按缓存行对齐
+    vector<float> b((size_t)n * ldb);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < RHS_BATCH; j++)
+        {
+            b[(size_t)i * ldb + j] = rand() / float(RAND_MAX);
+        }
+    }
+    vector<int> perm;
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    if (!luFactor(n, a, perm))
+    {
+        cout << "singular matrix" << endl;
+    }
+    high_resolution_clock::time_point factored = high_resolution_clock::now();
+    luSolve(*pool, n, a, perm, b.data(), ldb, RHS_BATCH);
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+    factorTime = duration_cast<duration<double>>(factored - start).count();
+    return duration_cast<duration<double>>(end - factored).count();
+}
+
+//===批量小矩阵消去======================================================================================================================
+//n很小时一行只够一两个向量，按行向量化大多是尾部处理；../common/batch.h把SIMD_BATCH个矩阵交错存放，
+//每个向量的各个通道分属不同矩阵，一次消去SIMD_BATCH个矩阵，矩阵组在线程池的线程间平均分配
+
+//BATCH_COUNT个BATCH_N阶矩阵的消去用时：soa为false时逐个矩阵按行SIMD消去（单线程），为true时交错存放后在线程池上批量消去
+double batchTime(bool soa)
+{
+    using namespace std::chrono;
+    int n = BATCH_N;
+    size_t size = (size_t)n * n;
+    vector<float> matrices(size * BATCH_COUNT);
+    for (int m = 0; m < BATCH_COUNT; m++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
             {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
+                matrices[m * size + i * n + j] = rand() / float(RAND_MAX) + (i == j ? n : 0); //对角占优，不需要选主元
             }
-            a[i][k] = 0;
         }
     }
+    vector<float> groups(soa ? batchFloats(n, BATCH_COUNT) : 0);
+    if (soa)
+    {
+        batchPack(n, BATCH_COUNT, matrices.data(), groups.data()); //交错存放不计入计时
+    }
+    high_resolution_clock::time_point start = high_resolution_clock::now();
+    if (soa)
+    {
+        batchEliminate(*pool, n, BATCH_COUNT, groups.data());
+    }
+    else
+    {
+        for (int m = 0; m < BATCH_COUNT; m++)
+        {
+            float *a = &matrices[m * size];
+            for (int k = 0; k < n; k++)
+            {
+                simdDivide(a + k * n, k + 1, n, a[k * n + k]);
+                a[k * n + k] = 1.0;
+                for (int i = k + 1; i < n; i++)
+                {
+                    simdEliminate(a + i * n, a + k * n, k + 1, n, a[i * n + k]);
+                    a[i * n + k] = 0;
+                }
+            }
+        }
+    }
+    high_resolution_clock::time_point end = high_resolution_clock::now();
+    return duration_cast<duration<double>>(end - start).count();
 }
 
 //===计时函数======================================================================================================================
-double getTime(int n, float a[][MAX_N], int mode)
+double getTime(int n, Matrix<float> &a, int mode)
 {
     using namespace std::chrono;
     high_resolution_clock::time_point start = high_resolution_clock::now();
@@ -793,6 +1371,33 @@ double getTime(int n, float a[][MAX_N], int mode)
     case OMP_DYNAMIC_NEON_FUNC:
         gaussElimination_OpenMP_NEON_Dynamic(n, a);
         break;
+    case OMP_TASK_FUNC:
+        gaussEliminationOpenMPTask(n, a);
+        break;
+    case BLOCK_FUNC:
+        gaussEliminationBlock(n, a);
+        break;
+    case OMP_BLOCK_FUNC:
+        gaussEliminationOpenMPBlock(n, a);
+        break;
+    case PIVOT_FUNC:
+        gaussEliminationPivot(n, a);
+        break;
+    case SIMD_PIVOT_FUNC:
+        gaussEliminationSIMDPivot(n, a);
+        break;
+    case STATIC_PIVOT_FUNC:
+        gaussEliminationStaticPivot(n, a);
+        break;
+    case OMP_PIVOT_FUNC:
+        gaussEliminationOpenMPPivot(n, a);
+        break;
+    case DATAFLOW_FUNC:
+        gaussEliminationDataflow(n, a);
+        break;
+    case OMP_DATAFLOW_FUNC:
+        gaussEliminationOpenMPDataflow(n, a);
+        break;
     default:
         break;
     }
@@ -801,13 +1406,86 @@ double getTime(int n, float a[][MAX_N], int mode)
     return time_span.count();
 }
 
+//===自动调优======================================================================================================================
+//哪种方式、几个线程、多大的调度块最快取决于n和机器，原先靠表格手工挑选。这里对给定的n逐一测量候选配置，
+//最快的按CPU型号和n记入调优文件（格式见../common/tuning.h），之后同一型号的机器直接查表执行。
+//搜索过程（三轮缩小、与串行结果比较）在tuning.h的tuningSearch中，这里只给出各方式用不用线程和调度块
+
+const char *funcName[FUNC_NUM] = {"Serial", "Dynamic", "Static", "Column1", "Column2", "SIMD", "SIMD & Pthread",
+                                  "OpenMP", "OpenMPs", "OpenMPd", "SIMD & OpenMPs", "SIMD & OpenMPd", "Block",
+                                  "Block & OpenMP", "Pivot", "Pivot & SIMD", "Pivot & Pthread", "Pivot & OpenMP",
+                                  "Dataflow", "Dataflow & OMP", "OpenMP tasks"};
+
+//是否使用多个线程
+bool tuneThreaded(int mode)
+{
+    return mode != SERIAL_FUNC && mode != SIMD_FUNC && mode != BLOCK_FUNC && mode != PIVOT_FUNC &&
+           mode != SIMD_PIVOT_FUNC;
+}
+
+//是否使用ompChunk
+bool tuneChunked(int mode)
+{
+    return mode == DYNAMIC_FUNC || mode == OMP_LOOP_FUNC || mode == OMP_DYNAMIC_FUNC || mode == OMP_LOOP_NEON_FUNC ||
+           mode == OMP_DYNAMIC_NEON_FUNC;
+}
+
+//按配置设置线程数和调度块
+void tuneApply(const TuningEntry &config)
+{
+    setThreads(config.threads);
+    ompChunk = config.chunk;
+}
+
+//对规模n测量全部方式（../common/tuning.h的tuningSearch），最快的记入best；全部出错时best为串行，返回false
+bool autotune(int n, Matrix<float> &a, Matrix<float> &a_bac, TuningEntry &best)
+{
+    vector<TuningMode> modes;
+    for (int mode = 0; mode < FUNC_NUM; mode++)
+        modes.push_back({mode, funcName[mode], tuneThreaded(mode), tuneChunked(mode)});
+    auto run = [n](const TuningEntry &config, Matrix<float> &m) {
+        tuneApply(config);
+        return getTime(n, m, config.mode);
+    };
+    return tuningSearch(n, modes, SERIAL_FUNC, OMP_CHUNK, run, a, a_bac, best);
+}
+
 //===主函数======================================================================================================================
-int main()
+// ./test [n] [矩阵文件] [调优文件]，n缺省为DEFAULT_N；给出的二进制矩阵文件（格式见matrixFile.h）不存在时随机生成并写入，
+// 矩阵文件为"-"时不读写；给出调优文件时只执行其中本机型号和n的最快配置，没有记录时先自动调优并记入
+int main(int argc, char *argv[])
 {
-    int n = 1024;
-    m_reset(n, A);
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_N;
+    bool useFile = argc > 2 && string(argv[2]) != "-";
+    Matrix<float> A(n);     //在堆区申请矩阵
+    Matrix<float> A_BAC(n); //矩阵的备份
+    if (!useFile || !matrixFileLoad(argv[2], A[0], n, A.stride()))
+    {
+        m_reset(n, A);
+        if (useFile)
+            matrixFileSave(argv[2], A[0], n, A.stride());
+    }
     matrixDeepCopy(n, A_BAC, A);
 
+    if (argc > 3)
+    {
+        cout << "ISA:            " << simdIsa() << endl;
+        TuningEntry best;
+        if (!tuningLoad(argv[3], tuningCpuModel(), n, best))
+        {
+            cout << "Tuning " << tuningCpuModel() << ", n = " << n << endl;
+            if (autotune(n, A, A_BAC, best) && !tuningSave(argv[3], best))
+                cout << "cannot write " << argv[3] << endl;
+            matrixDeepCopy(n, A, A_BAC);
+        }
+        tuneApply(best);
+        cout << "Tuned:          " << funcName[best.mode] << ", " << best.threads << " threads, chunk " << best.chunk
+             << endl;
+        cout << "Time:           " << getTime(n, A, best.mode) << endl;
+        return 0;
+    }
+
+    cout << "ISA:            " << simdIsa() << endl; //同时完成指令集选择，不计入计时
     cout << "Serial:         " << getTime(n, A, SERIAL_FUNC) << endl;
     // printMatrix(n, A);
 
@@ -820,18 +1498,54 @@ int main()
     // printMatrix(n, A);
 
     matrixDeepCopy(n, A, A_BAC);
-    cout << "NEON:           " << getTime(n, A, SIMD_FUNC) << endl;
+    cout << "SIMD:           " << getTime(n, A, SIMD_FUNC) << endl;
     // printMatrix(n, A);
 
     matrixDeepCopy(n, A, A_BAC);
-    cout << "NEON & Pthread: " << getTime(n, A, STATIC_FUNC_SIMD) << endl;
+    cout << "SIMD & Pthread: " << getTime(n, A, STATIC_FUNC_SIMD) << endl;
     // printMatrix(n, A);
 
     matrixDeepCopy(n, A, A_BAC);
-    cout << "NEON & OpenMPs: " << getTime(n, A, OMP_LOOP_NEON_FUNC) << endl;
+    cout << "SIMD & OpenMPs: " << getTime(n, A, OMP_LOOP_NEON_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "SIMD & OpenMPd: " << getTime(n, A, OMP_DYNAMIC_NEON_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "OpenMP tasks:   " << getTime(n, A, OMP_TASK_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "Block:          " << getTime(n, A, BLOCK_FUNC) << endl;
 
     matrixDeepCopy(n, A, A_BAC);
-    cout << "NEON & OpenMPd: " << getTime(n, A, OMP_DYNAMIC_NEON_FUNC) << endl;
+    cout << "Block & OpenMP: " << getTime(n, A, OMP_BLOCK_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "Pivot:          " << getTime(n, A, PIVOT_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "Pivot & SIMD:   " << getTime(n, A, SIMD_PIVOT_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "Pivot & Pthread:" << getTime(n, A, STATIC_PIVOT_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "Pivot & OpenMP: " << getTime(n, A, OMP_PIVOT_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "Dataflow:       " << getTime(n, A, DATAFLOW_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    cout << "Dataflow & OMP: " << getTime(n, A, OMP_DATAFLOW_FUNC) << endl;
+
+    matrixDeepCopy(n, A, A_BAC);
+    double factorTime;
+    double solveTime = luSolveTime(n, A, factorTime);
+    cout << "LU factor:      " << factorTime << endl;
+    cout << "LU solve x" << RHS_BATCH << ": " << solveTime << " (" << solveTime / RHS_BATCH << " per RHS)" << endl;
+
+    cout << "Batch rows:     " << batchTime(false) << endl;
+    cout << "Batch SoA:      " << batchTime(true) << endl;
 
     return 0;
 }
\ No newline at end of file
@@ -5,16 +5,18 @@
 #include <math.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "../common/matrix.h"
+#include "../common/rowScheduler.h"
+#include "../common/matrixGen.h"
 using namespace std;
 
 #define THREAD_NUM 8 //线程数
-#define MAX_N 640    //系数矩阵最大规模
 
 void *dynamicThreadFunc(void *parm); //动态线程函数声明
 void *staticThreadFunc(void *parm);  //静态线程函数声明
 
 //矩阵深拷贝:a拷贝给b，以相同矩阵进行运算以测量不同策略下的运算时间
-void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
+void matrixDeepCopy(int n, Matrix<float> &b, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -26,29 +28,14 @@ void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
 }
 
 //初始化矩阵
-void m_reset(int n, float a[][MAX_N])
+void m_reset(int n, Matrix<float> &a)
 {
-    srand((unsigned)time(0));
-    //初始化上三角矩阵,元素取值范围为[-1,1]之间的随机数
-    for (int i = 0; i < n; i++)
-    {
-        int t = pow(-1, rand() % 2 + 1);
-        a[i][i] = t * rand() / float(RAND_MAX);
-    }
-    //随机选择两行进行线性相加，重复2n次
-    for (int i = 0; i < 2 * n; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    //按种子逐行生成（见../common/matrixGen.h），同一种子每次运行得到同一个矩阵
+    matrixGenRows(matrixSeed(), n, 0, n, a[0], a.stride());
 }
 
 //打印矩阵
-void printMatrix(int n, float a[][MAX_N])
+void printMatrix(int n, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -62,7 +49,7 @@ void printMatrix(int n, float a[][MAX_N])
 }
 
 //串行高斯消去
-void gaussEliminationSerial(int n, float a[][MAX_N])
+void gaussEliminationSerial(int n, Matrix<float> &a)
 {
     for (int k = 0; k < n; k++)
     {
@@ -91,22 +78,20 @@ typedef struct
     void *a;      //矩阵
 } threadParam_t;
 
-//声明互斥量
-pthread_mutex_t mutex_dynamic;
-//声明barrier
+//每步一个原子计数器，线程用fetch_add认领一块行，不加锁
+RowScheduler dynamicRows;
+//定义barrier
 pthread_barrier_t barrier_division_dynamic;
 pthread_barrier_t barrier_elimination_dynamic;
-//定义动态线程消去的行
-int dynamic_row = 1;
 
-//动态线程函数
+//动态线程消去函数
 void *dynamicThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
-    int i = 1;                                             //每个线程的任务行,首先初始化为1
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
+    int begin, end;                                         //认领到的任务行[begin, end)
 
     for (int k = 0; k < n; k++)
     {
@@ -119,38 +104,23 @@ void *dynamicThreadFunc(void *param)
             }
             a[k][k] = 1.0;
         }
-        cout<<"From Thread :"<<threadID<<endl;
-        //做完除法，所有线程同步
+
+        //所有线程同步
         pthread_barrier_wait(&barrier_division_dynamic);
-        cout<<"done first step!"<<endl;
 
-        //所有线程从row中取值，并递增，需要用互斥量保护
-        while (true)
+        //所有线程从第k步的计数器认领一块行，计数器只属于第k步，不需要重置
+        while (dynamicRows.claim(k, k + 1, n, begin, end))
         {
-            //有保护地获取当前任务行
-            pthread_mutex_lock(&mutex_dynamic);
-            i = dynamic_row;
-            cout<<"From Thread :"<<threadID<<" i = "<<i<<endl;
-            dynamic_row++;
-            if(i>=n) 
+            for (int i = begin; i < end; i++)
             {
-                //下一次k取k+1，要从k+2开始消去
-                dynamic_row = k+2;
-                i = k+2;
-                pthread_mutex_unlock(&mutex_dynamic);
-                sched_yield();
-                break;
-            }
-            sched_yield();
-            pthread_mutex_unlock(&mutex_dynamic);
-            //执行消去
-            for (int j = k + 1; j < n; j++)
-            {
-                a[i][j] -= a[i][k] * a[k][j];
+                for (int j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
             }
-            a[i][k] = 0;
-            i++;
         }
+
         //做完消去，所有线程同步
         pthread_barrier_wait(&barrier_elimination_dynamic);
     }
@@ -158,15 +128,13 @@ void *dynamicThreadFunc(void *param)
 }
 
 //动态线程高斯消去
-void gaussEliminationDynamic(int n, float a[][MAX_N])
+void gaussEliminationDynamic(int n, Matrix<float> &a)
 {
-    //初始化barrier
+    //清零n步的计数器，初始化barrier
+    dynamicRows.start(n, THREAD_NUM);
     pthread_barrier_init(&barrier_division_dynamic, NULL, THREAD_NUM);
     pthread_barrier_init(&barrier_elimination_dynamic, NULL, THREAD_NUM);
 
-    //初始化互斥量
-    pthread_mutex_init(&mutex_dynamic, NULL);
-
     //创建线程
     pthread_t handle[THREAD_NUM];          //线程句柄
     threadParam_t threadParam[THREAD_NUM]; //线程参数
@@ -174,7 +142,7 @@ void gaussEliminationDynamic(int n, float a[][MAX_N])
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
+        threadParam[threadID].a = (void *)&a;
     }
     for (int threadID = 0; threadID < THREAD_NUM; threadID++)
     {
@@ -190,8 +158,6 @@ void gaussEliminationDynamic(int n, float a[][MAX_N])
     //销毁barrier
     pthread_barrier_destroy(&barrier_division_dynamic);
     pthread_barrier_destroy(&barrier_elimination_dynamic);
-    //销毁互斥量
-    pthread_mutex_destroy(&mutex_dynamic);
 }
 
 //定义barrier
@@ -202,9 +168,9 @@ pthread_barrier_t barrier_elimination_static;
 void *staticThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
@@ -238,7 +204,7 @@ void *staticThreadFunc(void *param)
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic(int n, float a[][MAX_N])
+void gaussEliminationStatic(int n, Matrix<float> &a)
 {
     //初始化barrier
     pthread_barrier_init(&barrier_division_static, NULL, THREAD_NUM);
@@ -251,7 +217,7 @@ void gaussEliminationStatic(int n, float a[][MAX_N])
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
+        threadParam[threadID].a = (void *)&a;
     }
     for (int threadID = 0; threadID < THREAD_NUM; threadID++)
     {
@@ -269,12 +235,12 @@ void gaussEliminationStatic(int n, float a[][MAX_N])
     pthread_barrier_destroy(&barrier_elimination_static);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    int n = 10; //系数矩阵规模
-    float a[n][MAX_N] = {0};
-    float b[n][MAX_N] = {0};
-    float c[n][MAX_N] = {0};
+    int n = argc > 1 ? atoi(argv[1]) : 10; //系数矩阵规模，可由命令行给出
+    Matrix<float> a(n);                    //矩阵在堆区按n申请，见matrix.h
+    Matrix<float> b(n);
+    Matrix<float> c(n);
     m_reset(n, a);
     matrixDeepCopy(n, b, a);
     matrixDeepCopy(n, c, a);
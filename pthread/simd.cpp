@@ -1,17 +1,39 @@
 #include <iostream>
-#include <arm_neon.h>
 #include <stdlib.h>
 #include <chrono>
 #include <ratio>
 #include <math.h>
 #include <pthread.h>
 #include <unistd.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include "../code/common/simd.h"
+#include "../code/common/threadPool.h"
+#include "../code/common/matrix.h"
+#include "../code/common/matrixGen.h"
+#include "../code/common/rowScheduler.h"
+#include "../code/common/tuning.h"
 using namespace std;
 
-//===线程数定义和稀疏矩阵最大规模定义以及函数指针声明======================================================================================================================
+//===线程数定义以及函数指针声明======================================================================================================================
 
-#define THREAD_NUM 4 //线程数
-#define MAX_N 520    //系数矩阵最大规模
+#define THREAD_NUM 4 //缺省线程数
+#define CHUNK 1      //缺省的动态认领最小行数
+int numThreads = THREAD_NUM;                   //线程数，自动调优时改变
+int chunkRows = CHUNK;                         //动态线程每次至少认领的行数，自动调优时改变
+ThreadPool *pool = new ThreadPool(THREAD_NUM); //线程池，线程数不变时所有pthread消去共用
+
+//改变线程数，线程池按新的线程数重建
+void setThreads(int threads)
+{
+    numThreads = threads;
+    if (pool->size() != threads)
+    {
+        delete pool;
+        pool = new ThreadPool(threads);
+    }
+}
 
 #define SERIAL_FUNC 0
 #define DYNAMIC_FUNC 1
@@ -20,6 +42,7 @@ using namespace std;
 #define STATIC_FUNC_COLUMN_MODE2 4
 #define SIMD_FUNC 5
 #define STATIC_FUNC_SIMD 6
+#define FUNC_NUM 7 //执行方式的个数
 
 void *dynamicThreadFunc(void *parm);               //动态线程函数声明
 void *staticThreadFunc(void *parm);                //静态线程函数声明，消去按行划分
@@ -27,12 +50,12 @@ void *staticThreadFunc_onColumn_mode1(void *parm); //静态线程函数声明：
 void *staticThreadFunc_onColumn_mode2(void *parm); //静态线程函数声明：按列划分的第二种方式：连续式
 void *staticThreadFunc_SIMD(void *parm);           //静态线程函数声明：SIMD版本
 
-//===线程数定义和稀疏矩阵最大规模定义以及函数指针声明======================================================================================================================
+//===线程数定义以及函数指针声明======================================================================================================================
 
 //===有关矩阵的函数操作======================================================================================================================
 
 //矩阵深拷贝:a拷贝给b，以相同矩阵进行运算以测量不同策略下的运算时间
-void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
+void matrixDeepCopy(int n, Matrix<float> &b, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -44,29 +67,14 @@ void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
 }
 
 //初始化矩阵
-void m_reset(int n, float a[][MAX_N])
+void m_reset(int n, Matrix<float> &a)
 {
-    srand((unsigned)time(0));
-    //初始化上三角矩阵,元素取值范围为[-1,1]之间的随机数
-    for (int i = 0; i < n; i++)
-    {
-        int t = pow(-1, rand() % 2 + 1);
-        a[i][i] = t * rand() / float(RAND_MAX);
-    }
-    //随机选择两行进行线性相加，重复n^2次
-    for (int i = 0; i < n * n; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    //按种子逐行生成（见../code/common/matrixGen.h），同一种子每次运行得到同一个矩阵
+    matrixGenRows(matrixSeed(), n, 0, n, a[0], a.stride());
 }
 
 //打印矩阵
-void printMatrix(int n, float a[][MAX_N])
+void printMatrix(int n, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -84,7 +92,7 @@ void printMatrix(int n, float a[][MAX_N])
 //===串行高斯消去算法======================================================================================================================
 
 //串行高斯消去
-void gaussEliminationSerial(int n, float a[][MAX_N])
+void gaussEliminationSerial(int n, Matrix<float> &a)
 {
     for (int k = 0; k < n; k++)
     {
@@ -121,22 +129,17 @@ typedef struct
 
 //===按行划分的动态线程消去======================================================================================================================
 
-//声明互斥量
-pthread_mutex_t mutex_dynamic;
-//声明barrier
-pthread_barrier_t barrier_division_dynamic;
-pthread_barrier_t barrier_elimination_dynamic;
-//定义动态线程消去的行
-int dynamic_row = 1;
+//每步一个原子计数器，线程用fetch_add认领一块行，不加锁
+RowScheduler dynamicRows;
 
 //动态线程函数
 void *dynamicThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
-    int i = 1;                                             //每个线程的任务行,首先初始化为1
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
+    int begin, end;                                         //认领到的任务行[begin, end)
 
     for (int k = 0; k < n; k++)
     {
@@ -149,96 +152,58 @@ void *dynamicThreadFunc(void *param)
             }
             a[k][k] = 1.0;
         }
-        // cout << "From Thread :" << threadID << endl;
         //做完除法，所有线程同步
-        pthread_barrier_wait(&barrier_division_dynamic);
-        // cout << "done first step!" << endl;
+        pool->barrier(threadID);
 
-        //所有线程从row中取值，并递增，需要用互斥量保护
-        while (true)
+        //所有线程从第k步的计数器认领一块行，计数器只属于第k步，不需要重置
+        while (dynamicRows.claim(k, k + 1, n, begin, end))
         {
-            //有保护地获取当前任务行
-            pthread_mutex_lock(&mutex_dynamic);
-            i = dynamic_row;
-            // cout << "From Thread :" << threadID << " i = " << i << endl;
-            dynamic_row++;
-            if (i >= n)
-            {
-                //下一次k取k+1，要从k+2开始消去
-                dynamic_row = k + 2;
-                i = k + 2;
-                pthread_mutex_unlock(&mutex_dynamic);
-                sched_yield();
-                break;
-            }
-            sched_yield();
-            pthread_mutex_unlock(&mutex_dynamic);
             //执行消去
-            for (int j = k + 1; j < n; j++)
+            for (int i = begin; i < end; i++)
             {
-                a[i][j] -= a[i][k] * a[k][j];
+                for (int j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
             }
-            a[i][k] = 0;
-            i++;
         }
         //做完消去，所有线程同步
-        pthread_barrier_wait(&barrier_elimination_dynamic);
+        pool->barrier(threadID);
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //动态线程高斯消去
-void gaussEliminationDynamic(int n, float a[][MAX_N])
+void gaussEliminationDynamic(int n, Matrix<float> &a)
 {
-    //初始化barrier
-    pthread_barrier_init(&barrier_division_dynamic, NULL, THREAD_NUM);
-    pthread_barrier_init(&barrier_elimination_dynamic, NULL, THREAD_NUM);
-
-    //初始化互斥量
-    pthread_mutex_init(&mutex_dynamic, NULL);
+    //清零n步的计数器
+    dynamicRows.start(n, numThreads, chunkRows);
 
-    //创建线程
-    pthread_t handle[THREAD_NUM];          //线程句柄
-    threadParam_t threadParam[THREAD_NUM]; //线程参数
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, dynamicThreadFunc, &threadParam[threadID]);
-    }
-
-    //等待线程结束
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    //销毁barrier
-    pthread_barrier_destroy(&barrier_division_dynamic);
-    pthread_barrier_destroy(&barrier_elimination_dynamic);
-    //销毁互斥量
-    pthread_mutex_destroy(&mutex_dynamic);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(dynamicThreadFunc, threadParam.data());
 }
 
 //===按行划分的动态线程消去======================================================================================================================
 
 //===按行划分的静态线程消去======================================================================================================================
 
-//定义barrier
-pthread_barrier_t barrier_division_static;
-pthread_barrier_t barrier_elimination_static;
-
 //静态线程函数
 void *staticThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
@@ -253,10 +218,10 @@ void *staticThreadFunc(void *param)
         }
 
         //所有线程同步
-        pthread_barrier_wait(&barrier_division_static);
+        pool->barrier(threadID);
 
         //以线程数为步长，划分任务
-        for (int i = k + threadID + 1; i < n; i += THREAD_NUM)
+        for (int i = k + threadID + 1; i < n; i += numThreads)
         {
             for (int j = k + 1; j < n; j++)
             {
@@ -266,142 +231,102 @@ void *staticThreadFunc(void *param)
         }
 
         //做完消去，所有线程同步
-        pthread_barrier_wait(&barrier_elimination_static);
+        pool->barrier(threadID);
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic(int n, float a[][MAX_N])
+void gaussEliminationStatic(int n, Matrix<float> &a)
 {
-    //初始化barrier
-    pthread_barrier_init(&barrier_division_static, NULL, THREAD_NUM);
-    pthread_barrier_init(&barrier_elimination_static, NULL, THREAD_NUM);
-
-    //创建线程
-    pthread_t handle[THREAD_NUM];          //线程句柄
-    threadParam_t threadParam[THREAD_NUM]; //线程参数
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc, &threadParam[threadID]);
-    }
-
-    //等待线程结束
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    //销毁barrier
-    pthread_barrier_destroy(&barrier_division_static);
-    pthread_barrier_destroy(&barrier_elimination_static);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc, threadParam.data());
 }
 
 //===按行划分的静态线程消去======================================================================================================================
 
 //===按列划分（跳跃式）的静态线程消去======================================================================================================================
 
-//定义barrier
-pthread_barrier_t barrier_division_static_onColumn_mode1;
-pthread_barrier_t barrier_elimination_static_onColumn_mode1;
-
 //静态线程函数,实现除法和消去均按列跳跃划分
 void *staticThreadFunc_onColumn_mode1(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
         //计算当前线程需要做除法的任务区间
         int division_start = threadID + k + 1;
-        for (int j = division_start; j < n; j += THREAD_NUM)
+        for (int j = division_start; j < n; j += numThreads)
         {
             a[k][j] /= a[k][k];
         }
 
         //所有线程同步
-        pthread_barrier_wait(&barrier_division_static_onColumn_mode1);
+        pool->barrier(threadID);
 
         //以线程数为步长，划分任务
         a[k][k] = 1.0;
         for (int i = k + 1; i < n; i++)
         {
             int elimination_start = threadID + k + 1;
-            for (int j = elimination_start; j < n; j += THREAD_NUM)
+            for (int j = elimination_start; j < n; j += numThreads)
             {
                 a[i][j] -= a[i][k] * a[k][j];
             }
             //做完消去，所有线程同步
-            pthread_barrier_wait(&barrier_elimination_static_onColumn_mode1);
+            pool->barrier(threadID);
             a[i][k] = 0;
         }
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic_onColumn_mode1(int n, float a[][MAX_N])
+void gaussEliminationStatic_onColumn_mode1(int n, Matrix<float> &a)
 {
-    //初始化barrier
-    pthread_barrier_init(&barrier_division_static_onColumn_mode1, NULL, THREAD_NUM);
-    pthread_barrier_init(&barrier_elimination_static_onColumn_mode1, NULL, THREAD_NUM);
-
-    //创建线程
-    pthread_t handle[THREAD_NUM];          //线程句柄
-    threadParam_t threadParam[THREAD_NUM]; //线程参数
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc_onColumn_mode1, &threadParam[threadID]);
-    }
-
-    //等待线程结束
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    //销毁barrier
-    pthread_barrier_destroy(&barrier_division_static_onColumn_mode1);
-    pthread_barrier_destroy(&barrier_elimination_static_onColumn_mode1);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc_onColumn_mode1, threadParam.data());
 }
 
 //===按列划分（跳跃式）的静态线程消去======================================================================================================================
 
 //===按列划分（连续式）的静态线程消去======================================================================================================================
 
-//定义barrier
-pthread_barrier_t barrier_division_static_onColumn_mode2;
-pthread_barrier_t barrier_elimination_static_onColumn_mode2;
-
 //静态线程函数,实现除法和消去均按列连续划分
 void *staticThreadFunc_onColumn_mode2(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
         //计算当前线程需要做除法的任务区间
         int amount_d = n - k - 1;                                                                      //需要做除法的总任务量
-        int extraTask_d = amount_d % THREAD_NUM;                                                       //额外的任务量
-        int h_d = amount_d / THREAD_NUM;                                                               //步长
+        int extraTask_d = amount_d % numThreads;                                                       //额外的任务量
+        int h_d = amount_d / numThreads;                                                               //步长
         int my_start_d = threadID * h_d + k + 1 + ((threadID < extraTask_d) ? threadID : extraTask_d); //当前线程的开始位置
         int my_end_d = my_start_d + h_d + ((threadID < extraTask_d) ? 1 : 0);                          //当前线程的结束位置
         // cout << "From Thead =" << threadID << " and k = " << k << " : " << my_start_d << " to " << my_end_d << endl;
@@ -411,15 +336,15 @@ void *staticThreadFunc_onColumn_mode2(void *param)
         }
 
         //所有线程同步
-        pthread_barrier_wait(&barrier_division_static_onColumn_mode2);
+        pool->barrier(threadID);
 
         //以线程数为步长，划分任务
         a[k][k] = 1.0;
         for (int i = k + 1; i < n; i++)
         {
             int amount_e = n - k - 1;                                                                      //需要做除法的总任务量
-            int extraTask_e = amount_e % THREAD_NUM;                                                       //额外的任务量
-            int h_e = amount_e / THREAD_NUM;                                                               //步长
+            int extraTask_e = amount_e % numThreads;                                                       //额外的任务量
+            int h_e = amount_e / numThreads;                                                               //步长
             int my_start_e = threadID * h_e + k + 1 + ((threadID < extraTask_e) ? threadID : extraTask_e); //当前线程的开始位置
             int my_end_e = my_start_e + h_e + ((threadID < extraTask_e) ? 1 : 0);                          //当前线程的结束位置
             for (int j = my_start_e; j < my_end_e && j < n; j++)
@@ -427,95 +352,46 @@ void *staticThreadFunc_onColumn_mode2(void *param)
                 a[i][j] -= a[i][k] * a[k][j];
             }
             //做完消去，所有线程同步
-            pthread_barrier_wait(&barrier_elimination_static_onColumn_mode2);
+            pool->barrier(threadID);
             a[i][k] = 0;
         }
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic_onColumn_mode2(int n, float a[][MAX_N])
+void gaussEliminationStatic_onColumn_mode2(int n, Matrix<float> &a)
 {
-    //初始化barrier
-    pthread_barrier_init(&barrier_division_static_onColumn_mode2, NULL, THREAD_NUM);
-    pthread_barrier_init(&barrier_elimination_static_onColumn_mode2, NULL, THREAD_NUM);
-
-    //创建线程
-    pthread_t handle[THREAD_NUM];          //线程句柄
-    threadParam_t threadParam[THREAD_NUM]; //线程参数
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc_onColumn_mode2, &threadParam[threadID]);
-    }
-
-    //等待线程结束
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    //销毁barrier
-    pthread_barrier_destroy(&barrier_division_static_onColumn_mode2);
-    pthread_barrier_destroy(&barrier_elimination_static_onColumn_mode2);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc_onColumn_mode2, threadParam.data());
 }
 
 //===按列划分（连续式）的静态线程消去======================================================================================================================
 
 //===SIMD并行化高斯消去算法======================================================================================================================
 
-// SIMD化的高斯消去
-void gaussEliminationSIMD(int n, float a[][MAX_N])
+// SIMD化的高斯消去，除法和消去交给../code/common/simd.h，运行时选择指令集
+//消去用多行微内核，每趟做第k、k+1两步，各行每趟只读写一次
+void gaussEliminationSIMD(int n, Matrix<float> &a)
 {
-    float32x4_t vt;   // 保存a[k][k]
-    float32x4_t va;   // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaik; // 保存a[i][k]
-    float32x4_t vakj; // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaij; // 保存a[i][j]~a[i][j+3]
-    float32x4_t vx;   // 保存(a[k][j]~a[k][j+3])*a[i][k]的值
-
-    int k;
-    int i;
-    int j;
-    int offset;
-    for (k = 0; k < n; k++)
+    float *const *rowPtr = a.rows(); //行指针，交给多行微内核
+    for (int k = 0; k + 1 < n; k += 2)
     {
-        vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
-        for (j = k + 1; j + 4 <= n; j += 4)
-        {
-            va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-            va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-            vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
-        }
-        offset = (n - k - 1) % 4;
-        for (j = n - offset; j < n; j++)
-        {
-            a[k][j] /= a[k][k]; // 未处理的元素
-        }
-        a[k][k] = 1.0;
-        for (i = k + 1; i < n; i++)
-        {
-            vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            for (j = k + 1; j + 4 <= n; j += 4)
-            {
-                vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
-            }
-            for (j = n - offset; j < n; j++)
-            {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
-            }
-            a[i][k] = 0;
-        }
+        simdDividePair(a[k], a[k + 1], k, n);                             //第k、k+1行做除法，a[k+1]先减去a[k]
+        simdUpdateRows2(rowPtr + k + 2, n - k - 2, a[k], a[k + 1], k, n); //其余行一趟消去第k、k+1列
+    }
+    if (n % 2 == 1)
+    {
+        a[n - 1][n - 1] = 1.0; //剩下最后一行，其后没有要做除法和消去的元素
     }
 }
 
@@ -523,111 +399,64 @@ void gaussEliminationSIMD(int n, float a[][MAX_N])
 
 //===SIMD、Pthread并行化高斯消去算法======================================================================================================================
 
-//定义barrier
-pthread_barrier_t barrier_division_static_SIMD;
-pthread_barrier_t barrier_elimination_static_SIMD;
-
 // SIMD与Pthread结合的线程函数
 void *staticThreadFunc_SIMD(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
-    int offset;                                            //处理剩下元素
-
-    float32x4_t vt;   // 保存a[k][k]
-    float32x4_t va;   // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaik; // 保存a[i][k]
-    float32x4_t vakj; // 保存a[k][j]~a[k][j+3]
-    float32x4_t vaij; // 保存a[i][j]~a[i][j+3]
-    float32x4_t vx;   // 保存(a[k][j]~a[k][j+3])*a[i][k]的值
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
+    vector<float *> myRows(n / numThreads + 1);             //本线程负责的行，交给多行微内核
 
-    for (int k = 0; k < n; k++)
+    //每趟做第k、k+1两步
+    for (int k = 0; k + 1 < n; k += 2)
     {
         if (threadID == 0)
         {
-            vt = vld1q_dup_f32(a[k] + k); // 将a[k][k]存到vt的四个通道里
-            for (int j = k + 1; j + 4 <= n; j += 4)
-            {
-                va = vld1q_f32(a[k] + j); // 把a[k][j]~a[k][j+3]存到va的四个通道里
-                va = vdivq_f32(va, vt);   // a[k][j] /= a[k][k]
-                vst1q_f32(a[k] + j, va);  // 把运算结果写回到内存中
-            }
-            offset = (n - k - 1) % 4;
-            for (int j = n - offset; j < n; j++)
-            {
-                a[k][j] /= a[k][k]; // 未处理的元素
-            }
-            a[k][k] = 1.0;
+            simdDividePair(a[k], a[k + 1], k, n); //第k、k+1行做除法，a[k+1]先减去a[k]
         }
 
         //所有线程同步
-        pthread_barrier_wait(&barrier_division_static_SIMD);
+        pool->barrier(threadID);
 
         //以线程数为步长，划分任务
-        for (int i = k + 1 + threadID; i < n; i += THREAD_NUM)
+        int count = 0;
+        for (int i = k + 2 + threadID; i < n; i += numThreads)
         {
-            vaik = vld1q_f32(a[i] + k); // 将a[i][k]存到vaik的四个通道里
-            for (int j = k + 1; j + 4 <= n; j += 4)
-            {
-                vakj = vld1q_f32(a[k] + j); // 保存a[k][j]~a[k][j+3]
-                vaij = vld1q_f32(a[i] + j); // 保存a[i][j]~a[i][j+3]
-                vx = vmulq_f32(vakj, vaik); // 保存(a[k][j]~a[k][j+3])*a[i][k]
-                vaij = vsubq_f32(vaij, vx); // 保存(a[i][j]~a[i][j+3])-(a[k][j]~a[k][j+3])*a[i][k]
-                vst1q_f32(a[i] + j, vaij);  // 将a[i][j]~a[i][j+3]写回到内存中
-            }
-            offset = (n - k - 1) % 4;
-            for (int j = n - offset; j < n; j++)
-            {
-                a[i][j] -= a[k][j] * a[i][k]; // 未处理的元素
-            }
-            a[i][k] = 0;
+            myRows[count++] = a[i];
         }
+        simdUpdateRows2(myRows.data(), count, a[k], a[k + 1], k, n); //一趟消去第k、k+1列
 
         //做完消去，所有线程同步
-        pthread_barrier_wait(&barrier_elimination_static_SIMD);
+        pool->barrier(threadID);
+    }
+    if (threadID == 0 && n % 2 == 1)
+    {
+        a[n - 1][n - 1] = 1.0; //剩下最后一行，其后没有要做除法和消去的元素
     }
-    pthread_exit(NULL);
+    return NULL;
 }
 
 // SIMD化的高斯消去
-void gaussEliminationSIMD_Pthread(int n, float a[][MAX_N])
+void gaussEliminationSIMD_Pthread(int n, Matrix<float> &a)
 {
-    //初始化barrier
-    pthread_barrier_init(&barrier_division_static_SIMD, NULL, THREAD_NUM);
-    pthread_barrier_init(&barrier_elimination_static_SIMD, NULL, THREAD_NUM);
-
-    //创建线程
-    pthread_t handle[THREAD_NUM];          //线程句柄
-    threadParam_t threadParam[THREAD_NUM]; //线程参数
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
+    //传递参数
+    vector<threadParam_t> threadParam(numThreads); //线程参数
+    for (int threadID = 0; threadID < numThreads; threadID++)
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
-    }
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_create(&handle[threadID], NULL, staticThreadFunc_SIMD, &threadParam[threadID]);
+        threadParam[threadID].a = (void *)&a;
     }
 
-    //等待线程结束
-    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-    {
-        pthread_join(handle[threadID], NULL);
-    }
-
-    //销毁barrier
-    pthread_barrier_destroy(&barrier_division_static_SIMD);
-    pthread_barrier_destroy(&barrier_elimination_static_SIMD);
+    //在线程池上运行，返回时所有线程都已做完
+    pool->run(staticThreadFunc_SIMD, threadParam.data());
 }
 
 //===SIMD、Pthread并行化高斯消去算法======================================================================================================================
 
-
 //===计时函数======================================================================================================================
-void getTime(int n, float a[][MAX_N], int mode, double &duration1)
+void getTime(int n, Matrix<float> &a, int mode, double &duration1)
 {
     using namespace std::chrono;
     high_resolution_clock::time_point start = high_resolution_clock::now();
@@ -665,10 +494,76 @@ void getTime(int n, float a[][MAX_N], int mode, double &duration1)
 
 //===计时函数======================================================================================================================
 
+//===自动调优======================================================================================================================
+//与../code/openmp/OpenMP.cpp相同：对给定的n用tuning.h的tuningSearch测量候选配置，最快的按CPU型号和n记入调优文件。
+//动态线程的调度块是认领的最小行数
+
+const char *funcName[FUNC_NUM] = {"Serial", "Dynamic", "Static", "Column1", "Column2", "SIMD", "SIMD & Pthread"};
+
+//是否使用多个线程
+bool tuneThreaded(int mode)
+{
+    return mode != SERIAL_FUNC && mode != SIMD_FUNC;
+}
+
+//是否使用chunkRows
+bool tuneChunked(int mode)
+{
+    return mode == DYNAMIC_FUNC;
+}
+
+//按配置设置线程数和认领行数
+void tuneApply(const TuningEntry &config)
+{
+    setThreads(config.threads);
+    chunkRows = config.chunk;
+}
+
+//对规模n测量全部方式（../common/tuning.h的tuningSearch），最快的记入best；全部出错时best为串行，返回false
+bool autotune(int n, Matrix<float> &a, Matrix<float> &a_bac, TuningEntry &best)
+{
+    vector<TuningMode> modes;
+    for (int mode = 0; mode < FUNC_NUM; mode++)
+        modes.push_back({mode, funcName[mode], tuneThreaded(mode), tuneChunked(mode)});
+    auto run = [n](const TuningEntry &config, Matrix<float> &m) {
+        tuneApply(config);
+        double t = 0;
+        getTime(n, m, config.mode, t);
+        return t;
+    };
+    return tuningSearch(n, modes, SERIAL_FUNC, CHUNK, run, a, a_bac, best);
+}
+
+//===自动调优======================================================================================================================
+
 //===主函数======================================================================================================================
 
-int main()
+// ./simd：对各个规模测量全部方式；./simd n 调优文件：只执行调优文件中本机型号和n的最快配置，没有记录时先自动调优并记入
+int main(int argc, char *argv[])
 {
+    if (argc > 2)
+    {
+        int n = atoi(argv[1]);
+        Matrix<float> a(n), a_bac(n); //矩阵和它的备份
+        m_reset(n, a);
+        matrixDeepCopy(n, a_bac, a);
+        cout << "ISA:     " << simdIsa() << endl;
+        TuningEntry best;
+        if (!tuningLoad(argv[2], tuningCpuModel(), n, best))
+        {
+            cout << "Tuning " << tuningCpuModel() << ", n = " << n << endl;
+            if (autotune(n, a, a_bac, best) && !tuningSave(argv[2], best))
+                cout << "cannot write " << argv[2] << endl;
+            matrixDeepCopy(n, a, a_bac);
+        }
+        tuneApply(best);
+        double t = 0;
+        getTime(n, a, best.mode, t);
+        cout << "Tuned:   " << funcName[best.mode] << ", " << best.threads << " threads, chunk " << best.chunk << endl;
+        cout << "Time:    " << t << endl;
+        return 0;
+    }
+
     double duration1[7] = {0.0}; //持续时长
     int times = 20;              //重复测20次
     // int n = 512;                 //系数矩阵规模
@@ -676,13 +571,7 @@ int main()
     for (int i = 0; i < 8; i++)
     {
         int n = size[i];
-        float a[n][MAX_N] = {0};
-        float b[n][MAX_N] = {0};
-        float c[n][MAX_N] = {0};
-        float d[n][MAX_N] = {0};
-        float e[n][MAX_N] = {0};
-        float f[n][MAX_N] = {0};
-        float g[n][MAX_N] = {0};
+        Matrix<float> a(n), b(n), c(n), d(n), e(n), f(n), g(n); //矩阵在堆区按n申请，见matrix.h
 
         int cnt = times;
         while (cnt--)
@@ -712,7 +601,7 @@ int main()
         cout << "Static mode1: " << duration1[3] / times * 1000 << endl;
         cout << "Static mode2: " << duration1[4] / times * 1000 << endl;
         cout << "SIMD:         " << duration1[5] / times * 1000 << endl;
-        cout << "SIMD_Pthread: " << duration1[6] / times * 1000 << "      end"endl;
+        cout << "SIMD_Pthread: " << duration1[6] / times * 1000 << "      end" << endl;
     }
 
     // gaussEliminationSerial(n, a);
@@ -5,16 +5,18 @@
 #include <math.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "../code/common/matrix.h"
+#include "../code/common/matrixGen.h"
+#include "../code/common/rowScheduler.h"
 using namespace std;
 
 #define THREAD_NUM 4 //线程数
-#define MAX_N 640    //系数矩阵最大规模
 
 void *dynamicThreadFunc(void *parm); //动态线程函数声明
 void *staticThreadFunc(void *parm);  //静态线程函数声明
 
 //矩阵深拷贝:a拷贝给b，以相同矩阵进行运算以测量不同策略下的运算时间
-void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
+void matrixDeepCopy(int n, Matrix<float> &b, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -26,29 +28,14 @@ void matrixDeepCopy(int n, float b[][MAX_N], float a[][MAX_N])
 }
 
 //初始化矩阵
-void m_reset(int n, float a[][MAX_N])
+void m_reset(int n, Matrix<float> &a)
 {
-    srand((unsigned)time(0));
-    //初始化上三角矩阵,元素取值范围为[-1,1]之间的随机数
-    for (int i = 0; i < n; i++)
-    {
-        int t = pow(-1, rand() % 2 + 1);
-        a[i][i] = t * rand() / float(RAND_MAX);
-    }
-    //随机选择两行进行线性相加，重复2n次
-    for (int i = 0; i < 2 * n; i++)
-    {
-        int i1 = rand() % n;
-        int i2 = rand() % n;
-        for (int j = 0; j < n; j++)
-        {
-            a[i1][j] += a[i2][j];
-        }
-    }
+    //按种子逐行生成（见../code/common/matrixGen.h），同一种子每次运行得到同一个矩阵
+    matrixGenRows(matrixSeed(), n, 0, n, a[0], a.stride());
 }
 
 //打印矩阵
-void printMatrix(int n, float a[][MAX_N])
+void printMatrix(int n, Matrix<float> &a)
 {
     for (int i = 0; i < n; i++)
     {
@@ -62,7 +49,7 @@ void printMatrix(int n, float a[][MAX_N])
 }
 
 //串行高斯消去
-void gaussEliminationSerial(int n, float a[][MAX_N])
+void gaussEliminationSerial(int n, Matrix<float> &a)
 {
     for (int k = 0; k < n; k++)
     {
@@ -91,74 +78,62 @@ typedef struct
     void *a;      //矩阵
 } threadParam_t;
 
-//声明互斥量
-pthread_mutex_t mutex_dynamic;
-//声明条件变量
-pthread_cond_t cond_dynamic;
-//声明互斥量的属性
-pthread_mutexattr_t mutex_dynamic_attr;
-//定义动态线程消去的行
-int dynamic_row = 1;
-//定义线程的触发变量
-int count = -1;
-//定义当前消去的轮次
-int rank1 = 0;
+//每步一个原子计数器，线程用fetch_add认领一块行，不加锁
+RowScheduler dynamicRows;
+//定义barrier
+pthread_barrier_t barrier_division_dynamic;
+pthread_barrier_t barrier_elimination_dynamic;
 
 //动态线程消去函数
 void *dynamicThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
-    int i;                                                 //每个线程的任务行
-    int k;                                                 //消去的轮次
-    pthread_mutex_lock(&mutex_dynamic);                    //动态线程消去时，动态线程需要加锁
-    while (count > 0)
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
+    int begin, end;                                         //认领到的任务行[begin, end)
+
+    for (int k = 0; k < n; k++)
     {
-        pthread_cond_wait(&cond_dynamic, &mutex_dynamic); //等待条件变量
-        cout<<"Thread "<<threadID<<" woken"<<endl;
-        count--;
-        cout<<"dynamic_row:"<<dynamic_row<<endl;
-        cout<<"rank1:"<<rank1<<endl;
-        if (dynamic_row >= n)
+        //线程0做除法，其他线程等待
+        if (threadID == 0)
         {
-            //表示当前执行所有消去完毕
-            if (rank1 >= n)
+            for (int j = k + 1; j < n; j++)
             {
-                pthread_mutex_unlock(&mutex_dynamic); //解锁
-                pthread_exit(NULL);
-                return NULL;
+                a[k][j] /= a[k][k];
             }
-            //否则轮数和下一次开始消去的行递增
-            rank1++;
-            dynamic_row = rank1 + 1;
-        }
-        else
-        {
-            dynamic_row++;
+            a[k][k] = 1.0;
         }
-        i = dynamic_row; //设定当前的任务行
-        //执行消去
-        for (int j = rank1 + 1; j < n; j++)
+
+        //所有线程同步
+        pthread_barrier_wait(&barrier_division_dynamic);
+
+        //所有线程从第k步的计数器认领一块行，计数器只属于第k步，不需要重置
+        while (dynamicRows.claim(k, k + 1, n, begin, end))
         {
-            a[i][j] -= a[i][rank1] * a[rank1][j];
+            for (int i = begin; i < end; i++)
+            {
+                for (int j = k + 1; j < n; j++)
+                {
+                    a[i][j] -= a[i][k] * a[k][j];
+                }
+                a[i][k] = 0;
+            }
         }
-        a[i][rank1] = 0;
-        pthread_mutex_unlock(&mutex_dynamic); //解锁
+
+        //做完消去，所有线程同步
+        pthread_barrier_wait(&barrier_elimination_dynamic);
     }
+    pthread_exit(NULL);
 }
 
 //动态线程高斯消去
-void gaussEliminationDynamic(int n, float a[][MAX_N])
+void gaussEliminationDynamic(int n, Matrix<float> &a)
 {
-    //初始化互斥量并设定它的属性
-    pthread_mutexattr_init(&mutex_dynamic_attr);
-    pthread_mutexattr_setrobust(&mutex_dynamic_attr, PTHREAD_MUTEX_ROBUST);
-    pthread_mutex_init(&mutex_dynamic, &mutex_dynamic_attr);
-
-    //初始化条件变量
-    pthread_cond_init(&cond_dynamic, NULL);
+    //清零n步的计数器，初始化barrier
+    dynamicRows.start(n, THREAD_NUM);
+    pthread_barrier_init(&barrier_division_dynamic, NULL, THREAD_NUM);
+    pthread_barrier_init(&barrier_elimination_dynamic, NULL, THREAD_NUM);
 
     //创建线程
     pthread_t handle[THREAD_NUM];          //线程句柄
@@ -167,44 +142,22 @@ void gaussEliminationDynamic(int n, float a[][MAX_N])
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
+        threadParam[threadID].a = (void *)&a;
     }
     for (int threadID = 0; threadID < THREAD_NUM; threadID++)
     {
         pthread_create(&handle[threadID], NULL, dynamicThreadFunc, &threadParam[threadID]);
     }
 
-    while (true)
+    //等待线程结束
+    for (int threadID = 0; threadID < THREAD_NUM; threadID++)
     {
-        pthread_mutex_lock(&mutex_dynamic); //动态线程消去时，动态线程需要加锁
-        if (rank1 >= n)
-        {
-            //回收所有创建的线程并返回
-            for (int threadID = 0; threadID < THREAD_NUM; threadID++)
-            {
-                pthread_join(handle[threadID], NULL);
-            }
-            pthread_mutex_unlock(&mutex_dynamic);
-            //销毁互斥量
-            pthread_mutex_destroy(&mutex_dynamic);
-            //销毁条件变量
-            pthread_cond_destroy(&cond_dynamic);
-            //销毁互斥量属性
-            pthread_mutexattr_destroy(&mutex_dynamic_attr);
-            return;
-        }
-        for (int j = rank1 + 1; j < n; j++)
-        {
-            a[rank1][j] /= a[rank1][rank1];
-        }
-        a[rank1][rank1] = 1.0;
-        count++;
-        pthread_cond_signal(&cond_dynamic);   //唤醒消去线程
-        pthread_mutex_unlock(&mutex_dynamic); //解锁
-        cout << "here" << endl;
-        cout << "rank" << rank1 << endl;
-        cout<<"count:"<<count<<endl;
+        pthread_join(handle[threadID], NULL);
     }
+
+    //销毁barrier
+    pthread_barrier_destroy(&barrier_division_dynamic);
+    pthread_barrier_destroy(&barrier_elimination_dynamic);
 }
 
 //定义barrier
@@ -215,9 +168,9 @@ pthread_barrier_t barrier_elimination_static;
 void *staticThreadFunc(void *param)
 {
     threadParam_t *p = (threadParam_t *)param;
-    int threadID = p->threadID;                            //获取线程ID
-    int n = p->n;                                          //获取矩阵规模
-    float(*a)[MAX_N] = static_cast<float(*)[MAX_N]>(p->a); //获取矩阵
+    int threadID = p->threadID;                             //获取线程ID
+    int n = p->n;                                           //获取矩阵规模
+    Matrix<float> &a = *static_cast<Matrix<float> *>(p->a); //获取矩阵
 
     for (int k = 0; k < n; k++)
     {
@@ -251,7 +204,7 @@ void *staticThreadFunc(void *param)
 }
 
 //静态线程高斯消去
-void gaussEliminationStatic(int n, float a[][MAX_N])
+void gaussEliminationStatic(int n, Matrix<float> &a)
 {
     //初始化barrier
     pthread_barrier_init(&barrier_division_static, NULL, THREAD_NUM);
@@ -264,7 +217,7 @@ void gaussEliminationStatic(int n, float a[][MAX_N])
     {
         threadParam[threadID].threadID = threadID;
         threadParam[threadID].n = n;
-        threadParam[threadID].a = (void *)a;
+        threadParam[threadID].a = (void *)&a;
     }
     for (int threadID = 0; threadID < THREAD_NUM; threadID++)
     {
@@ -282,12 +235,12 @@ void gaussEliminationStatic(int n, float a[][MAX_N])
     pthread_barrier_destroy(&barrier_elimination_static);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    int n = 10; //系数矩阵规模
-    float a[n][MAX_N] = {0};
-    float b[n][MAX_N] = {0};
-    float c[n][MAX_N] = {0};
+    int n = argc > 1 ? atoi(argv[1]) : 10; //系数矩阵规模，可由命令行给出
+    Matrix<float> a(n);                    //矩阵在堆区按n申请，见matrix.h
+    Matrix<float> b(n);
+    Matrix<float> c(n);
     m_reset(n, a);
     matrixDeepCopy(n, b, a);
     matrixDeepCopy(n, c, a);